@@ -0,0 +1,117 @@
+/* Memory benchmark: Control Blocks with interned names (symbolTable.hpp) vs the same held as strings
+ *
+ * A synthetic SCD file (bench/synthetic_scd.hpp) is parsed whole (parse_sed_stream()). The heap in use
+ * (mallinfo2()) is measured once the parse is done, with only the Control Blocks left: that is their
+ * memory, names of the symbol table included. The same Control Blocks are then copied with every
+ * name, address, APPID and FCDA as a std::string (the layout before interning), and measured again.
+ * Finally, the per-message checks of a subscription are timed both ways: Control Block type and
+ * APPID compared as integers, or as strings converted on each message.
+ *
+ * Usage:
+ *     make bench && build/bench/config_memory [IEDs (default 10000)]
+ */
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <malloc.h>
+#include <string>
+#include <vector>
+
+#include "parse_sed.hpp"
+#include "bench/synthetic_scd.hpp"
+
+// A Control Block with every field as a string
+struct StringControlBlock
+{
+    std::string              hostIED{};
+    std::string              cbType{};
+    std::string              multicastIP{};
+    std::string              appID{};
+    std::string              vlanID{};
+    std::string              cbName{};
+    std::string              datSetName{};
+    unsigned int             minTime{0};
+    unsigned int             maxTime{0};
+    std::vector<std::string> datSetVector{};
+    std::vector<std::string> subscribingIEDs{};
+};
+
+size_t heap_in_use()
+{
+    malloc_trim(0);
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t numIEDs = (argc > 1) ? std::stoul(argv[1]) : 10000;
+    const std::string filename = "/tmp/config_memory.scd";
+    write_scd(filename, numIEDs);
+
+    const size_t before = heap_in_use();
+    std::streambuf *cout_buf = std::cout.rdbuf(nullptr);    // Parsing prints its progress
+    std::vector<ControlBlock> vector_of_ctrl_blks = parse_sed_stream(filename.c_str());
+    std::cout.rdbuf(cout_buf);
+    const size_t interned = heap_in_use() - before;
+
+    size_t numFCDAs{0};
+    std::vector<StringControlBlock> strings{};
+    {
+        const size_t before_strings = heap_in_use();
+        strings.reserve(vector_of_ctrl_blks.size());
+        for (const ControlBlock &cb : vector_of_ctrl_blks)
+        {
+            StringControlBlock copy{cb.hostIED.str(), cb_type_name(cb.cbType), ipv4_string(cb.multicastIP),
+                                    appid_string(cb.appID), cb.vlanID.str(), cb.cbName.str(), cb.datSetName.str(),
+                                    cb.minTime, cb.maxTime, {}, {}};
+            for (const Fcda &item : cb.datSetVector)
+                copy.datSetVector.push_back(item.str());
+            for (Symbol item : cb.subscribingIEDs)
+                copy.subscribingIEDs.push_back(item.str());
+            numFCDAs += cb.datSetVector.size();
+            strings.push_back(std::move(copy));
+        }
+        const size_t as_strings = heap_in_use() - before_strings;
+
+        std::cout << numIEDs << " IEDs, " << vector_of_ctrl_blks.size() << " Control Blocks, " << numFCDAs << " FCDAs, "
+                  << scl_symbols().size() << " distinct names (" << std::fixed << std::setprecision(2)
+                  << scl_symbols().bytes() / 1e6 << " MB in the symbol table)\n"
+                  << std::setw(12) << "layout" << std::setw(12) << "MB" << std::setw(14) << "bytes/CB" << '\n'
+                  << std::setw(12) << "strings" << std::setw(12) << as_strings / 1e6
+                  << std::setw(14) << std::setprecision(0) << double(as_strings) / vector_of_ctrl_blks.size() << '\n'
+                  << std::setw(12) << "interned" << std::setw(12) << std::setprecision(2) << interned / 1e6
+                  << std::setw(14) << std::setprecision(0) << double(interned) / vector_of_ctrl_blks.size() << '\n';
+    }
+
+    // Checks of every message against its subscription (type, then APPID of the message)
+    const size_t rounds = 200;
+    unsigned long long matches_int{0}, matches_str{0};
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        for (const ControlBlock &cb : vector_of_ctrl_blks)
+        {
+            const uint16_t received = static_cast<uint16_t>(r);
+            matches_int += (cb.cbType == CbType::GSE) && (received != cb.appID);
+        }
+    }
+    const double ns_int = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        for (const StringControlBlock &cb : strings)
+        {
+            const unsigned long received = r;
+            matches_str += (cb.cbType == "GSE") && (received != std::strtoul(cb.appID.c_str(), nullptr, 16));
+        }
+    }
+    const double ns_str = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    const double checks = double(rounds) * vector_of_ctrl_blks.size();
+    std::cout << "per-message checks: integers " << std::setprecision(2) << ns_int / checks << " ns, strings "
+              << ns_str / checks << " ns" << (matches_int == matches_str ? "" : " (results differ!)") << '\n';
+
+    std::remove(filename.c_str());
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/* Streams of messages for the decode benchmarks (bench/decode_throughput.cpp, bench/microbench.cpp)
+ * A stream is the consecutive messages of one R-GOOSE or R-SV Control Block, formed as ied_send does
+ * from GOOSEdata.txt/SVdata.txt; subscription_of() gives the Control Block that publishes and
+ * subscribes to it. Needs form_gse_smv.hpp.
+ */
+
+GooseSvData subscription_of(const std::string &cbType)
+{
+    GooseSvData cb{};
+    cb.cbType = cb_type(cbType);
+    cb.cbName = (cbType == "GSE") ? "BenchIED/LLN0$GO$Bench" : "BenchIED/LLN0$SV$Bench";
+    cb.datSetName = "BenchIED/LLN0$Bench";
+    cb.appID = (cbType == "GSE") ? 0x3000 : 0x4000;
+    cb.goose_counter = 1;
+    cb.sv_counter = 1;
+    return cb;
+}
+
+// length consecutive messages of one Control Block, as published by ied_send
+std::vector<std::vector<unsigned char>> form_stream(const std::string &cbType, size_t length)
+{
+    GooseSvData cb = subscription_of(cbType);
+    std::vector<std::vector<unsigned char>> stream(length);
+    std::streambuf *cout_buf = std::cout.rdbuf(nullptr);    // Data files are echoed for every message
+    for (std::vector<unsigned char> &message : stream)
+        form_udp_data(cb, message);
+    std::cout.rdbuf(cout_buf);
+    return stream;
+}
+
+// Same messages with 1 to 3 random bytes changed (nearly all rejected, at various depths)
+std::vector<std::vector<unsigned char>> mutate_stream(std::vector<std::vector<unsigned char>> stream)
+{
+    std::mt19937 rng{2024};
+    for (std::vector<unsigned char> &message : stream)
+    {
+        for (unsigned int i = 0, n = 1 + rng() % 3; i < n; i++)
+            message[rng() % message.size()] = static_cast<unsigned char>(rng());
+    }
+    return stream;
+}
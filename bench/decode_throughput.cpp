@@ -0,0 +1,121 @@
+/* Decoder throughput benchmark: valid_GSE_SMV() on valid and on malformed messages
+ *
+ * A stream of R-GOOSE and a stream of R-SV messages are formed as ied_send does, then decoded
+ * in order against their subscription, over and over (the subscription is reset between passes,
+ * so every message is accepted). Malformed messages (random mutations of the valid ones) are
+ * decoded as well: rejecting them must not cost more than accepting valid ones.
+ * Decoder errors go to std::cerr, which is muted for the measurement.
+ *
+ * Reported per case: ns per message, millions of messages per second, MB/s, messages accepted
+ *
+ * Usage (from the repository root, GOOSEdata.txt/SVdata.txt are read to form the messages):
+ *     make bench && build/bench/decode_throughput [decoded messages per case (default 10000000)]
+ */
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <climits>
+
+// For ControlBlock (used by ied_utils.hpp)
+#include "parse_sed.hpp"
+// For the types of the DataSets and the encoding/decoding of typed allData
+#include "scl_types.hpp"
+#include "datasetPlan.hpp"
+
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ied_utils.hpp"
+
+#define MAXBUFLEN 1024
+
+#include "decode_gse_smv.hpp"
+#include "form_gse_smv.hpp"
+#include "bench/decode_streams.hpp"
+
+#define STREAM_LEN 1000         // messages per stream (one pass)
+
+struct CaseResult
+{
+    std::string        name{};
+    unsigned long long decoded{0};
+    unsigned long long accepted{0};
+    unsigned long long bytes{0};
+    double             elapsed_s{0};
+};
+
+CaseResult run_case(const std::string &name, const std::vector<std::vector<unsigned char>> &stream,
+                    const GooseSvData &subscription, unsigned long long count)
+{
+    CaseResult result{};
+    result.name = name;
+
+    // Datagrams as received: copies in fixed-size receive buffers
+    std::vector<std::array<unsigned char, MAXBUFLEN>> bufs(stream.size());
+    for (size_t i = 0; i < stream.size(); i++)
+        std::memcpy(bufs[i].data(), stream[i].data(), stream[i].size());
+
+    GooseSvData cb = subscription;
+    auto start = std::chrono::steady_clock::now();
+    while (result.decoded < count)
+    {
+        cb.prev_spduNum = 0;
+        cb.prev_stNum_Value = 0;
+        cb.prev_sqNum_Value = 0;
+        cb.prev_smpCnt_Value = 0;
+        cb.prev_allData_Value.clear();
+        cb.counters = StreamCounters{};
+        for (size_t i = 0; i < stream.size(); i++)
+        {
+            if (valid_GSE_SMV(bufs[i].data(), static_cast<int>(stream[i].size()), cb))
+                result.accepted++;
+            result.bytes += stream[i].size();
+        }
+        result.decoded += stream.size();
+    }
+    result.elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long long count = (argc > 1) ? std::stoull(argv[1]) : 10'000'000;
+
+    std::vector<std::vector<unsigned char>> goose = form_stream("GSE", STREAM_LEN);
+    std::vector<std::vector<unsigned char>> sv = form_stream("SMV", STREAM_LEN);
+    std::cout << "R-GOOSE message: " << goose[0].size() << " bytes, R-SV message: " << sv[0].size() << " bytes\n";
+
+    std::streambuf *cerr_buf = std::cerr.rdbuf(nullptr);
+    std::vector<CaseResult> results{};
+    results.push_back(run_case("GOOSE valid", goose, subscription_of("GSE"), count));
+    results.push_back(run_case("SV valid", sv, subscription_of("SMV"), count));
+    results.push_back(run_case("GOOSE malformed", mutate_stream(goose), subscription_of("GSE"), count));
+    results.push_back(run_case("SV malformed", mutate_stream(sv), subscription_of("SMV"), count));
+    std::cerr.rdbuf(cerr_buf);
+
+    std::cout << '\n' << std::left << std::setw(16) << "case" << std::right
+              << std::setw(10) << "ns/msg" << std::setw(10) << "Mmsg/s" << std::setw(10) << "MB/s"
+              << std::setw(12) << "accepted" << '\n';
+    for (const CaseResult &r : results)
+    {
+        std::cout << std::left << std::setw(16) << r.name << std::right
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(10) << r.elapsed_s * 1e9 / r.decoded
+                  << std::setw(10) << r.decoded / r.elapsed_s / 1e6
+                  << std::setw(10) << r.bytes / r.elapsed_s / 1e6
+                  << std::setw(12) << r.accepted << '\n';
+    }
+    return 0;
+}
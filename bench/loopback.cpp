@@ -0,0 +1,510 @@
+/* Loopback benchmark: publisher and subscriber in one process, throughput and latency
+ *
+ * A sender thread publishes N R-GOOSE or N R-SV streams (messages formed as ied_send does, then
+ * given the next SPDU Number, sqNum/smpCnt and UtcTime at each send) at a target aggregate rate.
+ * The receiver serves them from the EventLoop and dispatches each message as ied_recv does: to each
+ * subscription in turn, until valid_GSE_SMV() accepts it. Transport: multicast over the loopback
+ * interface (recvmmsg()), or an in-memory ring (bench/memory_transport.hpp) where no network is available.
+ *
+ * For each message type and stream count, the rate is doubled from 1000 packets/s until messages are
+ * lost (more than LOSS_LIMIT of those sent are not accepted) or the sender cannot keep up (reported
+ * as what limited the ramp: "loss", "sender", or "max_rate" once MAX_PPS is reached). Reported
+ * per step: packets sent, accepted, loss, accepted packets/s, CPU time per packet of the receiver
+ * (event loop thread: system calls + decoding) and of the sender, and percentiles of the latency
+ * from the UtcTime of the message to its decoding. The maximum sustainable rate is the largest
+ * accepted rate of a step without loss.
+ *
+ * The results are written to stdout as JSON (progress to stderr), with the dispatch ("scan": every
+ * subscription in turn), to be compared across commits and hosts:
+ * e.g. build/bench/loopback auto 0.5 64 $(git rev-parse --short HEAD) > loopback.json
+ *
+ * Usage (from the repository root, GOOSEdata.txt/SVdata.txt are read to form the messages):
+ *     make bench && build/bench/loopback [auto|udp|memory] [seconds per step (default 0.5)]
+ *                                        [max streams (default 64)] [label]
+ */
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <climits>
+
+// For ControlBlock (used by ied_utils.hpp)
+#include "parse_sed.hpp"
+// For the types of the DataSets and the encoding/decoding of typed allData
+#include "scl_types.hpp"
+#include "datasetPlan.hpp"
+
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/utsname.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+
+#include "udpSock.hpp"
+#include "zz_diagnose.hpp"
+#include "rxTimestamp.hpp"
+#include "mmsgRecv.hpp"
+#include "eventLoop.hpp"
+#include "latencyHistogram.hpp"
+#include "ied_utils.hpp"
+
+#define MAXBUFLEN 1024
+
+#include "decode_gse_smv.hpp"
+#include "form_gse_smv.hpp"
+#include "bench/measure.hpp"
+#include "bench/memory_transport.hpp"
+
+#define SEND_BATCH 32
+#define IDLE_CHECK_NS 50'000'000        // a step ends once the sender is done and nothing arrived for 50 ms
+#define MULTICAST_GROUP "239.255.0.102"
+#define START_PPS 1000.0
+#define MAX_PPS 20'000'000.0
+#define LOSS_LIMIT 0.001                // fraction of the packets sent, not accepted
+
+// A published stream: its message, and where its per-message fields are
+struct Stream
+{
+    std::vector<unsigned char> message{};
+    size_t                     seqOffset{0};    // GOOSE sqNum (4 bytes) or SV smpCnt (2 bytes)
+    size_t                     seqLen{0};
+    size_t                     timeOffset{0};   // GOOSE t or SV timestamp (UtcTime, 8 bytes)
+    unsigned int               spduNum{0};
+};
+
+// Sending side of the transport in use
+struct Link
+{
+    int              sd{-1};                    // UDP: sender socket, to dest
+    sockaddr_in      dest{};
+    MemoryTransport *memory{nullptr};           // or the in-memory ring
+};
+
+struct StepResult
+{
+    size_t             streams{0};
+    double             target_pps{0};
+    unsigned long long sent{0};                 // including the datagrams the transport refused
+    unsigned long long received{0};
+    unsigned long long accepted{0};
+    double             tx_elapsed_s{0};
+    double             rx_cpu_s{0};
+    double             tx_cpu_s{0};
+    std::unique_ptr<LatencyHistogram> latency{std::make_unique<LatencyHistogram>()};
+
+    double loss() const {
+      return sent ? 1.0 - static_cast<double>(accepted) / sent : 0.0;
+    }
+    double pps() const {
+      return (tx_elapsed_s > 0) ? accepted / tx_elapsed_s : 0.0;
+    }
+};
+
+// Finds the sequence field and the UtcTime of a message (in its GOOSE PDU, or its only SV ASDU)
+bool locate_fields(Stream &stream, bool goose)
+{
+    const unsigned char *buf = stream.message.data();
+    const size_t signature_idx = 28 + ((static_cast<size_t>(buf[28]) << 24) | (buf[29] << 16) | (buf[30] << 8) | buf[31]);
+    if (signature_idx > stream.message.size())
+        return false;
+    TlvReader pdu{buf + 38, buf + signature_idx};
+    TlvReader::Tlv f{};
+    if (goose ? !pdu.enter(0x61) : !(pdu.enter(0x60) && pdu.next(f) && pdu.enter(0xA2) && pdu.enter(0x30)))
+        return false;
+    while (pdu.next(f))
+    {
+        if (f.tag == (goose ? 0x86 : 0x82))
+        {
+            stream.seqOffset = static_cast<size_t>(f.value - buf);
+            stream.seqLen = f.len;
+        }
+        else if (f.tag == (goose ? 0x84 : 0x89) && f.len == 8)
+        {
+            stream.timeOffset = static_cast<size_t>(f.value - buf);
+        }
+    }
+    return stream.seqOffset && stream.timeOffset && stream.seqLen == (goose ? 4u : 2u);
+}
+
+GooseSvData subscription_of(bool goose, size_t i)
+{
+    GooseSvData cb{};
+    cb.cbType = goose ? CbType::GSE : CbType::SMV;
+    cb.cbName = std::string("BenchIED/LLN0$") + (goose ? "GO$Bench" : "SV$Bench") + std::to_string(i);
+    cb.datSetName = "BenchIED/LLN0$Bench";
+    cb.appID = static_cast<uint16_t>((goose ? 0x3000 : 0x4000) + i);
+    return cb;
+}
+
+/* Streams of a step, and their subscriptions. An R-GOOSE stream is formed with a 4-byte sqNum in a
+ * state (stNum 1) its subscription has already seen, so that every message is a retransmission.
+ */
+void form_streams(bool goose, size_t count, std::vector<Stream> &streams, std::vector<GooseSvData> &subscriptions)
+{
+    const std::vector<unsigned char> allData{0x83, 0x01, 0x01};
+    streams.assign(count, Stream{});
+    subscriptions.clear();
+    std::streambuf *cout_buf = std::cout.rdbuf(nullptr);    // Data files are echoed for every message
+    for (size_t i = 0; i < count; i++)
+    {
+        GooseSvData cb = subscription_of(goose, i);
+        cb.goose_counter = 1;
+        cb.sv_counter = 1;
+        GooseSvData subscription = subscription_of(goose, i);
+        if (goose)
+        {
+            form_udp_data(cb, streams[i].message, &allData);
+            streams[i].message.clear();
+            cb.prev_sqNum_Value = 0x00FFFFFF;
+            subscription.prev_stNum_Value = 1;
+            subscription.prev_allData_Value = allData;
+        }
+        form_udp_data(cb, streams[i].message, goose ? &allData : nullptr);
+        diagnose(locate_fields(streams[i], goose), "Locating the fields of message " + cb.cbName);
+        subscriptions.push_back(subscription);
+    }
+    std::cout.rdbuf(cout_buf);
+}
+
+// Publishes the streams round-robin at pps packets/s for duration_s seconds
+void publish(std::vector<Stream> &streams, const Link &link, double pps, double duration_s, StepResult &result)
+{
+    std::vector<std::array<unsigned char, MAXBUFLEN>> bufs(SEND_BATCH);
+    std::array<iovec, SEND_BATCH> iovs{};
+    std::array<mmsghdr, SEND_BATCH> msgs{};
+    for (int i = 0; i < SEND_BATCH; i++)
+    {
+        iovs[i].iov_base = bufs[i].data();
+        msgs[i].msg_hdr.msg_iov     = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen  = 1;
+        msgs[i].msg_hdr.msg_name    = const_cast<sockaddr_in*>(&link.dest);
+        msgs[i].msg_hdr.msg_namelen = sizeof(link.dest);
+    }
+
+    const unsigned long long total = static_cast<unsigned long long>(pps * duration_s);
+    const double cpu_start = clock_s(CLOCK_THREAD_CPUTIME_ID);
+    const double start = clock_s(CLOCK_MONOTONIC);
+    size_t next{0};
+    std::array<unsigned char, 8> time{};
+    while (result.sent < total)
+    {
+        // Packets due by now (pacing); the sender sleeps when it is ahead by more than 50 us, else yields
+        // (the receiver may be waiting for the same CPU)
+        const double elapsed = clock_s(CLOCK_MONOTONIC) - start;
+        const unsigned long long due = std::min<unsigned long long>(total, static_cast<unsigned long long>(elapsed * pps) + 1);
+        if (due <= result.sent)
+        {
+            const double ahead = (result.sent + 1) / pps - elapsed;
+            if (ahead > 50e-6)
+                std::this_thread::sleep_for(std::chrono::duration<double>(ahead - 20e-6));
+            else
+                std::this_thread::yield();
+            continue;
+        }
+
+        const unsigned int batch = static_cast<unsigned int>(std::min<unsigned long long>(SEND_BATCH, due - result.sent));
+        set_timestamp(time);
+        for (unsigned int i = 0; i < batch; i++, next = (next + 1) % streams.size())
+        {
+            Stream &stream = streams[next];
+            unsigned char *buf = bufs[i].data();
+            std::memcpy(buf, stream.message.data(), stream.message.size());
+            iovs[i].iov_len = stream.message.size();
+
+            stream.spduNum++;
+            buf[10] = (stream.spduNum >> 24) & 0xFF;
+            buf[11] = (stream.spduNum >> 16) & 0xFF;
+            buf[12] = (stream.spduNum >>  8) & 0xFF;
+            buf[13] = (stream.spduNum      ) & 0xFF;
+            const unsigned int value = (stream.seqLen == 4) ? 0x01000000 + stream.spduNum : stream.spduNum % 4000;
+            for (size_t b = 0; b < stream.seqLen; b++)
+                buf[stream.seqOffset + b] = (value >> (8 * (stream.seqLen - 1 - b))) & 0xFF;
+            std::memcpy(buf + stream.timeOffset, time.data(), time.size());
+        }
+
+        if (link.memory)
+        {
+            for (unsigned int i = 0; i < batch; i++)
+                link.memory->send(bufs[i].data(), iovs[i].iov_len);
+            link.memory->notify();
+        }
+        else
+        {
+            // Datagrams refused by the socket are counted as sent (and lost)
+            for (unsigned int done = 0; done < batch; )
+            {
+                const int n = sendmmsg(link.sd, msgs.data() + done, batch - done, 0);
+                if (n <= 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    break;
+                }
+                done += n;
+            }
+        }
+        result.sent += batch;
+    }
+    result.tx_elapsed_s = clock_s(CLOCK_MONOTONIC) - start;
+    result.tx_cpu_s = clock_s(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+}
+
+StepResult run_step(bool goose, size_t count, double pps, double duration_s, const Link &link,
+                    UdpSock *rxSock, MemoryTransport *memory)
+{
+    StepResult result{};
+    result.streams = count;
+    result.target_pps = pps;
+
+    std::vector<Stream> streams{};
+    std::vector<GooseSvData> subscriptions{};
+    form_streams(goose, count, streams, subscriptions);
+
+    EventLoop loop;
+    diagnose(loop.isGood(), "Creating event loop");
+
+    LatencyHistogram &latency = *result.latency;
+    auto process_datagram = [&](const unsigned char *buf, int numbytes)
+    {
+        result.received++;
+        for (GooseSvData &subscription : subscriptions)
+        {
+            DecodeResult decoded{};
+            if (valid_GSE_SMV(buf, numbytes, subscription, decoded))
+            {
+                result.accepted++;
+                latency.record(static_cast<int64_t>(realtime_ns() - decoded.t_ns));
+                break;
+            }
+        }
+    };
+
+    std::unique_ptr<MmsgRecv> mmsg{};
+    if (memory)
+    {
+        diagnose(loop.addFd((*memory)(), EPOLLIN, [&](uint32_t)
+        {
+            memory->drain(process_datagram);
+        }), "Registering in-memory transport");
+    }
+    else
+    {
+        mmsg = std::make_unique<MmsgRecv>((*rxSock)());
+        diagnose(loop.addFd((*rxSock)(), EPOLLIN, [&](uint32_t)
+        {
+            mmsg->drain([&](const unsigned char *buf, int numbytes, in_addr, uint64_t) { process_datagram(buf, numbytes); });
+        }), "Registering recvmmsg() receiver");
+    }
+
+    std::atomic<bool> sender_done{false};
+    unsigned long long received_at_check{0};
+    diagnose(loop.addTimer(IDLE_CHECK_NS, IDLE_CHECK_NS, [&](uint64_t)
+    {
+        if (sender_done && result.received == received_at_check)
+            loop.stop();
+        received_at_check = result.received;
+    }) >= 0, "Arming idle timer");
+
+    std::streambuf *cerr_buf = std::cerr.rdbuf(nullptr);    // Decoder errors of lost/late messages
+    const double cpu_start = clock_s(CLOCK_THREAD_CPUTIME_ID);
+    std::thread sender([&]()
+    {
+        publish(streams, link, pps, duration_s, result);
+        sender_done = true;
+    });
+    loop.run();
+    sender.join();
+    // The idle period at the end costs no CPU time (the thread sleeps in epoll_wait())
+    result.rx_cpu_s = clock_s(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+    std::cerr.rdbuf(cerr_buf);
+    return result;
+}
+
+/* Multicast over the loopback interface: receiver socket joined to MULTICAST_GROUP, sender socket
+ * looping its datagrams back. False if the host cannot (e.g. no multicast on lo): a probe datagram
+ * must arrive within 200 ms.
+ */
+bool open_udp(UdpSock &rx, UdpSock &tx, Link &link)
+{
+    if (!rx.isGood() || !tx.isGood())
+        return false;
+    int rcvbuf = 8 << 20;
+    if (setsockopt(rx(), SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) < 0)
+        setsockopt(rx(), SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    socklen_t addr_len{sizeof(addr)};
+    if (bind(rx(), (sockaddr*)&addr, sizeof(addr)) || getsockname(rx(), (sockaddr*)&addr, &addr_len))
+        return false;
+
+    ip_mreq group{};
+    group.imr_multiaddr.s_addr = inet_addr(MULTICAST_GROUP);
+    group.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+    in_addr loopback{};
+    loopback.s_addr = htonl(INADDR_LOOPBACK);
+    unsigned char loop{1}, ttl{1};
+    if (setsockopt(rx(), IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group)) < 0
+        || setsockopt(tx(), IPPROTO_IP, IP_MULTICAST_IF, &loopback, sizeof(loopback)) < 0
+        || setsockopt(tx(), IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) < 0
+        || setsockopt(tx(), IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0)
+        return false;
+
+    link.sd = tx();
+    link.dest.sin_family = AF_INET;
+    link.dest.sin_addr = group.imr_multiaddr;
+    link.dest.sin_port = addr.sin_port;
+
+    const char probe[] = "probe";
+    pollfd pfd{rx(), POLLIN, 0};
+    char buf[16];
+    if (sendto(tx(), probe, sizeof(probe), 0, (sockaddr*)&link.dest, sizeof(link.dest)) != sizeof(probe)
+        || poll(&pfd, 1, 200) != 1 || recv(rx(), buf, sizeof(buf), 0) != sizeof(probe))
+        return false;
+    return fcntl(rx(), F_SETFL, fcntl(rx(), F_GETFL) | O_NONBLOCK) >= 0;
+}
+
+// A string as a JSON string literal: quotes, backslashes and control characters escaped
+std::string json_string(std::string_view text)
+{
+    std::ostringstream out{};
+    out << '"';
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+        else
+            out << c;
+    }
+    out << '"';
+    return out.str();
+}
+
+void write_json_step(std::ostream &out, const StepResult &s)
+{
+    const LatencyHistogram &l = *s.latency;
+    out << "{\"streams\": " << s.streams << ", \"target_pps\": " << s.target_pps << ", \"sent\": " << s.sent
+        << ", \"received\": " << s.received << ", \"accepted\": " << s.accepted
+        << ", \"loss\": " << std::setprecision(6) << s.loss() << std::setprecision(1)
+        << ", \"pps\": " << s.pps()
+        << ", \"rx_cpu_ns_per_packet\": " << (s.received ? s.rx_cpu_s * 1e9 / s.received : 0.0)
+        << ", \"tx_cpu_ns_per_packet\": " << (s.sent ? s.tx_cpu_s * 1e9 / s.sent : 0.0)
+        << ", \"latency_ns\": {\"p50\": " << l.percentile(0.50) << ", \"p90\": " << l.percentile(0.90)
+        << ", \"p99\": " << l.percentile(0.99) << ", \"p999\": " << l.percentile(0.999) << ", \"max\": " << l.max() << "}}";
+}
+
+int main(int argc, char *argv[])
+{
+    const std::string mode = (argc > 1) ? argv[1] : "auto";
+    const double duration_s = (argc > 2) ? std::stod(argv[2]) : 0.5;
+    const size_t max_streams = (argc > 3) ? std::stoul(argv[3]) : 64;
+    const std::string label = (argc > 4) ? argv[4] : "";
+    // stdout is for the JSON document only: progress (and the output of diagnose()) goes to stderr
+    std::streambuf *json_out = std::cout.rdbuf(std::cerr.rdbuf());
+    diagnose(mode == "auto" || mode == "udp" || mode == "memory", "Transport " + mode + " (auto, udp or memory)");
+
+    UdpSock rx, tx;
+    Link link{};
+    std::unique_ptr<MemoryTransport> memory{};
+    if (mode == "memory" || !open_udp(rx, tx, link))
+    {
+        diagnose(mode != "udp", "Multicast over the loopback interface");
+        memory = std::make_unique<MemoryTransport>();
+        diagnose(memory->isGood(), "Creating in-memory transport");
+        link.memory = memory.get();
+    }
+    const std::string transport = memory ? "memory" : "udp";
+    std::cerr << "Transport: " << transport << '\n';
+
+    std::vector<size_t> stream_counts{};
+    for (size_t n = 1; n <= max_streams; n *= 8)
+        stream_counts.push_back(n);
+
+    char host[256]{};
+    gethostname(host, sizeof(host) - 1);
+    utsname uts{};
+    uname(&uts);
+    char date[32]{};
+    const time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    std::ostringstream json{};
+    json << std::fixed << std::setprecision(1)
+         << "{\n  \"benchmark\": \"loopback\",\n  \"label\": " << json_string(label) << ",\n  \"date\": \"" << date
+         << "\",\n  \"host\": " << json_string(host) << ",\n  \"kernel\": " << json_string(uts.release) << ",\n  \"cpus\": "
+         << std::thread::hardware_concurrency() << ",\n  \"transport\": \"" << transport
+         << "\",\n  \"dispatch\": \"scan\",\n  \"step_s\": " << std::setprecision(6) << duration_s << ",\n  \"loss_limit\": " << LOSS_LIMIT
+         << std::setprecision(1) << ",\n  \"results\": {";
+
+    for (bool goose : {true, false})
+    {
+        std::vector<Stream> streams{};
+        std::vector<GooseSvData> subscriptions{};
+        form_streams(goose, 1, streams, subscriptions);
+        json << (goose ? "" : ",") << "\n    \"" << (goose ? "goose" : "sv") << "\": {\n      \"message_bytes\": "
+             << streams[0].message.size() << ",\n      \"ramps\": [";
+
+        double type_max{0};
+        for (size_t r = 0; r < stream_counts.size(); r++)
+        {
+            double ramp_max{0};
+            const char *limited_by = "max_rate";
+            std::vector<StepResult> steps{};
+            for (double pps = START_PPS; pps <= MAX_PPS; pps *= 2)
+            {
+                steps.push_back(run_step(goose, stream_counts[r], pps, duration_s, link, &rx, memory.get()));
+                const StepResult &s = steps.back();
+                std::cerr << (goose ? "GOOSE" : "SV") << ' ' << s.streams << " stream(s) " << std::fixed << std::setprecision(0)
+                          << pps << " pps: accepted " << s.accepted << " of " << s.sent << ", " << s.pps() << " pps, p99 "
+                          << s.latency->percentile(0.99) << " ns\n";
+                if (s.loss() > LOSS_LIMIT)
+                {
+                    limited_by = "loss";
+                    break;
+                }
+                ramp_max = std::max(ramp_max, s.pps());
+                if (s.sent < 0.9 * pps * duration_s || s.tx_elapsed_s > 1.1 * duration_s)
+                {
+                    limited_by = "sender";      // The sender cannot keep up: the rate is bounded by it
+                    break;
+                }
+            }
+            type_max = std::max(type_max, ramp_max);
+
+            json << (r ? "," : "") << "\n        {\"streams\": " << stream_counts[r] << ", \"max_sustainable_pps\": "
+                 << ramp_max << ", \"limited_by\": \"" << limited_by << "\", \"steps\": [";
+            for (size_t i = 0; i < steps.size(); i++)
+            {
+                json << (i ? "," : "") << "\n          ";
+                write_json_step(json, steps[i]);
+            }
+            json << "\n        ]}";
+        }
+        json << "\n      ],\n      \"max_sustainable_pps\": " << type_max << "\n    }";
+    }
+    json << "\n  }\n}\n";
+    std::cout.rdbuf(json_out);
+    std::cout << json.str();
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include <iostream>
+#include <type_traits>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Measurement helpers of the benchmarks
+ * clock_s(): a clock of clock_gettime() in seconds (CLOCK_MONOTONIC, CLOCK_THREAD_CPUTIME_ID, ...).
+ * run_child(): runs work in a child process of its own, so that the peak resident set size of the
+ * process (ru_maxrss of wait4()) is that of work alone. work returns its Result (times, counts: it
+ * must be trivially copyable), which is sent back through a pipe; its rss_mb is then set from the
+ * child's peak RSS. Console output of the child is muted.
+ */
+
+double clock_s(clockid_t clock)
+{
+    timespec ts{};
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Result{} if the child could not be run or did not complete
+template <typename Result, typename Work>
+Result run_child(Work &&work)
+{
+    static_assert(std::is_trivially_copyable<Result>::value, "Result is sent through a pipe");
+    int fds[2];
+    if (pipe(fds) != 0)
+        return Result{};
+    std::cout << std::flush;
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return Result{};
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        std::cout.rdbuf(nullptr);                   // Parsing prints its progress
+        const Result result = work();
+        ssize_t written = write(fds[1], &result, sizeof(result));
+        _exit(written == sizeof(result) ? 0 : 1);
+    }
+    close(fds[1]);
+    Result result{};
+    ssize_t got = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+    int status{};
+    struct rusage usage{};
+    wait4(pid, &status, 0, &usage);
+    if (got != sizeof(result) || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return Result{};
+    result.rss_mb = usage.ru_maxrss / 1024.0;       // in KiB on Linux
+    return result;
+}
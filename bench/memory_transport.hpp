@@ -0,0 +1,94 @@
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+/* In-memory datagram transport for the benchmarks, where no network is available
+ * A single-producer single-consumer ring of SLOTS datagrams of up to MAXBUFLEN bytes, as a socket
+ * receive queue: a datagram sent to a full ring is dropped. The sender signals an eventfd once per
+ * batch of datagrams, so that the receiver sleeps in its event loop (ref: eventLoop.hpp) like on a
+ * socket, rather than polling.
+ */
+class MemoryTransport {
+  public:
+    static constexpr size_t SLOTS = 4096;
+
+    MemoryTransport() : m_slots(std::make_unique<Slot[]>(SLOTS)) {
+      m_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    ~MemoryTransport() {
+      if (isGood())
+        close(m_fd);
+    }
+    // Don't need the other default operations
+    MemoryTransport(const MemoryTransport&) = delete;
+    MemoryTransport& operator=(const MemoryTransport&) = delete;
+    MemoryTransport(MemoryTransport&&) = delete;
+    MemoryTransport& operator=(MemoryTransport&&) = delete;
+
+    // eventfd to wait on (readable once datagrams were sent)
+    int operator()() const {
+      return m_fd;
+    }
+
+    bool isGood() const {
+      return m_fd >= 0;
+    }
+
+    // Sender: false if the ring is full (the datagram is dropped)
+    bool send(const unsigned char *data, size_t len) {
+      const size_t head = m_head.load(std::memory_order_relaxed);
+      if (head - m_tail.load(std::memory_order_acquire) == SLOTS || len > MAXBUFLEN)
+        return false;
+      Slot &slot = m_slots[head % SLOTS];
+      std::memcpy(slot.data, data, len);
+      slot.len = static_cast<int>(len);
+      m_head.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Sender: wakes up the receiver (once per batch)
+    void notify() {
+      const uint64_t one{1};
+      if (write(m_fd, &one, sizeof(one)) < 0)
+        return;
+    }
+
+    /* Receiver: calls handler(const unsigned char *udp_payload, int length) for each datagram in the
+     * ring. Returns the number of datagrams handed to the handler.
+     */
+    template <typename Handler>
+    size_t drain(Handler &&handler) {
+      uint64_t signals{};
+      if (read(m_fd, &signals, sizeof(signals)) < 0)
+        signals = 0;
+
+      size_t count{0};
+      size_t tail = m_tail.load(std::memory_order_relaxed);
+      for (size_t head = m_head.load(std::memory_order_acquire); tail != head; head = m_head.load(std::memory_order_acquire))
+      {
+        for (; tail != head; tail++, count++)
+        {
+          const Slot &slot = m_slots[tail % SLOTS];
+          handler(slot.data, slot.len);
+          m_tail.store(tail + 1, std::memory_order_release);
+        }
+      }
+      return count;
+    }
+
+  private:
+    struct Slot
+    {
+      int           len{0};
+      unsigned char data[MAXBUFLEN];
+    };
+
+    std::unique_ptr<Slot[]>           m_slots;
+    alignas(64) std::atomic<size_t>   m_head{0};        // next slot written by the sender
+    alignas(64) std::atomic<size_t>   m_tail{0};        // next slot read by the receiver
+    int                               m_fd{-1};
+};
@@ -0,0 +1,190 @@
+/* Microbenchmarks of the encode, decode and parse hot paths (harness: bench/microbench.hpp)
+ *
+ * Encode: set_timestamp(), convertIEEE() (one float), convertToInt() (exponent of a float),
+ * form_goose_pdu() with allData from GOOSEdata.txt and given by the caller, form_sv_pdu(), and the
+ * plan of a typed DataSet (DatasetPlan::encode()/decode(), XCBR status with quality and time).
+ * Decode: valid_GSE_SMV() on a stream of R-GOOSE and of R-SV messages formed as ied_send does, and
+ * on the same messages with random bytes changed (op: one message).
+ * Parse: parse_sed() of sample.sed and of synthetic SCD files (bench/synthetic_scd.hpp), on one
+ * thread so that cycles and instructions are those of the whole parse (op: one file).
+ *
+ * Reported per benchmark: ns/op, allocations/op, and cycles/op, instructions/op and IPC where
+ * perf_event_open() is allowed ("-" otherwise). Console output of the code measured is muted.
+ *
+ * Usage (from the repository root, GOOSEdata.txt/SVdata.txt/sample.sed are read):
+ *     make bench && build/bench/microbench [name filter (substring)] [seconds per benchmark (default 1)]
+ */
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <climits>
+
+#include "bench/microbench.hpp"
+
+// For ControlBlock (used by ied_utils.hpp)
+#include "parse_sed.hpp"
+// For the types of the DataSets and the encoding/decoding of typed allData
+#include "scl_types.hpp"
+#include "datasetPlan.hpp"
+
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ied_utils.hpp"
+
+#define MAXBUFLEN 1024
+
+#include "decode_gse_smv.hpp"
+#include "form_gse_smv.hpp"
+#include "bench/decode_streams.hpp"
+#include "bench/synthetic_scd.hpp"
+
+#define STREAM_LEN 100          // messages per stream (one pass of a decode benchmark)
+
+// XCBR status: Pos (stVal, q, t), BlkOpn and BlkCls (stVal, q, t), OpCnt (stVal, q, t), Loc
+std::vector<TypedValue> xcbr_status()
+{
+    const std::vector<TypedValue> dps{{"stVal", BasicType::Dbpos, {}}, {"q", BasicType::Quality, {}}, {"t", BasicType::Timestamp, {}}};
+    const std::vector<TypedValue> spc{{"stVal", BasicType::Boolean, {}}, {"q", BasicType::Quality, {}}, {"t", BasicType::Timestamp, {}}};
+    const std::vector<TypedValue> ins{{"stVal", BasicType::Int32, {}}, {"q", BasicType::Quality, {}}, {"t", BasicType::Timestamp, {}}};
+    return {{"Pos", BasicType::Struct, dps}, {"BlkOpn", BasicType::Struct, spc}, {"BlkCls", BasicType::Struct, spc},
+            {"OpCnt", BasicType::Struct, ins}, {"Loc", BasicType::Boolean, {}}};
+}
+
+int main(int argc, char *argv[])
+{
+    const std::string filter = (argc > 1) ? argv[1] : "";
+    const double min_s = (argc > 2) ? std::stod(argv[2]) : 1.0;
+
+    PerfCounters perf{};
+    if (!perf.isGood())
+        std::cout << "[!] perf_event_open() not allowed: no cycles/instructions (ref: /proc/sys/kernel/perf_event_paranoid)\n";
+    print_microbench_header(std::cout);
+
+    std::streambuf *cout_buf = std::cout.rdbuf();
+    std::streambuf *cerr_buf = std::cerr.rdbuf();
+    auto run = [&](const std::string &name, unsigned long long ops, auto &&fn) {
+        if (name.find(filter) == std::string::npos)
+            return;
+        std::cout.rdbuf(nullptr);
+        std::cerr.rdbuf(nullptr);
+        const MicrobenchResult result = microbench(perf, min_s, ops, fn);
+        std::cout.rdbuf(cout_buf);
+        std::cerr.rdbuf(cerr_buf);
+        print_microbench(std::cout, name, result);
+    };
+
+    // Encode
+    run("set_timestamp", 1, []() {
+        std::array<unsigned char, 8> time{};
+        set_timestamp(time);
+        keep(time);
+    });
+
+    std::vector<unsigned char> floats{};
+    floats.reserve(64);
+    run("convertIEEE", 16, [&floats]() {
+        floats.clear();
+        for (int i = 0; i < 16; i++)
+        {
+            IEEEfloat value{};
+            value.f = 230.5f + i;
+            convertIEEE(value, floats);
+        }
+        keep(floats.data());
+    });
+
+    std::vector<unsigned int> bits(32);
+    for (int i = 0; i < 32; i++)
+        bits[i] = (0x43668000u >> (31 - i)) & 1;      // 230.5
+    run("convertToInt", 1, [&bits]() {
+        keep(convertToInt(bits, 1, 8));
+    });
+
+    GooseSvData goose = subscription_of("GSE");
+    run("form_goose_pdu (GOOSEdata.txt)", 1, [&goose]() {
+        std::vector<unsigned char> pdu{};
+        form_goose_pdu(goose, pdu);
+        keep(pdu.data());
+    });
+
+    const std::vector<unsigned char> allData{0x83, 0x01, 0x01};
+    run("form_goose_pdu (allData given)", 1, [&goose, &allData]() {
+        std::vector<unsigned char> pdu{};
+        form_goose_pdu(goose, pdu, &allData);
+        keep(pdu.data());
+    });
+
+    GooseSvData sv = subscription_of("SMV");
+    run("form_sv_pdu (SVdata.txt)", 1, [&sv]() {
+        std::vector<unsigned char> pdu{};
+        form_sv_pdu(sv, pdu);
+        keep(pdu.data());
+    });
+
+    const DatasetPlan plan{xcbr_status()};
+    std::vector<DataValue> values(plan.values());
+    for (size_t i = 0; i < values.size(); i++)
+        values[i].integer = (plan.type(i) == BasicType::Timestamp) ? 0x6ad51d839e0f3500 : 1;
+    std::vector<unsigned char> encoded(plan.maxSize());
+    encoded.resize(plan.encode(values.data(), encoded.data()));
+    std::vector<unsigned char> out(plan.maxSize());
+    run("DatasetPlan::encode (XCBR)", 1, [&]() {
+        keep(plan.encode(values.data(), out.data()));
+    });
+    run("DatasetPlan::decode (XCBR)", 1, [&]() {
+        keep(plan.decode(encoded.data(), encoded.size(), values.data()));
+    });
+
+    // Decode
+    const std::vector<std::vector<unsigned char>> goose_stream = form_stream("GSE", STREAM_LEN);
+    const std::vector<std::vector<unsigned char>> sv_stream = form_stream("SMV", STREAM_LEN);
+    auto decode = [&](const std::string &name, const std::vector<std::vector<unsigned char>> &stream, const std::string &cbType) {
+        std::vector<std::array<unsigned char, MAXBUFLEN>> bufs(stream.size());
+        for (size_t i = 0; i < stream.size(); i++)
+            std::memcpy(bufs[i].data(), stream[i].data(), stream[i].size());
+        GooseSvData cb = subscription_of(cbType);
+        run(name, stream.size(), [&]() {
+            cb.prev_spduNum = 0;
+            cb.prev_stNum_Value = 0;
+            cb.prev_sqNum_Value = 0;
+            cb.prev_smpCnt_Value = 0;
+            cb.prev_allData_Value.clear();
+            cb.counters = StreamCounters{};
+            for (size_t i = 0; i < stream.size(); i++)
+                keep(valid_GSE_SMV(bufs[i].data(), static_cast<int>(stream[i].size()), cb));
+        });
+    };
+    decode("valid_GSE_SMV GOOSE valid", goose_stream, "GSE");
+    decode("valid_GSE_SMV GOOSE malformed", mutate_stream(goose_stream), "GSE");
+    decode("valid_GSE_SMV SV valid", sv_stream, "SMV");
+    decode("valid_GSE_SMV SV malformed", mutate_stream(sv_stream), "SMV");
+
+    // Parse
+    run("parse_sed sample.sed", 1, []() {
+        keep(parse_sed("sample.sed", 1).size());
+    });
+    for (size_t numIEDs : {100, 1000})
+    {
+        const std::string filename = "/tmp/microbench_" + std::to_string(numIEDs) + ".scd";
+        write_scd(filename, numIEDs);
+        run("parse_sed synthetic " + std::to_string(numIEDs) + " IEDs", 1, [&filename]() {
+            keep(parse_sed(filename.c_str(), 1).size());
+        });
+        std::remove(filename.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Microbenchmark harness
+ * A case is a function run for a number of operations (ops per call given by the case). The number
+ * of calls is calibrated so that a run lasts at least the minimum time; the best of RUNS runs is
+ * reported: ns/op, allocations/op (every operator new of the process is counted), and cycles/op and
+ * instructions/op from perf_event_open() (user space of the calling thread only), where the kernel
+ * allows it (/proc/sys/kernel/perf_event_paranoid <= 2, or CAP_PERFMON).
+ */
+
+// Calls of operator new since the start of the process, on every thread
+static std::atomic<unsigned long long> g_allocations{0};
+
+/* The replacement operators are kept out of line: inlined, memory from std::malloc() would be seen
+ * released by operator delete (a false -Wmismatched-new-delete)
+ */
+__attribute__((noinline)) void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+// Keeps the compiler from removing a computation whose result is not used
+template <typename T>
+inline void keep(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Cycles and instructions of this thread in user space (one group: both count over the same interval)
+class PerfCounters {
+  public:
+    PerfCounters() {
+      m_cycles = open(PERF_COUNT_HW_CPU_CYCLES, -1);
+      if (m_cycles >= 0)
+        m_instructions = open(PERF_COUNT_HW_INSTRUCTIONS, m_cycles);
+    }
+    ~PerfCounters() {
+      if (m_instructions >= 0)
+        close(m_instructions);
+      if (m_cycles >= 0)
+        close(m_cycles);
+    }
+    // Don't need the other default operations
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    PerfCounters(PerfCounters&&) = delete;
+    PerfCounters& operator=(PerfCounters&&) = delete;
+
+    bool isGood() const {
+      return m_cycles >= 0 && m_instructions >= 0;
+    }
+
+    void start() {
+      if (!isGood())
+        return;
+      ioctl(m_cycles, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(m_cycles, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    // Counts since start(): false if not available
+    bool stop(uint64_t &cycles, uint64_t &instructions) {
+      if (!isGood())
+        return false;
+      ioctl(m_cycles, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+      uint64_t values[3]{};       // PERF_FORMAT_GROUP: number of counters, then their values
+      if (read(m_cycles, values, sizeof(values)) != sizeof(values) || values[0] != 2)
+        return false;
+      cycles = values[1];
+      instructions = values[2];
+      return true;
+    }
+
+  private:
+    static int open(uint64_t config, int group) {
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = config;
+      attr.disabled = (group < 0) ? 1 : 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+    }
+
+    int m_cycles{-1};
+    int m_instructions{-1};
+};
+
+struct MicrobenchResult
+{
+    double ns{0};
+    double allocations{0};
+    double cycles{-1};          // -1: not available
+    double instructions{-1};
+};
+
+/* Runs fn (ops operations per call) for at least min_s seconds, RUNS times: the best run, per operation
+ * (cycles and instructions are those of the fastest run)
+ */
+template <typename Fn>
+MicrobenchResult microbench(PerfCounters &perf, double min_s, unsigned long long ops, Fn &&fn)
+{
+    constexpr int RUNS = 5;
+
+    // Calibration: calls for min_s / RUNS per run
+    unsigned long long calls{1};
+    for (;;)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned long long i = 0; i < calls; i++)
+            fn();
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= min_s / RUNS / 4 || calls >= (1ull << 40))
+        {
+            calls = static_cast<unsigned long long>(calls * (min_s / RUNS) / ((elapsed > 0) ? elapsed : 1e-9)) + 1;
+            break;
+        }
+        calls *= 4;
+    }
+
+    MicrobenchResult best{};
+    for (int run = 0; run < RUNS; run++)
+    {
+        const unsigned long long allocations = g_allocations.load(std::memory_order_relaxed);
+        uint64_t cycles{0}, instructions{0};
+        perf.start();
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned long long i = 0; i < calls; i++)
+            fn();
+        const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        const bool counted = perf.stop(cycles, instructions);
+
+        const double n = static_cast<double>(calls) * ops;
+        if (run == 0 || elapsed / n < best.ns)
+        {
+            best.ns = elapsed / n;
+            best.allocations = (g_allocations.load(std::memory_order_relaxed) - allocations) / n;
+            best.cycles = counted ? cycles / n : -1;
+            best.instructions = counted ? instructions / n : -1;
+        }
+    }
+    return best;
+}
+
+void print_microbench_header(std::ostream &out)
+{
+    out << std::left << std::setw(36) << "benchmark" << std::right << std::setw(14) << "ns/op" << std::setw(12)
+        << "allocs/op" << std::setw(14) << "cycles/op" << std::setw(14) << "instr/op" << std::setw(8) << "IPC" << '\n';
+}
+
+void print_microbench(std::ostream &out, const std::string &name, const MicrobenchResult &r)
+{
+    out << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(1)
+        << std::setw(14) << r.ns << std::setw(12) << std::setprecision(2) << r.allocations << std::setprecision(1);
+    if (r.cycles >= 0)
+        out << std::setw(14) << r.cycles << std::setw(14) << r.instructions << std::setw(8) << std::setprecision(2)
+            << ((r.cycles > 0) ? r.instructions / r.cycles : 0);
+    else
+        out << std::setw(14) << "-" << std::setw(14) << "-" << std::setw(8) << "-";
+    out << '\n';
+}
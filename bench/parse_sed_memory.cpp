@@ -0,0 +1,100 @@
+/* Memory benchmark: parse_sed() (rapidxml document of the whole file) vs parse_sed_stream() (SclReader,
+ * read() into a fixed buffer, or memory-mapped with the pages dropped once read)
+ *
+ * Synthetic SCD files (bench/synthetic_scd.hpp) are written for a growing number of IEDs, with as many
+ * LNodeTypes in their DataTypeTemplates. Each parse runs in a child process of its own, so that its
+ * peak resident set size (ru_maxrss of wait4()) is its own; the time of the parse and a checksum of
+ * its result are sent back through a pipe.
+ *
+ * Reported per file: IEDs, Control Blocks, file size, then for each path the time and peak RSS, and
+ * whether the three paths return the same Control Blocks (same checksum)
+ *
+ * Usage:
+ *     make bench && build/bench/parse_sed_memory [IEDs of the largest file (default 20000)]
+ */
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "parse_sed.hpp"
+#include "scl_types.hpp"
+#include "sed_cache.hpp"
+#include "bench/measure.hpp"
+#include "bench/synthetic_scd.hpp"
+
+struct Run
+{
+    double   ms{0};
+    double   rss_mb{0};
+    uint64_t checksum{0};
+    size_t   numCBs{0};
+};
+
+// Hash of every field of the Control Blocks (ref: xxh64() in sed_cache.hpp)
+uint64_t checksum(const std::vector<ControlBlock> &vector_of_ctrl_blks)
+{
+    std::string all{};
+    for (const ControlBlock &cb : vector_of_ctrl_blks)
+    {
+        for (std::string field : {cb.hostIED.str(), std::string(cb_type_name(cb.cbType)), ipv4_string(cb.multicastIP),
+                                  appid_string(cb.appID), cb.vlanID.str(), cb.cbName.str(), cb.datSetName.str()})
+            all.append(field).append(1, '\0');
+        all.append(std::to_string(cb.minTime)).append(1, '/').append(std::to_string(cb.maxTime));
+        for (const Fcda &item : cb.datSetVector)
+            all.append(item.str()).append(1, ',');
+        for (Symbol item : cb.subscribingIEDs)
+            all.append(item.view()).append(1, ',');
+        all.append(1, '\n');
+    }
+    return xxh64(all);
+}
+
+// Runs parse in a child process: its time, peak RSS and checksum of its result
+template <typename Parse>
+Run parse_child(Parse &&parse)
+{
+    return run_child<Run>([&]() {
+        Run run{};
+        auto start = std::chrono::steady_clock::now();
+        std::vector<ControlBlock> result = parse();
+        run.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        run.checksum = checksum(result);
+        run.numCBs = result.size();
+        return run;
+    });
+}
+
+int main(int argc, char *argv[])
+{
+    size_t maxIEDs = (argc > 1) ? std::stoul(argv[1]) : 20000;
+    const std::string filename = "/tmp/parse_sed_memory.scd";
+
+    std::cout << std::setw(8) << "IEDs" << std::setw(8) << "CBs" << std::setw(10) << "MB"
+              << std::setw(12) << "DOM ms" << std::setw(12) << "DOM RSS"
+              << std::setw(12) << "read ms" << std::setw(12) << "read RSS"
+              << std::setw(12) << "mmap ms" << std::setw(12) << "mmap RSS" << std::setw(8) << "same" << '\n';
+    for (size_t numIEDs = 10; numIEDs <= maxIEDs; numIEDs = (numIEDs * 10 > maxIEDs && numIEDs < maxIEDs) ? maxIEDs : numIEDs * 10)
+    {
+        write_scd(filename, numIEDs, numIEDs);
+        std::ifstream size_of(filename, std::ios::binary | std::ios::ate);
+        const double mb = size_of.tellg() / 1e6;
+
+        const Run dom = parse_child([&]() { return parse_sed(filename.c_str()); });
+        const Run read = parse_child([&]() { return parse_sed_stream(filename.c_str(), false); });
+        const Run mapped = parse_child([&]() { return parse_sed_stream(filename.c_str(), true); });
+        const bool same = dom.numCBs && dom.checksum == read.checksum && dom.checksum == mapped.checksum;
+
+        std::cout << std::setw(8) << numIEDs << std::setw(8) << dom.numCBs << std::fixed << std::setprecision(2)
+                  << std::setw(10) << mb
+                  << std::setw(12) << dom.ms << std::setw(9) << std::setprecision(1) << dom.rss_mb << " MB"
+                  << std::setw(12) << std::setprecision(2) << read.ms << std::setw(9) << std::setprecision(1) << read.rss_mb << " MB"
+                  << std::setw(12) << std::setprecision(2) << mapped.ms << std::setw(9) << std::setprecision(1) << mapped.rss_mb << " MB"
+                  << std::setw(8) << (same ? "yes" : "NO") << '\n';
+    }
+    std::remove(filename.c_str());
+    return 0;
+}
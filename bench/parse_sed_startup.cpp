@@ -0,0 +1,97 @@
+/* Startup benchmark: parse_sed() (SCL index, hash lookups) vs parse_sed_rescan() (nested scans),
+ * and parse_sed() for one IED's view, and the load of that view's compiled configuration (sed_cache.hpp)
+ *
+ * Synthetic SCD files are written for a growing number of IEDs. Each IED publishes one R-SV and one
+ * R-GOOSE Control Block in LD1 (subscribed by the next IED), and has two more LDevices without
+ * Control Blocks, as substation IEDs do. Every file is parsed whole by both functions, then for the
+ * view of one IED (publisher of 2 Control Blocks, subscriber of 2), with their output muted. Last, the
+ * view is loaded by load_sed() from the image compiled by the previous run: a restart.
+ *
+ * Reported per file: IEDs, Control Blocks, file size, time of each parse, speed-up of the whole-file
+ * parse, and whether the results agree: both whole-file parses return the same Control Blocks (names,
+ * addresses and subscribers; the Information Model differs by design: parse_sed_rescan() appends the
+ * DataSets of earlier Control Blocks of the LN0), and the one-IED view returns those of the whole-file
+ * parse that the IED publishes or subscribes to, as does the compiled configuration
+ *
+ * Usage:
+ *     make bench && build/bench/parse_sed_startup [IEDs of the largest file (default 5000)]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "parse_sed.hpp"
+#include "scl_types.hpp"
+#include "sed_cache.hpp"
+#include "bench/parse_sed_rescan.hpp"
+#include "bench/same_control_blocks.hpp"
+#include "bench/synthetic_scd.hpp"
+
+// Control Blocks of a whole-file parse that ied_name publishes or subscribes to
+std::vector<ControlBlock> view_of(const std::vector<ControlBlock> &all, const std::string &ied_name)
+{
+    std::vector<ControlBlock> view{};
+    for (const ControlBlock &cb : all)
+    {
+        if (cb.hostIED == ied_name || std::count(cb.subscribingIEDs.begin(), cb.subscribingIEDs.end(), ied_name))
+            view.push_back(cb);
+    }
+    return view;
+}
+
+template <typename Parse>
+double time_ms(Parse &&parse, std::vector<ControlBlock> &result)
+{
+    std::streambuf *cout_buf = std::cout.rdbuf(nullptr);    // Parsing prints its progress
+    auto start = std::chrono::steady_clock::now();
+    result = parse();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout.rdbuf(cout_buf);
+    return ms;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t maxIEDs = (argc > 1) ? std::stoul(argv[1]) : 5000;
+    const std::string filename = "/tmp/parse_sed_startup.scd";
+
+    std::cout << std::setw(8) << "IEDs" << std::setw(8) << "CBs" << std::setw(10) << "MB"
+              << std::setw(14) << "rescan ms" << std::setw(14) << "indexed ms" << std::setw(10) << "speed-up"
+              << std::setw(14) << "one IED ms" << std::setw(14) << "compiled ms" << std::setw(8) << "same" << '\n';
+    for (size_t numIEDs = 10; numIEDs <= maxIEDs; numIEDs = (numIEDs * 10 > maxIEDs && numIEDs < maxIEDs) ? maxIEDs : numIEDs * 10)
+    {
+        write_scd(filename, numIEDs);
+        std::ifstream size_of(filename, std::ios::binary | std::ios::ate);
+        const double mb = size_of.tellg() / 1e6;
+
+        const std::string ied_name = "IED" + std::to_string(numIEDs / 2);
+        std::vector<ControlBlock> rescanned{}, indexed{}, view{};
+        const double rescan_ms = time_ms([&]() { return parse_sed_rescan(filename.c_str()); }, rescanned);
+        const double indexed_ms = time_ms([&]() { return parse_sed(filename.c_str()); }, indexed);
+        const double view_ms = time_ms([&]() { return parse_sed(filename.c_str(), ied_name.c_str()); }, view);
+
+        // First start: parses the XML and compiles the image. Restart: loads the image.
+        std::vector<ControlBlock> compiled{};
+        std::vector<TypedDataSet> dataSets{};
+        time_ms([&]() { return load_sed(filename.c_str(), ied_name.c_str(), dataSets); }, compiled);
+        const double compiled_ms = time_ms([&]() { return load_sed(filename.c_str(), ied_name.c_str(), dataSets); }, compiled);
+        std::remove(sed_cache_filename(filename.c_str(), ied_name.c_str()).c_str());
+
+        const bool same = same_control_blocks(rescanned, indexed, true) && same_control_blocks(view_of(indexed, ied_name), view)
+                       && same_control_blocks(view, compiled);
+
+        std::cout << std::setw(8) << numIEDs << std::setw(8) << indexed.size() << std::fixed << std::setprecision(2)
+                  << std::setw(10) << mb << std::setw(14) << rescan_ms << std::setw(14) << indexed_ms
+                  << std::setw(9) << std::setprecision(1) << rescan_ms / indexed_ms << 'x'
+                  << std::setw(14) << std::setprecision(2) << view_ms << std::setw(14) << compiled_ms
+                  << std::setw(8) << (same ? "yes" : "NO") << '\n';
+    }
+    std::remove(filename.c_str());
+    return 0;
+}
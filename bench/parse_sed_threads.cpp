@@ -0,0 +1,68 @@
+/* Scaling benchmark: parse_sed() with its indexing and resolution split across 1 to N threads
+ *
+ * A synthetic SCD file (bench/synthetic_scd.hpp) is parsed whole with each number of threads, a few
+ * times, keeping the fastest. The XML parse itself (rapidxml) stays on one thread: the speed-up is
+ * bounded by its share of the time.
+ *
+ * Reported per number of threads: time, speed-up over one thread, and whether the Control Blocks and
+ * the output are the same as with one thread
+ *
+ * Usage:
+ *     make bench && build/bench/parse_sed_threads [IEDs (default 20000)] [max threads (default: cores)]
+ */
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "parse_sed.hpp"
+#include "bench/same_control_blocks.hpp"
+#include "bench/synthetic_scd.hpp"
+
+int main(int argc, char *argv[])
+{
+    const size_t numIEDs = (argc > 1) ? std::stoul(argv[1]) : 20000;
+    const unsigned int maxThreads = (argc > 2) ? std::stoul(argv[2]) : scl_threads();
+    const std::string filename = "/tmp/parse_sed_threads.scd";
+    write_scd(filename, numIEDs);
+
+    std::vector<ControlBlock> reference{};
+    std::string reference_output{};
+    double reference_ms{0};
+
+    std::cout << numIEDs << " IEDs, " << std::thread::hardware_concurrency() << " core(s)\n"
+              << std::setw(8) << "threads" << std::setw(12) << "ms" << std::setw(10) << "speed-up" << std::setw(8) << "same" << '\n';
+    for (unsigned int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        double best_ms{0};
+        std::vector<ControlBlock> result{};
+        std::ostringstream output{};
+        for (int run = 0; run < 3; run++)
+        {
+            std::ostringstream run_output{};
+            std::streambuf *cout_buf = std::cout.rdbuf(run_output.rdbuf());
+            auto start = std::chrono::steady_clock::now();
+            result = parse_sed(filename.c_str(), threads);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout.rdbuf(cout_buf);
+            best_ms = (run == 0) ? ms : std::min(best_ms, ms);
+            output.str(run_output.str());
+        }
+        if (threads == 1)
+        {
+            reference = result;
+            reference_output = output.str();
+            reference_ms = best_ms;
+        }
+
+        const bool same = same_control_blocks(reference, result) && reference_output == output.str();
+        std::cout << std::setw(8) << threads << std::fixed << std::setprecision(2) << std::setw(12) << best_ms
+                  << std::setw(9) << std::setprecision(1) << reference_ms / best_ms << 'x'
+                  << std::setw(8) << (same ? "yes" : "NO") << '\n';
+    }
+    std::remove(filename.c_str());
+    return 0;
+}
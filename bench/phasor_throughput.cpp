@@ -0,0 +1,145 @@
+/* Phasor estimation benchmark: sliding-window DFT + RMS (phasorEstimator.hpp) vs a full DFT per sample
+ *
+ * Sample sets of 16 channels per R-SV stream (distorted sine waves, a different amplitude and
+ * phase per channel) are pushed for 2 to 64 streams, as ied_recv does with the aligned sets.
+ * The reference computes the same harmonics and RMS with a plain DFT over the last cycle,
+ * at every sample. After the run, the largest deviation between the two is reported.
+ *
+ * Reported per stream count: ns per sample set and per channel-sample for both, and the
+ * largest magnitude (relative) and angle errors of the estimator
+ *
+ * Usage:
+ *     make bench && build/bench/phasor_throughput [sample sets per case (default 400000)]
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "phasorEstimator.hpp"
+
+#define SAMPLES_PER_CYCLE 80
+#define CHANNELS_PER_STREAM 16
+#define SMPCNT_WRAP 4000
+
+const std::vector<unsigned int> HARMONICS{1, 3, 5};
+
+// Sample of every channel at smpCnt: fundamental with 20 % 3rd and 5 % 5th harmonic, and an offset
+void sample_of(unsigned int smpCnt, std::vector<float> &values)
+{
+    const double t = 2 * M_PI * (smpCnt % SAMPLES_PER_CYCLE) / SAMPLES_PER_CYCLE;
+    for (size_t c = 0; c < values.size(); c++)
+    {
+        const double a = 1 + c % 97, phi = 0.01 * c;
+        values[c] = static_cast<float>(a * (std::cos(t + phi) + 0.2 * std::cos(3 * (t + phi))
+                                            + 0.05 * std::cos(5 * (t + phi))) + 0.1);
+    }
+}
+
+// Reference: DFT of the last cycle of every channel, recomputed from scratch
+struct DirectDft
+{
+    size_t             channels;
+    std::vector<float> window;              // [position in cycle][channel]
+    std::vector<float> re, im, sumsq;       // [harmonic][channel], [channel]
+
+    explicit DirectDft(size_t n)
+      : channels{n}, window(SAMPLES_PER_CYCLE * n), re(HARMONICS.size() * n), im(HARMONICS.size() * n), sumsq(n) {}
+
+    void push(unsigned int smpCnt, const float *values)
+    {
+        std::copy(values, values + channels, &window[(smpCnt % SAMPLES_PER_CYCLE) * channels]);
+        std::fill(re.begin(), re.end(), 0.0f);
+        std::fill(im.begin(), im.end(), 0.0f);
+        std::fill(sumsq.begin(), sumsq.end(), 0.0f);
+        for (unsigned int n = 0; n < SAMPLES_PER_CYCLE; n++)
+        {
+            const float *x = &window[n * channels];
+            for (size_t h = 0; h < HARMONICS.size(); h++)
+            {
+                const double angle = 2 * M_PI * ((HARMONICS[h] * n) % SAMPLES_PER_CYCLE) / SAMPLES_PER_CYCLE;
+                const float cs = static_cast<float>(std::cos(angle)), sn = static_cast<float>(-std::sin(angle));
+                for (size_t c = 0; c < channels; c++)
+                {
+                    re[h * channels + c] += x[c] * cs;
+                    im[h * channels + c] += x[c] * sn;
+                }
+            }
+            for (size_t c = 0; c < channels; c++)
+                sumsq[c] += x[c] * x[c];
+        }
+    }
+};
+
+double elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long long count = (argc > 1) ? std::stoull(argv[1]) : 400'000;
+
+    std::cout << SAMPLES_PER_CYCLE << " samples per cycle, harmonics 1 3 5, " << CHANNELS_PER_STREAM
+              << " channels per stream\n\n"
+              << std::setw(8) << "streams" << std::setw(14) << "sliding ns" << std::setw(12) << "ns/ch"
+              << std::setw(14) << "full DFT ns" << std::setw(12) << "ns/ch"
+              << std::setw(14) << "max mag err" << std::setw(14) << "max ang err" << '\n';
+
+    for (size_t streams : {2, 8, 32, 64})
+    {
+        const size_t channels = streams * CHANNELS_PER_STREAM;
+
+        // Inputs are precomputed: only the estimation is timed
+        std::vector<std::vector<float>> cycle(SMPCNT_WRAP, std::vector<float>(channels));
+        for (unsigned int s = 0; s < SMPCNT_WRAP; s++)
+            sample_of(s, cycle[s]);
+
+        PhasorEstimator estimator(channels, SAMPLES_PER_CYCLE, HARMONICS, SAMPLES_PER_CYCLE);
+        if (!estimator.isGood())
+        {
+            std::cout << "[!] Invalid estimator settings\n";
+            return 1;
+        }
+        unsigned long long reports{0};
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned long long i = 0; i < count; i++)
+            reports += estimator.push(i % SMPCNT_WRAP, cycle[i % SMPCNT_WRAP].data());
+        const double sliding_ns = elapsed_ns(start) / count;
+
+        // The full DFT is much slower: fewer sample sets, ending on the same smpCnt as the estimator
+        const unsigned long long direct_count = std::max<unsigned long long>(count / 20 / SAMPLES_PER_CYCLE, 1) * SAMPLES_PER_CYCLE;
+        DirectDft direct(channels);
+        start = std::chrono::steady_clock::now();
+        for (unsigned long long i = count - direct_count; i < count; i++)
+            direct.push(i % SMPCNT_WRAP, cycle[i % SMPCNT_WRAP].data());
+        const double direct_ns = elapsed_ns(start) / direct_count;
+
+        double max_mag_err{0}, max_ang_err{0};
+        for (size_t c = 0; c < channels; c++)
+        {
+            for (size_t h = 0; h < HARMONICS.size(); h++)
+            {
+                const float re = direct.re[h * channels + c], im = direct.im[h * channels + c];
+                const double mag = M_SQRT2 / SAMPLES_PER_CYCLE * std::sqrt(re * re + im * im);
+                const double ang = std::atan2(im, re) * 180 / M_PI;
+                const PhasorEstimator::Phasor p = estimator.phasor(c, h);
+                max_mag_err = std::max(max_mag_err, std::fabs(p.magnitude - mag) / mag);
+                max_ang_err = std::max(max_ang_err, std::fabs(std::remainder(p.angle - ang, 360.0)));
+            }
+            const double rms = std::sqrt(direct.sumsq[c] / SAMPLES_PER_CYCLE);
+            max_mag_err = std::max(max_mag_err, std::fabs(estimator.rms(c) - rms) / rms);
+        }
+
+        std::cout << std::setw(8) << streams << std::fixed << std::setprecision(1)
+                  << std::setw(14) << sliding_ns << std::setw(12) << std::setprecision(2) << sliding_ns / channels
+                  << std::setw(14) << std::setprecision(1) << direct_ns << std::setw(12) << std::setprecision(2) << direct_ns / channels
+                  << std::setw(14) << std::scientific << std::setprecision(1) << max_mag_err
+                  << std::setw(12) << max_ang_err << " deg" << std::defaultfloat
+                  << "  (" << reports << " reports)\n";
+    }
+    return 0;
+}
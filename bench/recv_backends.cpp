@@ -0,0 +1,257 @@
+/* Receive backend benchmark: recvfrom() vs recvmmsg() vs io_uring (multishot recvmsg, provided buffers)
+ *
+ * For each backend, a sender thread sends R-SV datagrams over loopback as fast as it can
+ * (sendmmsg() batches, SPDU Number incremented per datagram). The receiver serves the
+ * backend from the EventLoop and hands every datagram to valid_GSE_SMV(), as ied_recv does.
+ *
+ * Reported per backend:
+ *  - datagrams received and accepted by the decoder (the rest was dropped by the socket)
+ *  - receive throughput, from the first to the last datagram received
+ *  - receiver CPU time per datagram (event loop thread only: system calls + decoding)
+ *  - datagrams handled per event loop wake-up
+ *
+ * Usage (from the repository root, SVdata.txt is read to form the R-SV message):
+ *     make bench && build/bench/recv_backends [datagrams per backend (default 1000000)]
+ */
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <climits>
+
+// For ControlBlock (used by ied_utils.hpp)
+#include "parse_sed.hpp"
+// For the types of the DataSets and the encoding/decoding of typed allData
+#include "scl_types.hpp"
+#include "datasetPlan.hpp"
+
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include "udpSock.hpp"
+#include "zz_diagnose.hpp"
+#include "rxTimestamp.hpp"
+#include "mmsgRecv.hpp"
+#include "uringRecv.hpp"
+#include "eventLoop.hpp"
+#include "ied_utils.hpp"
+
+#define MAXBUFLEN 1024
+
+#include "decode_gse_smv.hpp"
+#include "form_gse_smv.hpp"
+#include "bench/measure.hpp"
+
+#define SEND_BATCH 32
+#define IDLE_CHECK_NS 100'000'000       // receiver stops once the sender is done and nothing arrived for 100 ms
+
+struct BackendResult
+{
+    std::string        name{};
+    unsigned long long sent{0};
+    unsigned long long received{0};
+    unsigned long long accepted{0};
+    unsigned long long wakeups{0};
+    double             elapsed_s{0};
+    double             cpu_s{0};
+};
+
+// Sends `count` copies of `message` to `dest`, each with the next SPDU Number (bytes 10 to 13)
+unsigned long long send_datagrams(const std::vector<unsigned char> &message, const sockaddr_in &dest,
+                                  unsigned long long count)
+{
+    UdpSock sock;
+    diagnose(sock.isGood(), "Opening sender socket");
+
+    std::vector<std::vector<unsigned char>> bufs(SEND_BATCH, message);
+    std::array<iovec, SEND_BATCH> iovs{};
+    std::array<mmsghdr, SEND_BATCH> msgs{};
+    for (int i = 0; i < SEND_BATCH; i++)
+    {
+        iovs[i].iov_base = bufs[i].data();
+        iovs[i].iov_len  = bufs[i].size();
+        msgs[i].msg_hdr.msg_iov     = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen  = 1;
+        msgs[i].msg_hdr.msg_name    = const_cast<sockaddr_in*>(&dest);
+        msgs[i].msg_hdr.msg_namelen = sizeof(dest);
+    }
+
+    unsigned long long sent{0};
+    unsigned int spduNum{1};
+    while (sent < count)
+    {
+        unsigned int batch = static_cast<unsigned int>(std::min<unsigned long long>(SEND_BATCH, count - sent));
+        for (unsigned int i = 0; i < batch; i++, spduNum++)
+        {
+            bufs[i][10] = (spduNum >> 24) & 0xFF;
+            bufs[i][11] = (spduNum >> 16) & 0xFF;
+            bufs[i][12] = (spduNum >>  8) & 0xFF;
+            bufs[i][13] = (spduNum      ) & 0xFF;
+        }
+        int n = sendmmsg(sock(), msgs.data(), batch, 0);
+        if (n <= 0)
+        {
+            if (errno == ENOBUFS || errno == EAGAIN || errno == EINTR)
+                continue;
+            break;
+        }
+        // Unsent datagrams of a partial batch are re-sent with new SPDU Numbers
+        sent += n;
+    }
+    return sent;
+}
+
+BackendResult run_backend(const std::string &backend, const std::vector<unsigned char> &message,
+                          const GooseSvData &subscription, unsigned long long count)
+{
+    BackendResult result{};
+    result.name = backend;
+
+    UdpSock sock;
+    diagnose(sock.isGood(), "Opening receiver socket");
+    int rcvbuf = 8 << 20;
+    if (setsockopt(sock(), SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) < 0)
+        setsockopt(sock(), SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len{sizeof(addr)};
+    diagnose(!bind(sock(), (sockaddr*)&addr, sizeof(addr)) && !getsockname(sock(), (sockaddr*)&addr, &addr_len),
+             "Binding receiver socket");
+    diagnose(fcntl(sock(), F_SETFL, fcntl(sock(), F_GETFL) | O_NONBLOCK) >= 0, "Setting socket non-blocking");
+
+    EventLoop loop;
+    diagnose(loop.isGood(), "Creating event loop");
+
+    GooseSvData cb = subscription;
+    double first_rx{0}, last_rx{0};
+    auto process_datagram = [&](const unsigned char *buf, int numbytes, in_addr /* source */, uint64_t /* rx_time_ns */)
+    {
+        result.received++;
+        if (valid_GSE_SMV(buf, numbytes, cb))
+            result.accepted++;
+    };
+    auto on_batch = [&]()
+    {
+        result.wakeups++;
+        last_rx = clock_s(CLOCK_MONOTONIC);
+        if (first_rx == 0)
+            first_rx = last_rx;
+    };
+
+    std::unique_ptr<MmsgRecv> mmsg{};
+    std::unique_ptr<UringRecv> uring{};
+    if (backend == "recvfrom")
+    {
+        diagnose(loop.addFd(sock(), EPOLLIN, [&](uint32_t)
+        {
+            unsigned char buf[MAXBUFLEN];
+            sockaddr_in their_addr{};
+            socklen_t their_len{sizeof(their_addr)};
+            int numbytes{};
+            while ((numbytes = recvfrom(sock(), buf, MAXBUFLEN - 1, 0, (sockaddr*)&their_addr, &their_len)) >= 0)
+            {
+                process_datagram(buf, numbytes, their_addr.sin_addr, 0);
+                their_len = sizeof(their_addr);
+            }
+            on_batch();
+        }), "Registering recvfrom() backend");
+    }
+    else if (backend == "recvmmsg")
+    {
+        mmsg = std::make_unique<MmsgRecv>(sock());
+        diagnose(loop.addFd(sock(), EPOLLIN, [&](uint32_t)
+        {
+            mmsg->drain(process_datagram);
+            on_batch();
+        }), "Registering recvmmsg() backend");
+    }
+    else
+    {
+        uring = std::make_unique<UringRecv>(sock());
+        diagnose(uring->isGood(), "Setting up io_uring");
+        diagnose(loop.addFd((*uring)(), EPOLLIN, [&](uint32_t)
+        {
+            uring->drain(process_datagram);
+            on_batch();
+        }), "Registering io_uring backend");
+    }
+
+    std::atomic<bool> sender_done{false};
+    unsigned long long received_at_check{0};
+    diagnose(loop.addTimer(IDLE_CHECK_NS, IDLE_CHECK_NS, [&](uint64_t)
+    {
+        if (sender_done && result.received == received_at_check)
+            loop.stop();
+        received_at_check = result.received;
+    }) >= 0, "Arming idle timer");
+
+    const double cpu_start = clock_s(CLOCK_THREAD_CPUTIME_ID);
+    std::thread sender([&]()
+    {
+        result.sent = send_datagrams(message, addr, count);
+        sender_done = true;
+    });
+    loop.run();
+    sender.join();
+
+    // The idle period at the end costs no CPU time (the thread sleeps in epoll_wait())
+    result.cpu_s = clock_s(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+    result.elapsed_s = last_rx - first_rx;
+    if (uring)
+        std::cout << "io_uring multishot request submitted " << uring->submissions() << " time(s)\n";
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long long count = (argc > 1) ? std::stoull(argv[1]) : 1'000'000;
+
+    // One R-SV message, as published by ied_send
+    GooseSvData sv{};
+    sv.cbName = "BenchIED/LLN0$SV$Bench";
+    sv.cbType = CbType::SMV;
+    sv.appID = 0x4000;
+    sv.sv_counter = 1;
+    std::vector<unsigned char> message{};
+    form_udp_data(sv, message);
+    diagnose(message.size() > 14, "Forming R-SV message of " + std::to_string(message.size()) + " bytes");
+
+    GooseSvData subscription{};
+    subscription.cbName = sv.cbName;
+    subscription.cbType = sv.cbType;
+    subscription.appID = sv.appID;
+
+    std::vector<BackendResult> results{};
+    for (const char *backend : {"recvfrom", "recvmmsg", "io_uring"})
+        results.push_back(run_backend(backend, message, subscription, count));
+
+    std::cout << '\n' << std::left << std::setw(10) << "backend"
+              << std::right << std::setw(10) << "sent" << std::setw(10) << "received" << std::setw(10) << "accepted"
+              << std::setw(10) << "kpps" << std::setw(14) << "CPU ns/dgram" << std::setw(14) << "dgrams/wakeup" << '\n';
+    for (const BackendResult &r : results)
+    {
+        std::cout << std::left << std::setw(10) << r.name << std::right
+                  << std::setw(10) << r.sent << std::setw(10) << r.received << std::setw(10) << r.accepted
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(10) << (r.elapsed_s > 0 ? r.received / r.elapsed_s / 1e3 : 0.0)
+                  << std::setw(14) << (r.received ? r.cpu_s * 1e9 / r.received : 0.0)
+                  << std::setw(14) << (r.wakeups ? static_cast<double>(r.received) / r.wakeups : 0.0) << '\n';
+    }
+    return 0;
+}
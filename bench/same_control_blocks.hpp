@@ -0,0 +1,23 @@
+#include <vector>
+
+/* Whether two parses of the same SCD file return the same Control Blocks, in the same order (e.g.
+ * parse_sed() on 1 and N threads, or a view parsed and loaded from its compiled configuration)
+ * names_only: compare names, addresses and subscribers only, against a reference that reads less of
+ * the file (parse_sed_rescan() has no GOOSE MinTime/MaxTime, and appends the DataSets of earlier
+ * Control Blocks of the LN0 to each Information Model)
+ */
+bool same_control_blocks(const std::vector<ControlBlock> &a, const std::vector<ControlBlock> &b, bool names_only = false)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (a[i].hostIED != b[i].hostIED || a[i].cbType != b[i].cbType || a[i].multicastIP.s_addr != b[i].multicastIP.s_addr
+            || a[i].appID != b[i].appID || a[i].vlanID != b[i].vlanID || a[i].cbName != b[i].cbName
+            || a[i].datSetName != b[i].datSetName || a[i].subscribingIEDs != b[i].subscribingIEDs)
+            return false;
+        if (!names_only && (a[i].datSetVector != b[i].datSetVector || a[i].minTime != b[i].minTime || a[i].maxTime != b[i].maxTime))
+            return false;
+    }
+    return true;
+}
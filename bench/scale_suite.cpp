@@ -0,0 +1,226 @@
+/* Scale test suite: start-up time, memory and per-datagram dispatch cost at 10 to 10000 Control Blocks
+ *
+ * Synthetic SCD files (bench/synthetic_scd.hpp) are written with one R-GOOSE and one R-SV Control Block
+ * per IED, each subscribed by the next IEDs (fan-out). For each file:
+ *   - IED start-up: what ied_recv does before it receives (load_sed(), subscription_table())
+ *     for IED1, without its compiled configuration (cold) and with it (warm);
+ *   - station start-up: the same for a station-level subscriber of every Control Block, from parse_sed_stream()
+ *     of the whole file;
+ *   - dispatch: datagrams of 64 streams spread over the station's subscriptions are dispatched as ied_recv
+ *     does, valid_GSE_SMV() on each subscription in turn until one accepts it.
+ * Each start-up runs in a child process of its own, so that its peak resident set size (ru_maxrss of
+ * wait4()) is its own; its time and subscriptions are sent back through a pipe. Decoder and parser output
+ * is muted for the measurement.
+ *
+ * Reported per file: Control Blocks, IEDs, file size, then time and peak RSS of each start-up, ns per
+ * datagram and subscriptions checked per datagram, and whether every datagram was accepted
+ *
+ * Usage (from the repository root, GOOSEdata.txt/SVdata.txt are read to form the datagrams):
+ *     make bench && build/bench/scale_suite [Control Blocks of the largest file (default 10000)] [subscribers per Control Block (default 1)]
+ */
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <climits>
+
+// For ControlBlock (used by ied_utils.hpp)
+#include "parse_sed.hpp"
+// For the types of the DataSets and the encoding/decoding of typed allData
+#include "scl_types.hpp"
+#include "datasetPlan.hpp"
+#include "sed_cache.hpp"
+
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "latencyHistogram.hpp"
+#include "timingWheel.hpp"
+#include "ied_utils.hpp"
+#include "sedReload.hpp"
+
+#define MAXBUFLEN 1024
+
+#include "decode_gse_smv.hpp"
+#include "form_gse_smv.hpp"
+
+#include "bench/measure.hpp"
+#include "bench/synthetic_scd.hpp"
+
+#define DISPATCH_STREAMS 64     // streams sending datagrams in the dispatch measurement
+#define DISPATCH_SECONDS 0.5    // duration of the dispatch measurement
+
+// Name of the station-level subscriber (not an IED of the synthetic files)
+const char *const STATION = "Station";
+
+struct Startup
+{
+    double ms{0};
+    double rss_mb{0};
+    size_t subscriptions{0};
+};
+
+struct Dispatch
+{
+    double ns{0};
+    double checks{0};               // subscriptions checked per datagram
+    bool   all_accepted{false};
+};
+
+// Subscriptions of the station-level subscriber: every Control Block of the file
+std::unique_ptr<SubscriptionTable> station_table(const char *filename)
+{
+    std::vector<ControlBlock> vector_of_ctrl_blks = parse_sed_stream(filename);
+    for (ControlBlock &cb : vector_of_ctrl_blks)
+        cb.subscribingIEDs.emplace_back(std::string_view(STATION));
+    return subscription_table(vector_of_ctrl_blks, STATION, false, goose_datasets(filename, vector_of_ctrl_blks));
+}
+
+// Runs start in a child process: its time, peak RSS and subscriptions
+template <typename Start>
+Startup startup_child(Start &&start)
+{
+    return run_child<Startup>([&]() {
+        Startup run{};
+        auto begin = std::chrono::steady_clock::now();
+        std::unique_ptr<SubscriptionTable> table = start();
+        run.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        run.subscriptions = table->cbSubscribe.size();
+        return run;
+    });
+}
+
+// Clears the receive state of a subscription, so that the first message of its stream is accepted again
+void reset_subscription(GooseSvData &cb)
+{
+    cb.prev_spduNum = 0;
+    cb.prev_stNum_Value = 0;
+    cb.prev_sqNum_Value = 0;
+    cb.prev_smpCnt_Value = 0;
+    cb.prev_allData_Value.clear();
+    cb.counters = StreamCounters{};
+}
+
+// Dispatch of the first datagram of DISPATCH_STREAMS streams over the station's subscriptions
+Dispatch run_dispatch(std::vector<GooseSvData> &cbSubscribe)
+{
+    Dispatch result{};
+    if (cbSubscribe.empty())
+        return result;
+
+    // Streams spread evenly over the table: the datagram each publishes first, as ied_send forms it
+    std::vector<size_t> streams{};
+    std::vector<std::array<unsigned char, MAXBUFLEN>> bufs{};
+    std::vector<int> lengths{};
+    const size_t numStreams = std::min<size_t>(DISPATCH_STREAMS, cbSubscribe.size());
+    std::streambuf *cout_buf = std::cout.rdbuf(nullptr);    // Data files are echoed for every message
+    for (size_t s = 0; s < numStreams; s++)
+    {
+        const size_t index = s * cbSubscribe.size() / numStreams;
+        GooseSvData publisher = cbSubscribe[index];
+        publisher.goose_counter = 1;
+        publisher.sv_counter = 1;
+        std::vector<unsigned char> message{};
+        form_udp_data(publisher, message);
+        if (message.size() > MAXBUFLEN)
+            continue;
+        streams.push_back(index);
+        bufs.emplace_back();
+        std::memcpy(bufs.back().data(), message.data(), message.size());
+        lengths.push_back(static_cast<int>(message.size()));
+    }
+    std::cout.rdbuf(cout_buf);
+
+    unsigned long long dispatched{0}, accepted{0}, checks{0};
+    std::streambuf *cerr_buf = std::cerr.rdbuf(nullptr);
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    do
+    {
+        for (size_t index : streams)
+            reset_subscription(cbSubscribe[index]);
+        for (size_t d = 0; d < bufs.size(); d++)
+        {
+            for (size_t i = 0; i < cbSubscribe.size(); i++)
+            {
+                checks++;
+                if (valid_GSE_SMV(bufs[d].data(), lengths[d], cbSubscribe[i]))
+                {
+                    accepted++;
+                    break;
+                }
+            }
+        }
+        dispatched += bufs.size();
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < DISPATCH_SECONDS);
+    std::cerr.rdbuf(cerr_buf);
+
+    result.ns = elapsed.count() * 1e9 / dispatched;
+    result.checks = static_cast<double>(checks) / dispatched;
+    result.all_accepted = (accepted == dispatched) && (streams.size() == numStreams);
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t maxCBs = (argc > 1) ? std::stoul(argv[1]) : 10000;
+    const size_t fanout = (argc > 2) ? std::stoul(argv[2]) : 1;
+    const std::string filename = "/tmp/scale_suite.scd";
+    const char *ied_name = "IED1";
+
+    std::cout << std::setw(7) << "CBs" << std::setw(7) << "IEDs" << std::setw(8) << "MB"
+              << std::setw(11) << "cold ms" << std::setw(11) << "cold RSS"
+              << std::setw(10) << "warm ms" << std::setw(11) << "warm RSS"
+              << std::setw(12) << "station ms" << std::setw(12) << "station RSS"
+              << std::setw(10) << "ns/dgram" << std::setw(10) << "checks" << std::setw(10) << "accepted" << '\n';
+    for (size_t numCBs = 10; numCBs <= maxCBs; numCBs *= 10)
+    {
+        ScdShape shape{};
+        shape.numIEDs = numCBs / 2;
+        shape.fanout = fanout;
+        write_scd(filename, shape);
+        std::ifstream size_of(filename, std::ios::binary | std::ios::ate);
+        const double mb = size_of.tellg() / 1e6;
+
+        auto ied_startup = [&]() {
+            std::vector<TypedDataSet> dataSets{};
+            std::vector<ControlBlock> vector_of_ctrl_blks = load_sed(filename.c_str(), ied_name, dataSets);
+            return subscription_table(vector_of_ctrl_blks, ied_name, false, dataSets);
+        };
+        const std::string cache_filename = sed_cache_filename(filename.c_str(), ied_name);
+        std::remove(cache_filename.c_str());
+        const Startup cold = startup_child(ied_startup);
+        const Startup warm = startup_child(ied_startup);
+        std::remove(cache_filename.c_str());
+        const Startup station = startup_child([&]() { return station_table(filename.c_str()); });
+
+        std::streambuf *cout_buf = std::cout.rdbuf(nullptr);    // Typed DataSets are listed
+        std::unique_ptr<SubscriptionTable> table = station_table(filename.c_str());
+        std::cout.rdbuf(cout_buf);
+        const Dispatch dispatch = run_dispatch(table->cbSubscribe);
+
+        std::cout << std::setw(7) << numCBs << std::setw(7) << shape.numIEDs << std::fixed << std::setprecision(2)
+                  << std::setw(8) << mb
+                  << std::setw(11) << cold.ms << std::setw(8) << std::setprecision(1) << cold.rss_mb << " MB"
+                  << std::setw(10) << std::setprecision(2) << warm.ms << std::setw(8) << std::setprecision(1) << warm.rss_mb << " MB"
+                  << std::setw(12) << std::setprecision(2) << station.ms << std::setw(9) << std::setprecision(1) << station.rss_mb << " MB"
+                  << std::setw(10) << std::setprecision(1) << dispatch.ns << std::setw(10) << dispatch.checks
+                  << std::setw(10) << ((dispatch.all_accepted && station.subscriptions == numCBs) ? "yes" : "NO") << '\n';
+    }
+    std::remove(filename.c_str());
+    return 0;
+}
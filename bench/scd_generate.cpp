@@ -0,0 +1,59 @@
+/* Writes a synthetic SCD file (bench/synthetic_scd.hpp), to try parse_sed(), ied_send and ied_recv at scale
+ *
+ * Each IED publishes its R-GOOSE and R-SV Control Blocks in LD1, each subscribed by the IEDs that follow
+ * it (IED<i+1>, IED<i+2>...). The file is valid SCL: every DataSet can be typed from its <DataTypeTemplates>.
+ *
+ * Usage:
+ *     make bench && build/bench/scd_generate <SCD Filename> <IEDs> [R-GOOSE per IED (default 1)]
+ *         [R-SV per IED (default 1)] [R-GOOSE DataSet entries (default 1)] [R-SV DataSet entries (default 6)]
+ *         [subscribers per Control Block (default 1)]
+ *     e.g. build/bench/scd_generate /tmp/station.scd 500 4 1 8 6 3
+ *          build/ied_recv /tmp/station.scd lo IED1
+ */
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "bench/synthetic_scd.hpp"
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <SCD Filename> <IEDs> [R-GOOSE per IED] [R-SV per IED]"
+                  << " [R-GOOSE DataSet entries] [R-SV DataSet entries] [subscribers per Control Block]\n";
+        return 1;
+    }
+
+    ScdShape shape{};
+    size_t *fields[] = {&shape.numIEDs, &shape.gsePerIED, &shape.smvPerIED, &shape.gseEntries, &shape.smvEntries, &shape.fanout};
+    for (int i = 2; i < argc && i - 2 < 6; i++)
+    {
+        try
+        {
+            *fields[i - 2] = std::stoul(argv[i]);
+        }
+        catch (const std::exception &)
+        {
+            std::cerr << "[!] Not a number: " << argv[i] << '\n';
+            return 1;
+        }
+    }
+    if (shape.numIEDs == 0 || shape.gseEntries == 0 || shape.smvEntries == 0)
+    {
+        std::cerr << "[!] IEDs and DataSet entries must be at least 1\n";
+        return 1;
+    }
+
+    write_scd(argv[1], shape);
+    std::ifstream size_of(argv[1], std::ios::binary | std::ios::ate);
+    if (!size_of)
+    {
+        std::cerr << "[!] Cannot write " << argv[1] << '\n';
+        return 1;
+    }
+    std::cout << "[*] " << argv[1] << ": " << shape.numIEDs << " IEDs, "
+              << shape.numIEDs * (shape.gsePerIED + shape.smvPerIED) << " Control Blocks, "
+              << static_cast<long long>(size_of.tellg()) << " bytes\n";
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+/* Synthetic SCD files for the benchmarks
+ * Each IED publishes its R-SV and R-GOOSE Control Blocks in LD1, each subscribed by the next IEDs,
+ * and has two more LDevices without Control Blocks, as substation IEDs do. The types of every LN
+ * are in the <DataTypeTemplates>: R-GOOSE DataSets (XCBR Pos) and R-SV DataSets (MMXU A/PhV) can
+ * be typed (ref: scl_types.hpp).
+ */
+
+// Shape of a synthetic SCD file (default: 1 R-GOOSE and 1 R-SV Control Block per IED, subscribed by the next IED)
+struct ScdShape
+{
+    size_t numIEDs{10};
+    size_t gsePerIED{1};        // R-GOOSE Control Blocks published by each IED
+    size_t smvPerIED{1};        // R-SV Control Blocks published by each IED
+    size_t gseEntries{1};       // FCDAs of each R-GOOSE DataSet (Pos of an XCBR each)
+    size_t smvEntries{6};       // FCDAs of each R-SV DataSet (A and PhV of an MMXU: 6 per MMXU)
+    size_t fanout{1};           // subscribers of each Control Block: the IEDs that follow its publisher
+    size_t numTypes{0};         // LNodeTypes of 20 DOs added to the <DataTypeTemplates> (the bulk of real SCD files)
+};
+
+/* Writes an SCD file of the given shape
+ * Control Block k (from 1) of an IED is named MSVCB<k>/GCB<k> (2 digits at least) and sends its
+ * DataSet Measurements<k>/Status<k> ("Measurements"/"Status" for k = 1). Multicast addresses are
+ * 239.0.x.y (R-SV) and 239.1.x.y (R-GOOSE) for the first 32768 Control Blocks of each type.
+ */
+void write_scd(const std::string &filename, const ScdShape &shape)
+{
+    std::ofstream scd(filename);
+    const size_t numIEDs = shape.numIEDs;
+    auto ied = [](size_t i) { return "IED" + std::to_string(i); };
+    auto number = [](size_t k) {
+        std::ostringstream s;
+        s << std::setw(2) << std::setfill('0') << k;
+        return s.str();
+    };
+    auto suffix = [](size_t k) { return (k == 1) ? std::string() : std::to_string(k); };
+    // Multicast address of Control Block c (index over every IED) of a type
+    auto multicast = [](size_t type, size_t c) {
+        const size_t n = 2 * c + 1;
+        return "239." + std::to_string(type + 2 * (n >> 16)) + '.' + std::to_string((n >> 8) & 0xff) + '.' + std::to_string(n & 0xff);
+    };
+    const size_t fanout = std::max<size_t>(1, std::min(shape.fanout, (numIEDs > 1) ? numIEDs - 1 : 1));
+
+    scd << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<SCL xmlns=\"http://www.iec.ch/61850/2003/SCL\">\n"
+        << "\t<Header id=\"Synthetic\" />\n\t<Communication>\n"
+        << "\t\t<SubNetwork name=\"WAN\" type=\"8-MMS\">\n";
+    for (size_t i = 0; i < numIEDs; i++)
+    {
+        scd << "\t\t\t<ConnectedAP iedName=\"" << ied(i) << "\" apName=\"AP1\">\n"
+            << "\t\t\t\t<Address><P type=\"IP\">10.0." << i / 250 << '.' << i % 250 + 1 << "</P></Address>\n";
+        for (size_t k = 1; k <= shape.smvPerIED; k++)
+        {
+            const size_t c = i * shape.smvPerIED + k - 1;
+            scd << "\t\t\t\t<SMV cbName=\"MSVCB" << number(k) << "\" ldInst=\"LD1\"><Address>"
+                << "<P type=\"IP\">" << multicast(0, c) << "</P><P type=\"APPID\">" << std::hex << std::setw(4)
+                << std::setfill('0') << (0x4000 + c % 0x3fff) << std::dec << "</P><P type=\"VLAN-ID\">0</P></Address></SMV>\n";
+        }
+        for (size_t k = 1; k <= shape.gsePerIED; k++)
+        {
+            const size_t c = i * shape.gsePerIED + k - 1;
+            scd << "\t\t\t\t<GSE cbName=\"GCB" << number(k) << "\" ldInst=\"LD1\"><Address>"
+                << "<P type=\"IP\">" << multicast(1, c) << "</P><P type=\"APPID\">" << std::hex << std::setw(4)
+                << std::setfill('0') << (c % 0x3fff) << std::dec << "</P><P type=\"VLAN-ID\">0</P></Address>"
+                << "<MinTime multiplier=\"m\" unit=\"s\">4</MinTime><MaxTime multiplier=\"m\" unit=\"s\">1000</MaxTime></GSE>\n";
+        }
+        scd << "\t\t\t</ConnectedAP>\n";
+    }
+    scd << "\t\t</SubNetwork>\n\t</Communication>\n";
+
+    const size_t numMMXU = (shape.smvEntries + 5) / 6;
+    for (size_t i = 0; i < numIEDs; i++)
+    {
+        scd << "\t<IED name=\"" << ied(i) << "\" type=\"Relay\" manufacturer=\"Synthetic\">\n"
+            << "\t\t<AccessPoint name=\"AP1\">\n";
+        // LDevices without Control Blocks come first: they are scanned past
+        for (const char *inst : {"LD0", "LD2"})
+        {
+            scd << "\t\t\t<LDevice inst=\"" << inst << "\">\n"
+                << "\t\t\t\t<LN0 lnClass=\"LLN0\" inst=\"\" lnType=\"LLN0_T\" />\n";
+            for (int ln = 1; ln <= 4; ln++)
+                scd << "\t\t\t\t<LN lnClass=\"GGIO\" inst=\"" << ln << "\" lnType=\"GGIO_T\" />\n";
+            scd << "\t\t\t</LDevice>\n";
+        }
+        scd << "\t\t\t<LDevice inst=\"LD1\">\n"
+            << "\t\t\t\t<LN0 lnClass=\"LLN0\" inst=\"\" lnType=\"LLN0_T\">\n";
+        for (size_t k = 1; k <= shape.smvPerIED; k++)
+        {
+            scd << "\t\t\t\t\t<DataSet name=\"Measurements" << suffix(k) << "\">\n";
+            for (size_t e = 0; e < shape.smvEntries; e++)
+                scd << "\t\t\t\t\t\t<FCDA ldInst=\"LD1\" lnInst=\"" << 1 + e / 6 << "\" lnClass=\"MMXU\" doName=\""
+                    << ((e % 6 < 3) ? "A" : "PhV") << '.' << "phs" << static_cast<char>('A' + e % 3)
+                    << "\" daName=\"cVal\" fc=\"MX\" />\n";
+            scd << "\t\t\t\t\t</DataSet>\n";
+        }
+        for (size_t k = 1; k <= shape.gsePerIED; k++)
+        {
+            scd << "\t\t\t\t\t<DataSet name=\"Status" << suffix(k) << "\">\n";
+            for (size_t e = 0; e < shape.gseEntries; e++)
+                scd << "\t\t\t\t\t\t<FCDA ldInst=\"LD1\" lnInst=\"" << 1 + e << "\" lnClass=\"XCBR\" doName=\"Pos\" daName=\"stVal\" fc=\"ST\" />\n";
+            scd << "\t\t\t\t\t</DataSet>\n";
+        }
+        auto subscribers = [&]() {
+            for (size_t f = 1; f <= fanout; f++)
+                scd << "\t\t\t\t\t\t<IEDName>" << ied((i + f) % numIEDs) << "</IEDName>\n";
+        };
+        for (size_t k = 1; k <= shape.smvPerIED; k++)
+        {
+            scd << "\t\t\t\t\t<SampledValueControl Name=\"MSVCB" << number(k) << "\" datSet=\"Measurements" << suffix(k)
+                << "\" smvID=\"" << ied(i) << "MU" << number(k) << "\">\n";
+            subscribers();
+            scd << "\t\t\t\t\t</SampledValueControl>\n";
+        }
+        for (size_t k = 1; k <= shape.gsePerIED; k++)
+        {
+            scd << "\t\t\t\t\t<GSEControl Name=\"GCB" << number(k) << "\" datSet=\"Status" << suffix(k)
+                << "\" appID=\"" << ied(i) << "GCB" << number(k) << "\" type=\"GOOSE\">\n";
+            subscribers();
+            scd << "\t\t\t\t\t</GSEControl>\n";
+        }
+        scd << "\t\t\t\t</LN0>\n";
+        for (size_t ln = 1; ln <= numMMXU; ln++)
+            scd << "\t\t\t\t<LN lnClass=\"MMXU\" inst=\"" << ln << "\" lnType=\"MMXU_T\" />\n";
+        for (size_t ln = 1; ln <= shape.gseEntries; ln++)
+            scd << "\t\t\t\t<LN lnClass=\"XCBR\" inst=\"" << ln << "\" lnType=\"XCBR_T\" />\n";
+        scd << "\t\t\t</LDevice>\n"
+            << "\t\t</AccessPoint>\n\t</IED>\n";
+    }
+
+    scd << "\t<DataTypeTemplates>\n"
+        << "\t\t<LNodeType id=\"LLN0_T\" lnClass=\"LLN0\"><DO name=\"Beh\" type=\"INS_T\" /></LNodeType>\n"
+        << "\t\t<LNodeType id=\"GGIO_T\" lnClass=\"GGIO\"><DO name=\"Ind1\" type=\"SPS_T\" /></LNodeType>\n"
+        << "\t\t<LNodeType id=\"MMXU_T\" lnClass=\"MMXU\"><DO name=\"A\" type=\"WYE_T\" /><DO name=\"PhV\" type=\"WYE_T\" /></LNodeType>\n"
+        << "\t\t<LNodeType id=\"XCBR_T\" lnClass=\"XCBR\"><DO name=\"Pos\" type=\"DPC_T\" /></LNodeType>\n";
+    for (size_t t = 0; t < shape.numTypes; t++)
+    {
+        scd << "\t\t<LNodeType id=\"GGIO_T" << t << "\" lnClass=\"GGIO\" desc=\"Generic process I/O &amp; alarms\">\n";
+        for (int d = 1; d <= 20; d++)
+            scd << "\t\t\t<DO name=\"Ind" << d << "\" type=\"SPS_T\" />\n";
+        scd << "\t\t</LNodeType>\n";
+    }
+    // Status (ST) and measured (MX) values with their quality and time stamp
+    for (const char *status : {"INS_T\" cdc=\"INS\"><DA name=\"stVal\" fc=\"ST\" bType=\"INT32\" />",
+                               "SPS_T\" cdc=\"SPS\"><DA name=\"stVal\" fc=\"ST\" bType=\"BOOLEAN\" />",
+                               "DPC_T\" cdc=\"DPC\"><DA name=\"stVal\" fc=\"ST\" bType=\"Dbpos\" />"})
+        scd << "\t\t<DOType id=\"" << status << "<DA name=\"q\" fc=\"ST\" bType=\"Quality\" />"
+            << "<DA name=\"t\" fc=\"ST\" bType=\"Timestamp\" /></DOType>\n";
+    scd << "\t\t<DOType id=\"WYE_T\" cdc=\"WYE\"><SDO name=\"phsA\" type=\"CMV_T\" /><SDO name=\"phsB\" type=\"CMV_T\" />"
+        << "<SDO name=\"phsC\" type=\"CMV_T\" /></DOType>\n"
+        << "\t\t<DOType id=\"CMV_T\" cdc=\"CMV\"><DA name=\"cVal\" fc=\"MX\" bType=\"Struct\" type=\"Vector_T\" />"
+        << "<DA name=\"q\" fc=\"MX\" bType=\"Quality\" /><DA name=\"t\" fc=\"MX\" bType=\"Timestamp\" /></DOType>\n"
+        << "\t\t<DAType id=\"Vector_T\"><BDA name=\"mag\" bType=\"Struct\" type=\"AnalogueValue_T\" />"
+        << "<BDA name=\"ang\" bType=\"Struct\" type=\"AnalogueValue_T\" /></DAType>\n"
+        << "\t\t<DAType id=\"AnalogueValue_T\"><BDA name=\"f\" bType=\"FLOAT32\" /></DAType>\n"
+        << "\t</DataTypeTemplates>\n</SCL>\n";
+}
+
+/* Writes an SCD file with numIEDs IEDs, 2 Control Blocks each, and numTypes LNodeTypes of 20 DOs
+ * in its <DataTypeTemplates> (the bulk of real SCD files, that holds no Control Block)
+ */
+void write_scd(const std::string &filename, size_t numIEDs, size_t numTypes = 0)
+{
+    ScdShape shape{};
+    shape.numIEDs = numIEDs;
+    shape.numTypes = numTypes;
+    write_scd(filename, shape);
+}
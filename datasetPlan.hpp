@@ -0,0 +1,438 @@
+/* Encoding and decoding of GOOSE allData for a DataSet whose member types are known (ref: scl_types.hpp)
+ *
+ * A plan is built once per Control Block from the types of its DataSet: one step per basic value,
+ * and one at the start and at the end of every structure, in the order of the values in allData.
+ * Executing it on a message only reads the steps and the caller's values: no allocation.
+ *
+ * Values are the MMS Data of ISO 9506-2 / IEC 61850-8-1 in ASN.1 BER, each in its shortest form:
+ *   BOOLEAN            83 01 00|01
+ *   INT8..INT32, Enum  85 01..04 two's complement
+ *   INT8U..INT32U      86 01..05 unsigned (leading 00 if the top bit is set)
+ *   FLOAT32            87 05 08 IEEE 754 single precision
+ *   Dbpos              84 02 06 2-bit bit-string
+ *   Quality            84 03 03 13-bit bit-string
+ *   Timestamp          91 08 UtcTime
+ *   structure          A2 length members
+ * Lengths of 128 bytes and more take the long form (81 xx, 82 xx xx), so that DataSets of dozens of
+ * entries (e.g. XCBR and CSWI status with quality and time) fit.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// A basic value of a DataSet (the type is that of its step in the plan)
+struct DataValue
+{
+    int64_t integer{0};     // BOOLEAN (0/1), INTn, INTnU, Enum, Dbpos (0..3), Quality (13 bits, first one as bit 12), Timestamp (8 bytes)
+    float   real{0};        // FLOAT32
+};
+
+/* Reads the Tag-Length of the BER element at pos (short or long form of the Length, up to 2 bytes),
+ * bounded by end. Fails if its Value runs past end.
+ */
+bool ber_element(const unsigned char *pos, const unsigned char *end, unsigned char &tag,
+                 const unsigned char *&value, size_t &len)
+{
+    if (end - pos < 2)
+        return false;
+    tag = pos[0];
+    if (pos[1] < 0x80)
+    {
+        len = pos[1];
+        value = pos + 2;
+    }
+    else if (pos[1] == 0x81 && end - pos >= 3)
+    {
+        len = pos[2];
+        value = pos + 3;
+    }
+    else if (pos[1] == 0x82 && end - pos >= 4)
+    {
+        len = (static_cast<size_t>(pos[2]) << 8) | pos[3];
+        value = pos + 4;
+    }
+    else
+    {
+        return false;
+    }
+    return len <= static_cast<size_t>(end - value);
+}
+
+// Number of BER elements filling [pos, end) exactly (0 if they don't)
+size_t ber_count(const unsigned char *pos, const unsigned char *end)
+{
+    size_t count{0};
+    unsigned char tag{};
+    const unsigned char *value{nullptr};
+    size_t len{0};
+    for (; pos < end; pos = value + len, count++)
+    {
+        if (!ber_element(pos, end, tag, value, len))
+            return 0;
+    }
+    return count;
+}
+
+class DatasetPlan {
+  public:
+    static constexpr int MAX_DEPTH = 16;        // nested structures
+
+    explicit DatasetPlan(const std::vector<TypedValue> &entries) {
+      m_good = true;
+      for (const TypedValue &entry : entries)
+        add(entry, entry.name, 0);
+      m_entries = entries.size();
+    }
+    // Don't need the other default operations
+    DatasetPlan(const DatasetPlan&) = delete;
+    DatasetPlan& operator=(const DatasetPlan&) = delete;
+    DatasetPlan(DatasetPlan&&) = delete;
+    DatasetPlan& operator=(DatasetPlan&&) = delete;
+
+    bool isGood() const {
+      return m_good && m_entries > 0 && m_maxSize <= 0xFFFF;
+    }
+
+    // numDatSetEntries
+    size_t entries() const {
+      return m_entries;
+    }
+
+    // Basic values, in order (size of the values array given to encode() and decode())
+    size_t values() const {
+      return m_names.size();
+    }
+
+    const std::string& name(size_t value) const {
+      return m_names[value];
+    }
+
+    BasicType type(size_t value) const {
+      return m_types[value];
+    }
+
+    // Largest allData of the DataSet: a buffer of this size can hold any of its encodings
+    size_t maxSize() const {
+      return m_maxSize;
+    }
+
+    /* Encodes the values into out (at least maxSize() bytes): returns the length of allData
+     * The elements are written from the end of the buffer backwards, so that the length of every
+     * structure is known when its header is written; allData is then moved to the start of out.
+     */
+    size_t encode(const DataValue *values, unsigned char *out) const {
+      unsigned char *const end = out + m_maxSize;
+      unsigned char *pos = end;
+      unsigned char *structEnd[MAX_DEPTH];
+      int depth{0};
+
+      for (size_t k = m_steps.size(); k-- > 0; )
+      {
+        const Step &step = m_steps[k];
+        if (step.kind == Step::End)
+        {
+          structEnd[depth++] = pos;
+          continue;
+        }
+        if (step.kind == Step::Begin)
+        {
+          pos = putHeader(pos, 0xA2, static_cast<size_t>(structEnd[--depth] - pos));
+          continue;
+        }
+
+        const DataValue &v = values[step.value];
+        switch (m_types[step.value])
+        {
+          case BasicType::Boolean:
+            *--pos = v.integer ? 0x01 : 0x00;
+            pos = putHeader(pos, 0x83, 1);
+            break;
+          case BasicType::Int8: case BasicType::Int16: case BasicType::Int32: case BasicType::Enum:
+          {
+            const int32_t n = static_cast<int32_t>(v.integer);
+            size_t len{1};
+            while (len < 4 && (n >> (8 * len - 1)) != 0 && (n >> (8 * len - 1)) != -1)
+              len++;
+            for (size_t i = 0; i < len; i++)
+              *--pos = static_cast<unsigned char>(n >> (8 * i));
+            pos = putHeader(pos, 0x85, len);
+            break;
+          }
+          case BasicType::Int8U: case BasicType::Int16U: case BasicType::Int32U:
+          {
+            const uint32_t n = static_cast<uint32_t>(v.integer);
+            size_t len{1};
+            while (len < 5 && (static_cast<uint64_t>(n) >> (8 * len - 1)) != 0)
+              len++;
+            for (size_t i = 0; i < len; i++)
+              *--pos = static_cast<unsigned char>(static_cast<uint64_t>(n) >> (8 * i));
+            pos = putHeader(pos, 0x86, len);
+            break;
+          }
+          case BasicType::Float32:
+          {
+            uint32_t bits{};
+            std::memcpy(&bits, &v.real, sizeof(bits));
+            for (int i = 0; i < 4; i++)
+              *--pos = static_cast<unsigned char>(bits >> (8 * i));
+            *--pos = 0x08;      // exponent width
+            pos = putHeader(pos, 0x87, 5);
+            break;
+          }
+          case BasicType::Dbpos:
+            *--pos = static_cast<unsigned char>((v.integer & 0x03) << 6);
+            *--pos = 0x06;      // unused bits
+            pos = putHeader(pos, 0x84, 2);
+            break;
+          case BasicType::Quality:
+            *--pos = static_cast<unsigned char>((v.integer << 3) & 0xF8);
+            *--pos = static_cast<unsigned char>((v.integer >> 5) & 0xFF);
+            *--pos = 0x03;      // unused bits
+            pos = putHeader(pos, 0x84, 3);
+            break;
+          case BasicType::Timestamp:
+            for (int i = 0; i < 8; i++)
+              *--pos = static_cast<unsigned char>(static_cast<uint64_t>(v.integer) >> (8 * i));
+            pos = putHeader(pos, 0x91, 8);
+            break;
+          default:
+            break;
+        }
+      }
+
+      const size_t size = static_cast<size_t>(end - pos);
+      std::memmove(out, pos, size);
+      return size;
+    }
+
+    /* Decodes allData into values (values() of them): false if it is not an encoding of the DataSet
+     * (type, length or number of a value). Values are left partly written on failure.
+     */
+    bool decode(const unsigned char *allData, size_t len, DataValue *values) const {
+      const unsigned char *pos = allData;
+      const unsigned char *limit[MAX_DEPTH + 1];
+      int depth{0};
+      limit[0] = allData + len;
+
+      for (const Step &step : m_steps)
+      {
+        if (step.kind == Step::End)
+        {
+          if (pos != limit[depth--])
+            return false;
+          continue;
+        }
+
+        unsigned char tag{};
+        const unsigned char *value{nullptr};
+        size_t n{0};
+        if (!ber_element(pos, limit[depth], tag, value, n))
+          return false;
+        pos = value + n;
+        if (step.kind == Step::Begin)
+        {
+          if (tag != 0xA2)
+            return false;
+          limit[++depth] = pos;
+          pos = value;
+          continue;
+        }
+
+        DataValue &v = values[step.value];
+        switch (m_types[step.value])
+        {
+          case BasicType::Boolean:
+            if (tag != 0x83 || n != 1)
+              return false;
+            v.integer = value[0] != 0;
+            break;
+          case BasicType::Int8: case BasicType::Int16: case BasicType::Int32: case BasicType::Enum:
+          {
+            if (tag != 0x85 || n < 1 || n > 4)
+              return false;
+            int64_t x = static_cast<int8_t>(value[0]);
+            for (size_t i = 1; i < n; i++)
+              x = x * 256 + value[i];
+            v.integer = x;
+            break;
+          }
+          case BasicType::Int8U: case BasicType::Int16U: case BasicType::Int32U:
+          {
+            if (tag != 0x86 || n < 1 || n > 5 || (value[0] & 0x80) || (n == 5 && value[0] != 0))
+              return false;
+            int64_t x{0};
+            for (size_t i = 0; i < n; i++)
+              x = x * 256 + value[i];
+            v.integer = x;
+            break;
+          }
+          case BasicType::Float32:
+          {
+            if (tag != 0x87 || n != 5 || value[0] != 0x08)
+              return false;
+            const uint32_t bits = (static_cast<uint32_t>(value[1]) << 24) | (value[2] << 16) | (value[3] << 8) | value[4];
+            std::memcpy(&v.real, &bits, sizeof(bits));
+            break;
+          }
+          case BasicType::Dbpos:
+            if (tag != 0x84 || n != 2 || value[0] > 6)
+              return false;
+            v.integer = value[1] >> 6;
+            break;
+          case BasicType::Quality:
+            if (tag != 0x84 || n < 2 || n > 3 || value[0] > 7)
+              return false;
+            v.integer = (value[1] << 5) | ((n == 3) ? (value[2] >> 3) : 0);
+            break;
+          case BasicType::Timestamp:
+          {
+            if (tag != 0x91 || n != 8)
+              return false;
+            uint64_t x{0};
+            for (size_t i = 0; i < 8; i++)
+              x = (x << 8) | value[i];
+            v.integer = static_cast<int64_t>(x);
+            break;
+          }
+          default:
+            return false;
+        }
+      }
+      return pos == limit[0];
+    }
+
+  private:
+    struct Step
+    {
+      enum Kind : uint8_t { Value, Begin, End };
+      Kind     kind{Value};
+      uint32_t value{0};        // index of the basic value (Value)
+    };
+
+    // Largest encoding of a value (and of every structure's header), in bytes
+    size_t add(const TypedValue &typed, const std::string &name, int depth) {
+      if (typed.type != BasicType::Struct)
+      {
+        m_steps.push_back(Step{Step::Value, static_cast<uint32_t>(m_names.size())});
+        m_names.push_back(name);
+        m_types.push_back(typed.type);
+        static const size_t maxSizes[] = {3, 6, 6, 6, 7, 7, 7, 7, 6, 4, 5, 10};
+        const size_t size = maxSizes[static_cast<unsigned int>(typed.type)];
+        m_maxSize += (depth == 0) ? size : 0;
+        return size;
+      }
+      if (depth >= MAX_DEPTH || typed.members.empty())
+      {
+        m_good = false;
+        return 0;
+      }
+
+      m_steps.push_back(Step{Step::Begin, 0});
+      size_t content{0};
+      for (const TypedValue &member : typed.members)
+        content += add(member, name + '.' + member.name, depth + 1);
+      m_steps.push_back(Step{Step::End, 0});
+      const size_t size = 1 + ((content < 0x80) ? 1 : (content <= 0xFF) ? 2 : 3) + content;
+      m_maxSize += (depth == 0) ? size : 0;
+      return size;
+    }
+
+    // Writes Tag and Length before pos, backwards: returns the new start
+    static unsigned char* putHeader(unsigned char *pos, unsigned char tag, size_t len) {
+      if (len < 0x80)
+      {
+        *--pos = static_cast<unsigned char>(len);
+      }
+      else if (len <= 0xFF)
+      {
+        *--pos = static_cast<unsigned char>(len);
+        *--pos = 0x81;
+      }
+      else
+      {
+        *--pos = static_cast<unsigned char>(len & 0xFF);
+        *--pos = static_cast<unsigned char>(len >> 8);
+        *--pos = 0x82;
+      }
+      *--pos = tag;
+      return pos;
+    }
+
+    std::vector<Step>         m_steps{};
+    std::vector<std::string>  m_names{};        // of each basic value, e.g. "Pos.stVal" or "A.phsA.cVal.mag.f"
+    std::vector<BasicType>    m_types{};
+    size_t                    m_entries{0};
+    size_t                    m_maxSize{0};
+    bool                      m_good{false};
+};
+
+/* Plan of the DataSet of an R-GOOSE Control Block, or nullptr if its DataSet could not be typed
+ * (its allData is then sent and received as is)
+ */
+std::shared_ptr<const DatasetPlan> dataset_plan(const std::vector<TypedDataSet> &dataSets, const ControlBlock &cb,
+                                                std::ostream &log = std::cout)
+{
+    for (const TypedDataSet &dataSet : dataSets)
+    {
+        if (dataSet.cbType != cb.cbType || cb.hostIED != dataSet.iedName || cb.cbName != dataSet.cbName)
+            continue;
+        if (!dataSet.error.empty())
+        {
+            log << "[!] DataSet " << dataSet.datSetName << " of " << dataSet.iedName << " not typed (" << dataSet.error << ")\n";
+            return nullptr;
+        }
+        std::shared_ptr<const DatasetPlan> plan = std::make_shared<const DatasetPlan>(dataSet.entries);
+        if (!plan->isGood())
+        {
+            log << "[!] DataSet " << dataSet.datSetName << " of " << dataSet.iedName << " too large or too deep to encode\n";
+            return nullptr;
+        }
+        log << "[*] DataSet " << dataSet.datSetName << " of " << dataSet.iedName << ": " << plan->entries()
+            << " entries, " << plan->values() << " values\n";
+        return plan;
+    }
+    return nullptr;
+}
+
+// Prints the values of a DataSet, one per line: "<tab>name = value"
+void print_dataset(std::ostream &out, const DatasetPlan &plan, const DataValue *values)
+{
+    static const char *const positions[] = {"intermediate", "off", "on", "bad"};
+    for (size_t i = 0; i < plan.values(); i++)
+    {
+        out << '\t' << plan.name(i) << " = ";
+        switch (plan.type(i))
+        {
+            case BasicType::Boolean:   out << (values[i].integer ? "true" : "false"); break;
+            case BasicType::Float32:   out << values[i].real; break;
+            case BasicType::Dbpos:     out << positions[values[i].integer & 0x03]; break;
+            case BasicType::Quality:   out << "0x" << std::hex << std::setfill('0') << std::setw(4) << values[i].integer << std::dec << std::setfill(' '); break;
+            case BasicType::Timestamp: out << "0x" << std::hex << std::setfill('0') << std::setw(16) << static_cast<uint64_t>(values[i].integer) << std::dec << std::setfill(' '); break;
+            default:                   out << values[i].integer; break;
+        }
+        out << '\n';
+    }
+}
+
+/* Circuit breaker position held by a DataSet: its first Dbpos (on: 1, off: 0), or else its first
+ * BOOLEAN; -1 if it has neither, or the Dbpos is intermediate or bad
+ */
+int dataset_position(const DatasetPlan &plan, const DataValue *values)
+{
+    for (size_t i = 0; i < plan.values(); i++)
+    {
+        if (plan.type(i) == BasicType::Dbpos)
+            return (values[i].integer == 2) ? 1 : (values[i].integer == 1) ? 0 : -1;
+    }
+    for (size_t i = 0; i < plan.values(); i++)
+    {
+        if (plan.type(i) == BasicType::Boolean)
+            return values[i].integer ? 1 : 0;
+    }
+    return -1;
+}
@@ -0,0 +1,685 @@
+/* Decoding of R-GOOSE and R-SV messages (IEC 61850-90-5 session, GOOSE/SV PDU in ASN.1 BER)
+ *
+ * valid_GSE_SMV() is the single entry point of every receive transport: it checks one UDP
+ * payload against one subscription and updates the subscription's records when it matches.
+ * The datagram is untrusted: it is read in one forward pass, and every length found in it is
+ * checked against the bytes left before it is used (ref: TlvReader).
+ */
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// For the dispatch tracepoint
+#include "tracepoints.hpp"
+
+#ifndef MAXBUFLEN
+#define MAXBUFLEN 1024
+#endif
+
+/* Converts an 8-byte UtcTime (ref: IEC 61850-8-1 / ISO 9506-2) to nanoseconds since the epoch:
+ * 4 bytes of seconds, 3 bytes of binary fraction of second (2^-24 s), 1 byte of time quality (ignored)
+ */
+uint64_t utc_time_ns(const unsigned char *t)
+{
+    uint64_t seconds  = (static_cast<uint64_t>(t[0]) << 24) | (t[1] << 16) | (t[2] << 8) | t[3];
+    uint64_t fraction = (static_cast<uint64_t>(t[4]) << 16) | (t[5] << 8) | t[6];
+    return seconds * 1'000'000'000 + ((fraction * 1'000'000'000) >> 24);
+}
+
+/* Values of an R-SV sequence of data: IEEE 754 single precision floats, big-endian (as formed by
+ * form_gse_smv.hpp). Writes at most max_count values to out and returns how many were written.
+ */
+size_t sv_float_values(const std::vector<unsigned char> &seqOfData, float *out, size_t max_count)
+{
+    size_t count = std::min(seqOfData.size() / 4, max_count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const unsigned char *v = &seqOfData[4 * i];
+        uint32_t bits = (static_cast<uint32_t>(v[0]) << 24) | (v[1] << 16) | (v[2] << 8) | v[3];
+        std::memcpy(&out[i], &bits, sizeof(float));
+    }
+    return count;
+}
+
+/* Sequence accounting of a stream (ref: StreamCounters) from the SPDU Number of a message that
+ * belongs to it. SPDU Numbers are compared modulo 2^32, so rollover needs no special case.
+ * Returns false if the SPDU is not newer than the latest one accepted (duplicated, reordered or
+ * late): such data is outdated and ignored. A newer SPDU only moves the sequence state once the
+ * whole message is well-formed and of this Control Block (ref: commit_spdu()), so that a malformed
+ * message can't put the stream ahead of its publisher; an outdated one is rejected whatever its
+ * content, and only counted. A well-formed message is received even if its stNum/sqNum, smpCnt or
+ * DataSet then reject it: its SPDU is not lost.
+ */
+bool account_spdu(StreamCounters &c, unsigned int spduNum)
+{
+    c.received++;
+    if (!c.spdu_seen)
+        return true;
+
+    const int32_t delta = static_cast<int32_t>(spduNum - c.highest_spduNum);
+    if (delta > 0)
+        return true;
+
+    const unsigned int age = static_cast<unsigned int>(-static_cast<int64_t>(delta));
+    if (age >= StreamCounters::REORDER_WINDOW)
+    {
+        c.late++;
+        return false;
+    }
+    const uint64_t bit = uint64_t{1} << age;
+    if (c.spdu_window & bit)
+    {
+        c.duplicated++;
+        return false;
+    }
+    c.spdu_window |= bit;
+    c.reordered++;
+    if (c.lost > 0)
+        c.lost--;
+    return false;
+}
+
+// Moves the sequence state of a stream on to the SPDU of a well-formed message, newer than the latest one (ref: account_spdu())
+void commit_spdu(StreamCounters &c, unsigned int spduNum)
+{
+    c.last_gap = 0;
+    if (!c.spdu_seen)
+    {
+        c.spdu_seen = true;
+        c.highest_spduNum = spduNum;
+        c.spdu_window = 1;
+        return;
+    }
+
+    const int32_t delta = static_cast<int32_t>(spduNum - c.highest_spduNum);
+    if (delta > 1)
+    {
+        // SPDUs skipped: lost, unless they show up later (reordered)
+        c.last_gap = delta - 1;
+        c.lost += c.last_gap;
+        size_t bucket = 31 - __builtin_clz(c.last_gap);
+        c.gap_sizes[std::min(bucket, StreamCounters::GAP_BUCKETS - 1)]++;
+    }
+    c.spdu_window = (static_cast<unsigned int>(delta) < StreamCounters::REORDER_WINDOW) ? (c.spdu_window << delta) | 1 : 1;
+    c.highest_spduNum = spduNum;
+}
+
+/* Forward-only reader of the Tag-Length-Values of a PDU, bounded by the end of the PDU.
+ * Every Length is checked against the bytes left before a Value is looked at, so a malformed
+ * message can't make the decoder read past the PDU (nor past the datagram).
+ * Lengths take the short form, or the long form of up to 2 bytes (ref: ber_element()): allData
+ * of large DataSets, and the GOOSE PDU that holds it, are 128 bytes or more.
+ */
+struct TlvReader
+{
+    struct Tlv
+    {
+        unsigned char        tag{};
+        const unsigned char *value{nullptr};
+        size_t               len{};
+    };
+
+    const unsigned char *pos;
+    const unsigned char *end;
+
+    size_t remaining() const
+    {
+        return (end > pos) ? static_cast<size_t>(end - pos) : 0;
+    }
+
+    bool atEnd() const
+    {
+        return pos == end;
+    }
+
+    // Reads the next TLV. Fails (reader unchanged) if the Value runs past the end.
+    bool next(Tlv &out)
+    {
+        if (pos >= end || !ber_element(pos, end, out.tag, out.value, out.len))
+            return false;
+        pos = out.value + out.len;
+        return true;
+    }
+
+    /* Opens a constructed TLV (GOOSE/SV PDU, Sequence of ASDU, ASDU) whose Length counts its own
+     * Tag and Length bytes, as formed by form_gse_smv.hpp: it must fill the rest of the reader.
+     */
+    bool enter(unsigned char tag)
+    {
+        if (remaining() < 2 || pos[0] != tag)
+            return false;
+        size_t header{2}, len{pos[1]};
+        if (pos[1] == 0x81 && remaining() >= 3)
+        {
+            header = 3;
+            len = pos[2];
+        }
+        else if (pos[1] == 0x82 && remaining() >= 4)
+        {
+            header = 4;
+            len = (static_cast<size_t>(pos[2]) << 8) | pos[3];
+        }
+        else if (pos[1] >= 0x80)
+        {
+            return false;
+        }
+        if (len != remaining())
+            return false;
+        pos += header;
+        return true;
+    }
+};
+
+// Big-endian unsigned integer Value of 1 to 4 bytes
+bool tlv_uint(const TlvReader::Tlv &f, unsigned int &out)
+{
+    if (f.len < 1 || f.len > 4)
+        return false;
+    out = 0;
+    for (size_t i = 0; i < f.len; i++)
+        out = (out << 8) | f.value[i];
+    return true;
+}
+
+// Visible string Value equal to `s`
+bool tlv_equals(const TlvReader::Tlv &f, const std::string &s)
+{
+    return f.len == s.size() && std::memcmp(f.value, s.data(), f.len) == 0;
+}
+
+/* Checks if received data conforms to R-GOOSE/R-SV specifications or not
+ * And if so, updates GOOSE Data Records as output parameter "cbOut"
+ * "result" gives the check that rejected the message, or the UtcTime of the message it accepted.
+ *
+ * Single forward pass over the datagram: fixed-size header fields lie within the 40 bytes
+ * checked first, and every length taken from the message is checked against the bytes left
+ * before anything it covers is read. No allocation once the records of cbOut have reached
+ * the size of the data values.
+ */
+bool valid_GSE_SMV(const unsigned char *buf, const int numbytes, GooseSvData &cbOut, DecodeResult &result)
+{
+    result.check = DecodeCheck::Length;
+    if ( (numbytes > MAXBUFLEN) || (numbytes < 40) )    // Data received should not be greater than assigned buffer length
+    {                                                   // Also, sum of length of header/footer >= 40 bytes
+        std::cerr << "[!] Error: Buffer length out of range\n";
+        return false;
+    }
+
+    result.check = DecodeCheck::Session;
+    bool          is_goose{};       // Control Block's type ("GSE" or "SMV") as decoded from Session Identifier (SI)
+    uint64_t      current_spduLen{};
+    unsigned int  current_spduNum{};
+    uint64_t      current_payloadLen{};
+    unsigned long current_appID{};
+    uint64_t      signature_idx{};
+    unsigned char signature_len{};
+
+    // Require LI = 0x01 and TI = 0x40
+    if ((buf[0] == 0x01) && (buf[1] == 0x40))
+    {
+        // SI = 0xA1 for R-GOOSE
+        if (buf[2] == 0xA1)
+        {
+            is_goose = true;
+        }
+        // SI = 0xA2 for R-SV
+        else if (buf[2] == 0xA2)
+        {
+            is_goose = false;
+        }
+        else
+        {
+            std::cerr << "[!] Error: Session protocol not implemented\n";
+            return false;
+        }
+    }
+    else
+    {
+        std::cerr << "[!] Error: Application profile unknown\n";
+        return false;
+    }
+
+    if ( (buf[3] != (buf[5] + 2)) || buf[4] != 0x80 )
+    {
+        std::cerr << "[!] Error in Common Header\n";
+        return false;
+    }
+
+    if (buf[14] != 0x00 || buf[15] != 0x01)
+    {
+        std::cerr << "[!] Error: Unexpected Session Protocol Version Number\n";
+        return false;
+    }
+
+    current_spduNum = (buf[10] << 24) + (buf[11] << 16)
+                        + (buf[12] << 8) + buf[13];
+    /* "Reused" SPDU Numbers are looked for once the message is known to belong to this
+     * Control Block (ref: APPID below): sequence accounting is kept per stream.
+     */
+
+    current_spduLen = (static_cast<uint64_t>(buf[6]) << 24) + (buf[7] << 16)
+                      + (buf[8] << 8) + buf[9];
+
+    // Security Information skipped in this implementation
+
+    // Payload Length's most significant byte is at index 28 (64-bit arithmetic: no wrap-around)
+    current_payloadLen = (static_cast<uint64_t>(buf[28]) << 24) + (buf[29] << 16)
+                         + (buf[30] << 8) + buf[31];
+    signature_idx = 28 + current_payloadLen;
+    if (signature_idx + 1 >= static_cast<uint64_t>(numbytes))
+    {
+        std::cerr << "[!] Error: Payload Length exceeds data received\n";
+        return false;
+    }
+
+    // Check Signature Block
+    if (buf[signature_idx] != 0x85)
+    {
+        std::cerr << "[!] Error in Signature\n";
+        return false;
+    }
+    signature_len = buf[signature_idx + 1];
+    if ((signature_idx + 2) + signature_len > static_cast<uint64_t>(numbytes))
+    {
+        std::cerr << "[!] Error: Signature Length exceeds data received\n";
+        return false;
+    }
+    /* Check index of last byte using two different computations:
+     *      (i) SPDU Length
+     *     (ii) Signature Length
+     */
+    // Index of least sig byte of SPDU Length = 9
+    if ( (9 + current_spduLen) != ((signature_idx + 1) + signature_len) )
+    {
+        std::cerr << "[!] Error: Inconsistent Lengths detected\n";
+        return false;
+    }
+
+    // No verification of HMAC in this implementation
+
+    /* Check Payload */
+    result.check = DecodeCheck::Payload;
+    // Pay-load type (at index 32)
+    if ( !(  (buf[32] == 0x81 && is_goose)
+          || (buf[32] == 0x82 && !is_goose) ) )
+    {
+        std::cerr << "[!] Error: Payload Type inconsistent with Session Identifier\n";
+        return false;
+    }
+    // Tunneled packets and Management APDUs omitted in this implementation
+
+    // Simulation (at index 33)
+    if (buf[33] != 0)
+    {
+        std::cerr << "[!] Error: Incorrect value detected in 'Simulation' field\n";
+        return false;
+    }
+
+    // APDU Length's most significant byte is at index 36
+    if (signature_idx != static_cast<uint64_t>(36 + (buf[36] << 8) + buf[37]))
+    {
+        std::cerr << "[!] Error: APDU Length in Payload\n";
+        return false;
+    }
+
+    // APPID (at indexes 34-35)
+    result.check = DecodeCheck::Appid;
+    current_appID = (buf[34] << 8) + buf[35];
+    if (current_appID != cbOut.appID)
+    {
+        std::cerr << "[!] Error: Incorrect appID in Payload\n";
+        return false;
+    }
+
+    // Message belongs to this stream: count it, and ignore it if its SPDU Number is outdated
+    IED_TRACE3(dispatch, current_appID, current_spduNum, numbytes);
+    result.check = DecodeCheck::SpduNumber;
+    if (!account_spdu(cbOut.counters, current_spduNum))
+        return false;       // No output prints if packet is out-of-order (assumes earlier packet(s) lost)
+
+    /* Check PDU
+     *  - First byte at index 38
+     *  - Last byte at index (signature_idx - 1)
+     */
+    result.check = DecodeCheck::Pdu;
+    TlvReader pdu{buf + 38, buf + signature_idx};
+    TlvReader::Tlv f{};
+
+    if (is_goose)
+    {
+        if (!pdu.enter(0x61))
+        {
+            std::cerr << "[!] Error: GOOSE PDU Tag/Length\n";
+            return false;
+        }
+
+        // gocbRef
+        if (!pdu.next(f) || f.tag != 0x80)
+        {
+            std::cerr << "[!] Error: goCBRef Tag/Length\n";
+            return false;
+        }
+        if (!tlv_equals(f, cbOut.cbName))
+        {
+            std::cerr << "[!] Error: goCBRef mismatch\n";
+            return false;
+        }
+
+        // timeAllowedToLive
+        // Supervised by the caller: the stream is lost if no valid GOOSE follows within this time
+        unsigned int current_timeAllowedToLive{};
+        if (!pdu.next(f) || f.tag != 0x81 || !tlv_uint(f, current_timeAllowedToLive))
+        {
+            std::cerr << "[!] Error: GOOSE timeAllowedToLive Tag/Length\n";
+            return false;
+        }
+
+        // datSet
+        if (!pdu.next(f) || f.tag != 0x82)
+        {
+            std::cerr << "[!] Error: GOOSE datSet Tag/Length\n";
+            return false;
+        }
+        if (!tlv_equals(f, cbOut.datSetName))
+        {
+            std::cerr << "[!] Error: datSet mismatch\n";
+            return false;
+        }
+
+        // goID
+        if (!pdu.next(f) || f.tag != 0x83)
+        {
+            std::cerr << "[!] Error: GOOSE goID Tag/Length\n";
+            return false;
+        }
+        // Other setups may have a goID different from gocbRef
+        // But for this implementation, goID is checked against cbName (= gocbRef)
+        if (!tlv_equals(f, cbOut.cbName))
+        {
+            std::cerr << "[!] Error: goID mismatch\n";
+            return false;
+        }
+
+        // timestamp
+        if (!pdu.next(f) || f.tag != 0x84 || f.len != 0x08)
+        {
+            std::cerr << "[!] Error: GOOSE t Tag/Length\n";
+            return false;
+        }
+        // t: time of the last change of state (set by this implementation's publisher for every message)
+        uint64_t current_t_ns = utc_time_ns(f.value);
+
+        // stNum
+        unsigned int current_stNum{};
+        if (!pdu.next(f) || f.tag != 0x85 || !tlv_uint(f, current_stNum))
+        {
+            std::cerr << "[!] Error: GOOSE stNum Tag/Length\n";
+            return false;
+        }
+
+        // sqNum
+        unsigned int current_sqNum{};
+        if (!pdu.next(f) || f.tag != 0x86 || !tlv_uint(f, current_sqNum))
+        {
+            std::cerr << "[!] Error: GOOSE sqNum Tag/Length\n";
+            return false;
+        }
+
+        // test
+        if (!pdu.next(f) || f.tag != 0x87 || f.len != 0x01 || f.value[0] != 0x00)
+        {
+            std::cerr << "[!] Error: GOOSE test Tag/Length/Value\n";
+            return false;
+        }
+
+        // ConfRev
+        if (!pdu.next(f) || f.tag != 0x88 || f.len != 0x01 || f.value[0] != 0x01)
+        {
+            std::cerr << "[!] Error: GOOSE ConfRev Tag/Length/Value\n";
+            return false;
+        }
+
+        // ndsCom
+        if (!pdu.next(f) || f.tag != 0x89 || f.len != 0x01 || f.value[0] != 0x00)
+        {
+            std::cerr << "[!] Error: GOOSE ndsCom Tag/Length/Value\n";
+            return false;
+        }
+
+        // numDatSetEntries
+        unsigned int current_numDatSetEntries{};
+        if (!pdu.next(f) || f.tag != 0x8A || !tlv_uint(f, current_numDatSetEntries))
+        {
+            std::cerr << "[!] Error: GOOSE numDatSetEntries Tag/Length\n";
+            return false;
+        }
+
+        // allData: last field of the PDU, holding exactly numDatSetEntries Values
+        TlvReader::Tlv allData{};
+        if (!pdu.next(allData) || allData.tag != 0xAB || !pdu.atEnd())
+        {
+            std::cerr << "[!] Error: GOOSE allData Tag/Length\n";
+            return false;
+        }
+        TlvReader entries{allData.value, allData.value + allData.len};
+        unsigned int values_read{0};
+        while (values_read < current_numDatSetEntries && entries.next(f))
+            values_read++;
+        if (values_read != current_numDatSetEntries || !entries.atEnd())
+        {
+            std::cerr << "[!] Error: allData Value(s)\n";
+            return false;
+        }
+        // Well-formed message of this Control Block: its SPDU is received, whether its content is accepted below or not
+        commit_spdu(cbOut.counters, current_spduNum);
+
+        bool allData_unchanged = std::equal(allData.value, allData.value + allData.len,
+                                            cbOut.prev_allData_Value.begin(), cbOut.prev_allData_Value.end());
+
+        /* Check:
+         *  stNum, sqNum, numDatSetEntries & allData
+         */
+        // Check stNum
+        result.check = DecodeCheck::Sequence;
+        if (current_stNum < cbOut.prev_stNum_Value)
+        {
+            std::cerr << "[!] Error: stNum\n"
+                      << "\tExpected stNum: >=" << (cbOut.prev_stNum_Value) << '\n'
+                      << "\tObserved stNum: " << current_stNum
+                      << "\tObserved sqNum: " << current_sqNum  << '\n';
+            return false;
+        }
+        // At this point, current stNum >= previous stNum
+        if (current_stNum != cbOut.prev_stNum_Value)
+        {
+            if ( allData_unchanged
+                && (current_stNum == cbOut.prev_stNum_Value + 1) )
+            {
+                std::cerr << "[!] Error: stNum incremented but allData not changed\n";
+                return false;
+            }
+        }
+        /* At this point, current stNum > previous stNum + 1 (i.e. some packet(s) lost)
+         *            or, current stNum == previous stNum + 1 && allData changed
+         *            or, current stNum == previous stNum
+         * All these scenarios are acceptable.
+         */
+        if (cbOut.prev_stNum_Value != 0 && current_stNum > cbOut.prev_stNum_Value + 1)
+            cbOut.counters.missed_state_changes += current_stNum - cbOut.prev_stNum_Value - 1;
+
+        // Check sqNum
+        if (current_stNum == cbOut.prev_stNum_Value)
+        {
+            // Check if sqNum is not increasing
+            if (current_sqNum <= cbOut.prev_sqNum_Value && cbOut.prev_sqNum_Value != UINT_MAX)
+            {
+                std::cerr << "[Info] sqNum reused - suspected duplication.\n";
+                cbOut.counters.duplicated++;
+                return false;
+            }
+        }
+        else
+        {
+            // Ensure receiver module is run before the sender module (otherwise this error will occur)
+            if (current_sqNum != 0)
+            {
+                std::cerr << "[!] Error: sqNum\n";
+                return false;
+            }
+        }
+
+        /* Typed DataSet (ref: datasetPlan.hpp): allData must be an encoding of it. Its values are
+         * decoded into the records (no allocation); on a mismatch, those of the latest allData are restored.
+         */
+        result.check = DecodeCheck::Dataset;
+        if (cbOut.datasetPlan && !allData_unchanged)
+        {
+            const DatasetPlan &plan = *cbOut.datasetPlan;
+            if (current_numDatSetEntries != plan.entries()
+                || !plan.decode(allData.value, allData.len, cbOut.datasetValues.data()))
+            {
+                if (!plan.decode(cbOut.prev_allData_Value.data(), cbOut.prev_allData_Value.size(), cbOut.datasetValues.data()))
+                    std::fill(cbOut.datasetValues.begin(), cbOut.datasetValues.end(), DataValue{});
+                std::cerr << "[!] Error: allData not an encoding of DataSet " << cbOut.datSetName << '\n';
+                return false;
+            }
+        }
+
+        // Update output parameter's variables (assign() reuses the records' storage)
+        cbOut.prev_spduNum = current_spduNum;
+        cbOut.prev_stNum_Value = current_stNum;
+        cbOut.prev_sqNum_Value = current_sqNum;
+        cbOut.prev_numDatSetEntries = current_numDatSetEntries;
+        if (!allData_unchanged)
+            cbOut.prev_allData_Value.assign(allData.value, allData.value + allData.len);
+        cbOut.timeAllowedToLive = current_timeAllowedToLive;
+        result.t_ns = current_t_ns;
+    }
+    else
+    {
+        /* Assume the following optional fields not present in ASDU:
+         *  - datSet
+         *  - refrTm
+         *  - smpRate
+         *  - SmpMod
+         */
+        if (!pdu.enter(0x60))
+        {
+            std::cerr << "[!] Error: SV PDU Tag/Length\n";
+            return false;
+        }
+
+        if (!pdu.next(f) || f.tag != 0x80 || f.len != 0x01 || f.value[0] != 0x01)
+        {
+            std::cerr << "[!] Error: noASDU Tag/Length/Value\n";
+            return false;
+        }
+
+        if (!pdu.enter(0xA2))
+        {
+            std::cerr << "[!] Error: Sequence-of-ASDUs Tag/Length\n";
+            return false;
+        }
+
+        if (!pdu.enter(0x30))
+        {
+            std::cerr << "[!] Error: ASDU Tag/Length\n";
+            return false;
+        }
+
+        // MsvID
+        if (!pdu.next(f) || f.tag != 0x80)
+        {
+            std::cerr << "[!] Error: MsvID Tag/Length\n";
+            return false;
+        }
+        if (!tlv_equals(f, cbOut.cbName))
+        {
+            std::cerr << "[!] Error: MsvID mismatch\n";
+            return false;
+        }
+
+        // smpCnt
+        unsigned int current_smpCnt{};
+        if (!pdu.next(f) || f.tag != 0x82 || f.len != 0x02 || !tlv_uint(f, current_smpCnt))
+        {
+            std::cerr << "[!] Error: smpCnt Tag/Length\n";
+            return false;
+        }
+
+        // confRev
+        unsigned int current_confRev{};
+        if (!pdu.next(f) || f.tag != 0x83 || f.len != 0x04 || !tlv_uint(f, current_confRev))
+        {
+            std::cerr << "[!] Error: confRev Tag/Length\n";
+            return false;
+        }
+        if (current_confRev != 0x01)
+        {
+            std::cerr << "[!] Error: SV ConfRev Value\n";
+            return false;
+        }
+
+        // smpSynch
+        if (!pdu.next(f) || f.tag != 0x85 || f.len != 0x01 || f.value[0] != 0x02)
+        {
+            std::cerr << "[!] Error: smpSynch Tag/Length/Value\n";
+            return false;
+        }
+
+        // Sample
+        TlvReader::Tlv seqOfData{};
+        if (!pdu.next(seqOfData) || seqOfData.tag != 0x87)
+        {
+            std::cerr << "[!] Error: sequenceofdata Tag/Length\n";
+            return false;
+        }
+
+        // timestamp: last field of the ASDU
+        if (!pdu.next(f) || f.tag != 0x89 || f.len != 0x08 || !pdu.atEnd())
+        {
+            std::cerr << "[!] Error: timestamp Tag/Length\n";
+            return false;
+        }
+        uint64_t current_t_ns = utc_time_ns(f.value);
+
+        // Well-formed message of this Control Block: its SPDU is received, whether its smpCnt is accepted or not
+        const bool first_sample = !cbOut.counters.spdu_seen;
+        commit_spdu(cbOut.counters, current_spduNum);
+
+        result.check = DecodeCheck::Sequence;
+        if ((current_smpCnt < cbOut.prev_smpCnt_Value) && (cbOut.prev_smpCnt_Value != 3999))
+        {
+            std::cerr << "[!] Error: smpCnt Value reused\n";
+            return false;
+        }
+
+        // smpCnt wraps at 4000 (50 Hz, 80 samples per cycle): samples skipped beyond the SPDUs lost on the way
+        if (!first_sample)
+        {
+            unsigned int skipped = (current_smpCnt + 4000 - cbOut.prev_smpCnt_Value - 1) % 4000;
+            if (skipped > cbOut.counters.last_gap)
+                cbOut.counters.sample_gaps += skipped - cbOut.counters.last_gap;
+        }
+
+        // Update output parameter's variables (assign() reuses the record's storage)
+        cbOut.prev_spduNum = current_spduNum;
+        cbOut.prev_smpCnt_Value = current_smpCnt;
+        cbOut.prev_seqOfData_Value.assign(seqOfData.value, seqOfData.value + seqOfData.len);
+        result.t_ns = current_t_ns;
+    }
+
+    return true;
+}
+
+// Same, for a caller that only needs to know whether the message was accepted
+bool valid_GSE_SMV(const unsigned char *buf, const int numbytes, GooseSvData &cbOut)
+{
+    DecodeResult result{};
+    return valid_GSE_SMV(buf, numbytes, cbOut, result);
+}
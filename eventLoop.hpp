@@ -0,0 +1,236 @@
+/* Single-threaded event loop built on epoll(7)
+ *
+ * Multiplexes every event source of an IED onto one thread:
+ *  - sockets (receive sockets, control socket)
+ *  - timerfd(2) timers (publishing pacing, supervision)
+ *  - signalfd(2) signals (graceful shutdown)
+ * The thread sleeps in epoll_wait() until at least one source is ready,
+ * so there is no polling and no periodic wake-up when nothing happens.
+ */
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+class EventLoop {
+  public:
+    // Called with the epoll event mask (EPOLLIN, EPOLLERR, ...) of a ready file descriptor
+    using FdHandler      = std::function<void(uint32_t events)>;
+    // Called with the number of timer expirations since the last call (normally 1)
+    using TimerHandler   = std::function<void(uint64_t expirations)>;
+    using SignalHandler  = std::function<void(const signalfd_siginfo &info)>;
+    // Called with a command received on the control socket; returned string is sent back as reply
+    using CommandHandler = std::function<std::string(const std::string &command)>;
+
+    EventLoop() {
+      m_epfd = epoll_create1(EPOLL_CLOEXEC);
+    }
+    ~EventLoop() {
+      // Close file descriptors created (and hence owned) by the loop itself
+      for (int fd : m_owned_fds)
+        close(fd);
+      if (isGood())
+        close(m_epfd);
+    }
+    // Don't need the other default operations
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+    EventLoop(EventLoop&&) = delete;
+    EventLoop& operator=(EventLoop&&) = delete;
+
+    bool isGood() const {
+      return m_epfd >= 0;
+    }
+
+    /* Registers a file descriptor (not owned by the loop) for the given epoll events */
+    bool addFd(int fd, uint32_t events, FdHandler handler) {
+      auto src = std::make_unique<Source>();
+      src->fd = fd;
+      src->handler = std::move(handler);
+
+      epoll_event ev{};
+      ev.events = events;
+      ev.data.ptr = src.get();
+      if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+        return false;
+
+      m_sources[fd] = std::move(src);
+      return true;
+    }
+
+    /* Unregisters a file descriptor (safe to call from within a handler) */
+    bool removeFd(int fd) {
+      auto it = m_sources.find(fd);
+      if (it == m_sources.end())
+        return false;
+
+      epoll_ctl(m_epfd, EPOLL_CTL_DEL, fd, nullptr);
+      // Handler may still be running (or pending in the current batch): retire it after the batch
+      it->second->active = false;
+      m_retired.push_back(std::move(it->second));
+      m_sources.erase(it);
+      return true;
+    }
+
+    /* Creates a monotonic timerfd that first fires after initial_ns and then every interval_ns
+     * (interval_ns = 0 for a one-shot timer). Returns the timer's fd, or -1 on error.
+     */
+    int addTimer(uint64_t initial_ns, uint64_t interval_ns, TimerHandler handler) {
+      int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+      if (tfd < 0)
+        return -1;
+
+      bool ok = addFd(tfd, EPOLLIN, [tfd, handler = std::move(handler)](uint32_t) {
+        uint64_t expirations{};
+        if (read(tfd, &expirations, sizeof(expirations)) == sizeof(expirations))
+          handler(expirations);
+      });
+      if (!ok || !rearmTimer(tfd, initial_ns, interval_ns)) {
+        removeFd(tfd);
+        close(tfd);
+        return -1;
+      }
+
+      m_owned_fds.push_back(tfd);
+      return tfd;
+    }
+
+    /* Re-arms a timer created by addTimer() (initial_ns = 0 disarms it) */
+    bool rearmTimer(int tfd, uint64_t initial_ns, uint64_t interval_ns) {
+      itimerspec spec{};
+      spec.it_value.tv_sec     = initial_ns / 1'000'000'000;
+      spec.it_value.tv_nsec    = initial_ns % 1'000'000'000;
+      spec.it_interval.tv_sec  = interval_ns / 1'000'000'000;
+      spec.it_interval.tv_nsec = interval_ns % 1'000'000'000;
+      return timerfd_settime(tfd, 0, &spec, nullptr) == 0;
+    }
+
+    /* Blocks the given signals for normal delivery and receives them through a signalfd instead.
+     * Must be called before any other thread is started (signal mask is inherited).
+     */
+    bool addSignals(std::initializer_list<int> signals, SignalHandler handler) {
+      sigset_t mask;
+      sigemptyset(&mask);
+      for (int sig : signals)
+        sigaddset(&mask, sig);
+      if (sigprocmask(SIG_BLOCK, &mask, nullptr) < 0)
+        return false;
+
+      int sfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+      if (sfd < 0)
+        return false;
+
+      bool ok = addFd(sfd, EPOLLIN, [sfd, handler = std::move(handler)](uint32_t) {
+        signalfd_siginfo info{};
+        while (read(sfd, &info, sizeof(info)) == sizeof(info))
+          handler(info);
+      });
+      if (!ok) {
+        close(sfd);
+        return false;
+      }
+
+      m_owned_fds.push_back(sfd);
+      return true;
+    }
+
+    /* Opens a Unix datagram control socket in the abstract namespace (no file left behind).
+     * Each datagram is one command; the handler's reply is sent back to the sender (if bound).
+     * Usage from a shell: socat - ABSTRACT-SENDTO:<name>
+     */
+    bool addControlSocket(const std::string &name, CommandHandler handler) {
+      sockaddr_un addr{};
+      addr.sun_family = AF_UNIX;
+      if (name.empty() || name.size() >= sizeof(addr.sun_path) - 1)
+        return false;
+      // Leading NUL byte selects the abstract namespace
+      name.copy(addr.sun_path + 1, name.size());
+      socklen_t addr_len = offsetof(sockaddr_un, sun_path) + 1 + name.size();
+
+      int cfd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if (cfd < 0)
+        return false;
+      if (bind(cfd, (sockaddr*)&addr, addr_len) < 0) {
+        close(cfd);
+        return false;
+      }
+
+      bool ok = addFd(cfd, EPOLLIN, [cfd, handler = std::move(handler)](uint32_t) {
+        char cmd_buf[256];
+        sockaddr_un peer{};
+        socklen_t peer_len{sizeof(peer)};
+        ssize_t n{};
+        while ((n = recvfrom(cfd, cmd_buf, sizeof(cmd_buf), 0, (sockaddr*)&peer, &peer_len)) >= 0) {
+          std::string command(cmd_buf, n);
+          // Tolerate commands typed interactively (trailing newline)
+          while (!command.empty() && (command.back() == '\n' || command.back() == '\r'))
+            command.pop_back();
+
+          std::string reply = handler(command);
+          if (!reply.empty() && peer_len > offsetof(sockaddr_un, sun_path))
+            sendto(cfd, reply.data(), reply.size(), MSG_DONTWAIT, (sockaddr*)&peer, peer_len);
+          peer_len = sizeof(peer);
+        }
+      });
+      if (!ok) {
+        close(cfd);
+        return false;
+      }
+
+      m_owned_fds.push_back(cfd);
+      return true;
+    }
+
+    /* Dispatches ready events until stop() is called (from a handler) */
+    void run() {
+      std::array<epoll_event, 64> events{};
+      m_running = true;
+
+      while (m_running) {
+        int n = epoll_wait(m_epfd, events.data(), events.size(), -1);
+        if (n < 0) {
+          if (errno == EINTR)
+            continue;
+          break;
+        }
+
+        for (int i = 0; i < n && m_running; i++) {
+          Source *src = static_cast<Source*>(events[i].data.ptr);
+          if (src->active)
+            src->handler(events[i].events);
+        }
+        m_retired.clear();
+      }
+    }
+
+    void stop() {
+      m_running = false;
+    }
+
+  private:
+    struct Source {
+      int       fd{-1};
+      bool      active{true};
+      FdHandler handler{};
+    };
+
+    int m_epfd = -1;
+    bool m_running = false;
+    std::map<int, std::unique_ptr<Source>> m_sources{};
+    std::vector<std::unique_ptr<Source>>   m_retired{};
+    std::vector<int>                       m_owned_fds{};
+};
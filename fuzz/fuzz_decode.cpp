@@ -0,0 +1,291 @@
+/* Fuzz harness of the R-GOOSE/R-SV decoder (valid_GSE_SMV() in decode_gse_smv.hpp)
+ *
+ * Every input is decoded against a GOOSE and an SV subscription, twice each, so the checks that
+ * depend on the previous message of the stream (stNum/sqNum, smpCnt, SPDU Number) run as well;
+ * then against a GOOSE subscription with a typed DataSet (allData decoded by its plan).
+ * The decoder must neither read outside the input nor trip a sanitizer, whatever the input.
+ *
+ * With clang++, built as a libFuzzer target:
+ *     make fuzz && build/fuzz/fuzz_decode [corpus dir]
+ * Otherwise (FUZZ_STANDALONE), a driver with AddressSanitizer/UBSan built in:
+ *     build/fuzz/fuzz_decode file...       replays the given inputs (e.g. crashes found by libFuzzer)
+ *     build/fuzz/fuzz_decode [iterations]  decodes random mutations of valid messages, formed as
+ *                                          ied_send does (run from the repository root for GOOSEdata.txt/SVdata.txt)
+ *     build/fuzz/fuzz_decode -seeds dir    writes those valid messages to dir, as a libFuzzer corpus
+ * The standalone driver also checks that an R-GOOSE whose numDatSetEntries doesn't match its allData
+ * is rejected (ref: entry_count_messages()), and that the SPDU of a message rejected by its stNum/sqNum
+ * or smpCnt is not counted lost (ref: check_rejected_spdu_not_lost()); it exits with status 1 otherwise.
+ */
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <climits>
+#include <cmath>
+
+// For ControlBlock (used by ied_utils.hpp)
+#include "parse_sed.hpp"
+// For the types of the DataSets and the encoding/decoding of typed allData
+#include "scl_types.hpp"
+#include "datasetPlan.hpp"
+
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ied_utils.hpp"
+
+#define MAXBUFLEN 1024
+
+#include "decode_gse_smv.hpp"
+
+#define FUZZ_GOOSE_CB  "FuzzIED/LLN0$GO$Fuzz"
+#define FUZZ_GOOSE_DS  "FuzzIED/LLN0$Fuzz"
+#define FUZZ_SV_CB     "FuzzIED/LLN0$SV$Fuzz"
+#define FUZZ_APPID     0x3001
+
+GooseSvData fuzz_subscription(const std::string &cbType)
+{
+    GooseSvData cb{};
+    cb.cbType = cb_type(cbType);
+    cb.cbName = (cbType == "GSE") ? FUZZ_GOOSE_CB : FUZZ_SV_CB;
+    cb.datSetName = FUZZ_GOOSE_DS;
+    cb.appID = FUZZ_APPID;
+    return cb;
+}
+
+// Typed DataSet of the GOOSE subscription: XCBR position, and a structure with a structure in it
+std::shared_ptr<const DatasetPlan> fuzz_plan()
+{
+    const TypedValue vector{"cVal", BasicType::Struct, {{"mag", BasicType::Float32, {}}, {"ang", BasicType::Float32, {}}}};
+    const std::vector<TypedValue> entries{
+        {"Pos", BasicType::Struct, {{"stVal", BasicType::Dbpos, {}}, {"q", BasicType::Quality, {}}, {"t", BasicType::Timestamp, {}}}},
+        {"OpCnt", BasicType::Int32, {}},
+        {"Cnt", BasicType::Int32U, {}},
+        {"Loc", BasicType::Boolean, {}},
+        {"A", BasicType::Struct, {vector, {"q", BasicType::Quality, {}}}},
+    };
+    return std::make_shared<const DatasetPlan>(entries);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static bool quiet = []() { std::cerr.rdbuf(nullptr); return true; }();    // Decoder errors are expected here
+    (void)quiet;
+    if (size > INT_MAX)
+        return 0;
+
+    for (const char *cbType : {"GSE", "SMV"})
+    {
+        GooseSvData cb = fuzz_subscription(cbType);
+        valid_GSE_SMV(data, static_cast<int>(size), cb);
+        valid_GSE_SMV(data, static_cast<int>(size), cb);
+    }
+
+    static const std::shared_ptr<const DatasetPlan> plan = fuzz_plan();
+    GooseSvData typed = fuzz_subscription("GSE");
+    typed.datasetPlan = plan;
+    typed.datasetValues.resize(plan->values());
+    valid_GSE_SMV(data, static_cast<int>(size), typed);
+    valid_GSE_SMV(data, static_cast<int>(size), typed);
+    return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+
+#include <fstream>
+#include <iterator>
+#include <random>
+
+#include "form_gse_smv.hpp"
+
+/* R-GOOSE whose numDatSetEntries doesn't match its allData: declaring more Values than allData holds,
+ * or fewer (bytes left over). Both must be rejected; they also seed mutations around that check.
+ */
+std::vector<std::vector<unsigned char>> entry_count_messages()
+{
+    GooseSvData cb = fuzz_subscription("GSE");
+    cb.goose_counter = 1;
+    std::vector<unsigned char> message{};
+    form_udp_data(cb, message);
+
+    std::vector<std::vector<unsigned char>> mismatched{};
+    for (size_t i = 38; i + 3 < message.size(); i++)
+    {
+        // numDatSetEntries (1-byte Value) just before allData
+        if (message[i] == 0x8A && message[i + 1] == 0x01 && message[i + 3] == 0xAB)
+        {
+            for (unsigned char entries : {static_cast<unsigned char>(message[i + 2] + 1), static_cast<unsigned char>(200),
+                                          static_cast<unsigned char>(message[i + 2] - 1)})
+            {
+                mismatched.push_back(message);
+                mismatched.back()[i + 2] = entries;
+            }
+            break;
+        }
+    }
+    std::streambuf *cerr_buf = std::cerr.rdbuf(nullptr);    // Their rejection is expected
+    for (const std::vector<unsigned char> &m : mismatched)
+    {
+        GooseSvData subscription = fuzz_subscription("GSE");
+        if (valid_GSE_SMV(m.data(), static_cast<int>(m.size()), subscription))
+            std::cout << "[!] R-GOOSE accepted with numDatSetEntries not matching allData\n";
+    }
+    std::cerr.rdbuf(cerr_buf);
+    if (mismatched.empty())
+        std::cout << "[!] numDatSetEntries not found in the R-GOOSE seed\n";
+    return mismatched;
+}
+
+// Valid messages of both types, and of the typed DataSet, as published by ied_send (then the mismatched R-GOOSE)
+std::vector<std::vector<unsigned char>> seed_messages()
+{
+    std::vector<std::vector<unsigned char>> seeds{};
+    for (const char *cbType : {"GSE", "SMV", "typed"})
+    {
+        const bool typed{std::string(cbType) == "typed"};
+        GooseSvData cb = fuzz_subscription(typed ? "GSE" : cbType);
+        cb.goose_counter = 1;
+        cb.sv_counter = 1;
+        // The seeds of a stream must be accepted in order: mutations then start from valid messages
+        GooseSvData subscription = fuzz_subscription(typed ? "GSE" : cbType);
+        if (typed)
+        {
+            cb.datasetPlan = subscription.datasetPlan = fuzz_plan();
+            cb.datasetValues.resize(cb.datasetPlan->values());
+            subscription.datasetValues.resize(cb.datasetPlan->values());
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            std::vector<unsigned char> message{};
+            form_udp_data(cb, message);
+            if (!valid_GSE_SMV(message.data(), static_cast<int>(message.size()), subscription))
+                std::cout << "[!] Seed message rejected by the decoder\n";
+            seeds.push_back(message);
+        }
+    }
+    for (std::vector<unsigned char> &message : entry_count_messages())
+        seeds.push_back(std::move(message));
+    return seeds;
+}
+
+/* Sequence accounting of a stream with a well-formed message rejected by its content: its SPDU is
+ * received, not lost. SPDUs 0, 1, 2 (an earlier message again: GOOSE sqNum or SV smpCnt reused), 3.
+ * Returns false if the counters are wrong.
+ */
+bool check_rejected_spdu_not_lost()
+{
+    bool good{true};
+    std::streambuf *cerr_buf = std::cerr.rdbuf(nullptr);    // The rejection of SPDU 2 is expected
+    for (const char *cbType : {"GSE", "SMV"})
+    {
+        GooseSvData cb = fuzz_subscription(cbType);
+        cb.goose_counter = 1;
+        cb.sv_counter = 1;
+        std::vector<std::vector<unsigned char>> formed(3);
+        for (std::vector<unsigned char> &message : formed)
+            form_udp_data(cb, message);
+
+        // SPDU Number (bytes 10-13 of the session header) of message i set to spdu
+        auto with_spdu = [&formed](size_t i, unsigned int spdu) {
+            std::vector<unsigned char> message = formed[i];
+            const unsigned int first = (message[10] << 24) | (message[11] << 16) | (message[12] << 8) | message[13];
+            for (int b = 0; b < 4; b++)
+                message[10 + b] = static_cast<unsigned char>((first - i + spdu) >> (24 - 8 * b));
+            return message;
+        };
+        const bool goose{std::string(cbType) == "GSE"};
+        const std::vector<std::vector<unsigned char>> sequence{with_spdu(0, 0), with_spdu(1, 1),
+                                                                with_spdu(goose ? 1 : 0, 2), with_spdu(2, 3)};
+        GooseSvData subscription = fuzz_subscription(cbType);
+        size_t accepted{0};
+        for (const std::vector<unsigned char> &message : sequence)
+            accepted += valid_GSE_SMV(message.data(), static_cast<int>(message.size()), subscription);
+
+        const StreamCounters &c = subscription.counters;
+        if (accepted != 3 || c.received != 4 || c.lost != 0 || (goose && c.duplicated != 1))
+        {
+            std::cout << "[!] " << cbType << " SPDUs 0-3 with SPDU 2 rejected: " << accepted << " accepted, received "
+                      << c.received << ", lost " << c.lost << ", duplicated " << c.duplicated << '\n';
+            good = false;
+        }
+    }
+    std::cerr.rdbuf(cerr_buf);
+    return good;
+}
+
+// Replaces a byte, a length-like byte, a run of bytes, or truncates/extends the message
+void mutate(std::vector<unsigned char> &m, std::mt19937 &rng)
+{
+    int mutations = 1 + rng() % 4;
+    for (int i = 0; i < mutations && !m.empty(); i++)
+    {
+        size_t at = rng() % m.size();
+        switch (rng() % 6)
+        {
+            case 0: m[at] = static_cast<unsigned char>(rng()); break;
+            case 1: m[at] ^= static_cast<unsigned char>(1 << (rng() % 8)); break;
+            case 2: m[at] = static_cast<unsigned char>(m[at] + 1 - rng() % 3); break;
+            case 3: m[at] = (rng() % 2) ? 0xFF : 0x00; break;
+            case 4: m.resize(at); break;
+            case 5: m.insert(m.begin() + at, rng() % 16, static_cast<unsigned char>(rng())); break;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc == 3 && std::string(argv[1]) == "-seeds")
+    {
+        std::vector<std::vector<unsigned char>> seeds = seed_messages();
+        for (size_t i = 0; i < seeds.size(); i++)
+        {
+            std::ofstream out(std::string(argv[2]) + "/seed" + std::to_string(i), std::ios::binary);
+            out.write(reinterpret_cast<const char*>(seeds[i].data()), seeds[i].size());
+        }
+        std::cout << "Wrote " << seeds.size() << " seed(s) to " << argv[2] << '\n';
+        return 0;
+    }
+
+    if (argc > 1 && std::string(argv[1]).find_first_not_of("0123456789") != std::string::npos)
+    {
+        // Replay of given inputs
+        for (int i = 1; i < argc; i++)
+        {
+            std::ifstream in(argv[i], std::ios::binary);
+            std::vector<unsigned char> input{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+            std::cout << "Replayed " << argv[i] << " (" << input.size() << " bytes)\n";
+        }
+        return 0;
+    }
+
+    unsigned long long iterations = (argc > 1) ? std::stoull(argv[1]) : 1'000'000;
+    if (!check_rejected_spdu_not_lost())
+        return 1;
+    std::vector<std::vector<unsigned char>> seeds = seed_messages();
+    std::mt19937 rng{12345};
+    for (unsigned long long n = 0; n < iterations; n++)
+    {
+        std::vector<unsigned char> input = seeds[rng() % seeds.size()];
+        mutate(input, rng);
+        // Exact-size heap copy: any read past the input is caught by AddressSanitizer
+        std::unique_ptr<unsigned char[]> exact{new unsigned char[input.size() ? input.size() : 1]};
+        std::memcpy(exact.get(), input.data(), input.size());
+        LLVMFuzzerTestOneInput(exact.get(), input.size());
+    }
+    std::cout << "Decoded " << iterations << " mutated message(s) against the subscriptions\n";
+    return 0;
+}
+
+#endif
@@ -4,16 +4,24 @@
 #include <cmath>
 #include <ctime>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <climits>
 
 // For parsing SED file (in XML format)
 #include "parse_sed.hpp"
+// For the types of the DataSets and the encoding/decoding of typed allData
+#include "scl_types.hpp"
+#include "datasetPlan.hpp"
+// For the compiled configuration (binary image of the parsed SED file and its DataSet types)
+#include "sed_cache.hpp"
 
 // For netdevice - low-level access to Linux network devices
 #include <sys/ioctl.h>
@@ -26,571 +34,380 @@
 #include <sys/types.h>
 #include "udpSock.hpp"
 #include "zz_diagnose.hpp"
+#include <fcntl.h>
+#include <memory>
+
+// For kernel receive timestamps and per-stream latency histograms
+#include "rxTimestamp.hpp"
+#include "latencyHistogram.hpp"
+// For aligning R-SV streams by smpCnt (line differential protection)
+#include "svAligner.hpp"
+// For the line differential (87L) element on aligned R-SV streams
+#include "lineDiff.hpp"
+// For phasor (DFT) and RMS estimation on the aligned R-SV samples
+#include "phasorEstimator.hpp"
+
+// For receiving from a memory-mapped AF_PACKET ring or an AF_XDP socket instead of a UDP socket
+#include "packetRing.hpp"
+#include "xdpSock.hpp"
+// For batched (recvmmsg) or io_uring reception on the UDP socket
+#include "mmsgRecv.hpp"
+#include "uringRecv.hpp"
+
+// For multiplexing sockets, signals and timers on one thread
+#include "eventLoop.hpp"
+// For GOOSE timeAllowedToLive supervision
+#include "timingWheel.hpp"
 
 // For IED operations/debugging
 #include "ied_utils.hpp"
+// For the metrics endpoint (counters of the receive path and of every stream)
+#include "metrics.hpp"
+
+// For reloading the SED file while receiving (subscription table replaced in place)
+#include "sedReload.hpp"
 
 #define IEDUDPPORT 102
 #define MAXBUFLEN 1024
 
-// Checks if received data conforms to R-GOOSE/R-SV specifications or not
-// And if so, updates GOOSE Data Records as output parameter "cbOut"
-bool valid_GSE_SMV(const unsigned char (&buf)[MAXBUFLEN], const int numbytes, GooseSvData &cbOut)
+// For decoding R-GOOSE/R-SV messages
+#include "decode_gse_smv.hpp"
+// For forming and sending the trip R-GOOSE of the 87L element
+#include "form_gse_smv.hpp"
+#include "publishMessage.hpp"
+
+// Milliseconds on the monotonic clock (tick of the timeAllowedToLive timing wheel)
+uint64_t monotonic_ms()
 {
-    if ( (numbytes > MAXBUFLEN) || (numbytes < 40) )    // Data received should not be greater than assigned buffer length
-    {                                                   // Also, sum of length of header/footer >= 40 bytes
-        std::cerr << "[!] Error: Buffer length out of range\n";
-        return false;
-    }
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1'000'000;
+}
 
-    std::string   sess_prot{};      // To store Control Block's type ("GSE" or "SMV") as decoded from Session Identifier (SI)
-    unsigned int  current_spduLen{};
-    unsigned int  current_spduNum{};
-    unsigned int  current_payloadLen{};
-    unsigned long current_appID{};
-    size_t        signature_idx{};
-    unsigned char signature_len{};
+/* One-way latency (kernel receive timestamp - UtcTime of the message) of each subscribed stream,
+ * as p50/p99/p99.9/max, and the best IEC 61850-5 transfer time class met by every message
+ * (TT6 = 3 ms: trips and blockings). Publisher and subscriber clocks must be synchronised (e.g. PTP).
+ * The histograms are those of the streams' metrics (ref: StreamMetrics::latency()).
+ */
+std::string latency_report(const std::vector<GooseSvData> &streams)
+{
+    // IEC 61850-5 transfer time classes, from the most demanding
+    static const std::array<std::pair<const char*, uint64_t>, 6> transferTimeClasses{{
+        {"TT6", 3'000'000}, {"TT5", 10'000'000}, {"TT4", 20'000'000},
+        {"TT3", 100'000'000}, {"TT2", 500'000'000}, {"TT1", 1'000'000'000}
+    }};
+    auto ms = [](uint64_t ns)
+    {
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(3) << ns / 1e6 << " ms";
+        return oss.str();
+    };
 
-    // Require LI = 0x01 and TI = 0x40
-    if ((buf[0] == 0x01) && (buf[1] == 0x40))
+    std::string report{};
+    for (size_t i = 0; i < streams.size(); i++)
     {
-        // SI = 0xA1 for R-GOOSE
-        if (buf[2] == 0xA1)
-        {
-            sess_prot = "GSE";
-        }
-        // SI = 0xA2 for R-SV
-        else if (buf[2] == 0xA2)
+        const LatencyHistogram &h = streams[i].metrics->latency();
+        report += streams[i].cbName + ": " + std::to_string(h.count()) + " message(s)";
+        if (h.count() == 0)
         {
-            sess_prot = "SMV";
+            report += "\n";
+            continue;
         }
-        else
+        report += ", p50 " + ms(h.percentile(0.50)) + ", p99 " + ms(h.percentile(0.99))
+                + ", p99.9 " + ms(h.percentile(0.999)) + ", max " + ms(h.max());
+
+        const char *met = "none";
+        for (const auto &tt : transferTimeClasses)
         {
-            std::cerr << "[!] Error: Session protocol not implemented\n";
-            return false;
+            if (h.max() <= tt.second)
+            {
+                met = tt.first;
+                break;
+            }
         }
+        uint64_t within_3ms = h.countAtOrBelow(transferTimeClasses[0].second);
+        std::ostringstream pct;
+        pct << std::fixed << std::setprecision(3) << 100.0 * within_3ms / h.count();
+        report += ", " + pct.str() + "% within 3 ms, class met: " + met;
+        if (h.negativeCount())
+            report += " (" + std::to_string(h.negativeCount()) + " message(s) stamped in the future: clocks not synchronised?)";
+        report += "\n";
     }
-    else
-    {
-        std::cerr << "[!] Error: Application profile unknown\n";
-        return false;
-    }
-
-    if ( (buf[3] != (buf[5] + 2)) || buf[4] != 0x80 )
-    {
-        std::cerr << "[!] Error in Common Header\n";
-        return false;
-    }
+    return report;
+}
 
-    if (buf[14] != 0x00 || buf[15] != 0x01)
-    {
-        std::cerr << "[!] Error: Unexpected Session Protocol Version Number\n";
-        return false;        
-    }
-    
-    current_spduNum = (buf[10] << 24) + (buf[11] << 16) 
-                        + (buf[12] << 8) + buf[13];
-    /* Exclude initialization scenario (previous = 0)
-     *   and exclude rollover scenario (previous = UINT_MAX, current = 0).
-     * Look for "reused" SPDU Number.
-     */
-    if (!( (cbOut.prev_spduNum == 0) || (current_spduNum == 0 && cbOut.prev_spduNum == UINT_MAX) )
-            && current_spduNum <= cbOut.prev_spduNum)
+/* Loss, reorder and duplicate accounting of each subscribed stream (ref: StreamCounters), and the
+ * datagrams dropped by the receiver itself. Streams with losses while the receiver drops nothing
+ * point to the network; receiver drops point to overload of this IED.
+ */
+std::string stream_report(const std::vector<GooseSvData> &streams, uint64_t receiver_drops)
+{
+    std::string report{};
+    for (const GooseSvData &cb : streams)
     {
-        /* std::cout << "[Info] Outdated SPDU Number. Data ignored.\n"
-         *           << "\tExpected SPDU Number: " << (cbOut.prev_spduNum + 1) << '\n'
-         *           << "\tObserved SPDU Number: " << current_spduNum << '\n';
-         */
-        return false;
-    } // No output prints if packet is out-of-order (assumes earlier packet(s) lost)    
-
-    current_spduLen = (buf[6] << 24) + (buf[7] << 16) 
-                      + (buf[8] << 8) + buf[9];
-
-    // Security Information skipped in this implementation
-
-    // Payload Length's most significant byte is at index 28
-    current_payloadLen = (buf[28] << 24) + (buf[29] << 16) 
-                         + (buf[30] << 8) + buf[31];
-    signature_idx = 28 + current_payloadLen;
+        const StreamCounters &c = cb.counters;
+        report += cb.cbName + ": received " + std::to_string(c.received)
+                + ", lost " + std::to_string(c.lost)
+                + ", reordered " + std::to_string(c.reordered)
+                + ", duplicated " + std::to_string(c.duplicated)
+                + ", late " + std::to_string(c.late);
+        if (cb.cbType == CbType::GSE)
+            report += ", missed state changes " + std::to_string(c.missed_state_changes);
+        else
+            report += ", smpCnt gaps " + std::to_string(c.sample_gaps);
 
-    // Check Signature Block
-    if (buf[signature_idx] != 0x85)
-    {
-        std::cerr << "[!] Error in Signature\n";
-        return false;
-    }
-    /* Check index of last byte using two different computations:
-     *      (i) SPDU Length
-     *     (ii) Signature Length
-     */
-    signature_len = buf[signature_idx + 1];
-    // Index of least sig byte of SPDU Length = 9
-    if ( (9 + current_spduLen) != ((signature_idx + 1) + signature_len) )
-    {
-        std::cerr << "[!] Error: Inconsistent Lengths detected\n";
-        return false;        
+        // Gap sizes, as "size range: count" for the non-empty buckets
+        std::string gaps{};
+        for (size_t k = 0; k < StreamCounters::GAP_BUCKETS; k++)
+        {
+            if (c.gap_sizes[k] == 0)
+                continue;
+            const unsigned long long low = 1ull << k, high = (2ull << k) - 1;
+            gaps += (gaps.empty() ? "" : ", ") + std::to_string(low)
+                  + (k == StreamCounters::GAP_BUCKETS - 1 ? "+" : (high > low ? "-" + std::to_string(high) : ""))
+                  + ": " + std::to_string(c.gap_sizes[k]);
+        }
+        if (!gaps.empty())
+            report += " (gap sizes " + gaps + ")";
+        report += "\n";
     }
+    report += "dropped by receiver (queue/ring full): " + std::to_string(receiver_drops) + "\n";
+    return report;
+}
 
-    // No verification of HMAC in this implementation
-
-    /* Check Payload */
-    // Pay-load type (at index 32)
-    if ( !(  (buf[32] == 0x81 && sess_prot == "GSE")
-          || (buf[32] == 0x82 && sess_prot == "SMV") ) )
+/* Alignment of the subscribed R-SV streams by smpCnt (ref: svAligner.hpp): sample sets released
+ * complete or incomplete, and per stream the lag behind the first arrival of each set. The spread
+ * of the streams' one-way latencies (p50) is the channel latency asymmetry.
+ */
+std::string alignment_report(const std::vector<GooseSvData> &streams, const std::vector<int> &svStream,
+                             const SvAligner &aligner)
+{
+    auto ms = [](uint64_t ns)
     {
-        std::cerr << "[!] Error: Payload Type inconsistent with Session Identifier\n";
-        return false;   
-    }
-    // Tunneled packets and Management APDUs omitted in this implementation
-
-    // Simulation (at index 33)
-    if (buf[33] != 0)
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(3) << ns / 1e6 << " ms";
+        return oss.str();
+    };
+
+    std::string report = std::to_string(aligner.streams()) + " stream(s), wait " + ms(aligner.maxWaitNs())
+                       + ", " + std::to_string(aligner.slots()) + " slots: "
+                       + std::to_string(aligner.completeSets()) + " complete set(s), "
+                       + std::to_string(aligner.incompleteSets()) + " incomplete ("
+                       + std::to_string(aligner.overrunSets()) + " forced out by ring overrun), "
+                       + std::to_string(aligner.duplicated()) + " duplicated sample(s)\n";
+
+    // Fastest channel: reference for the latency asymmetry
+    uint64_t fastest{UINT64_MAX};
+    for (size_t i = 0; i < streams.size(); i++)
     {
-        std::cerr << "[!] Error: Incorrect value detected in 'Simulation' field\n";
-        return false; 
+        if (svStream[i] >= 0 && streams[i].metrics->latency().count())
+            fastest = std::min(fastest, streams[i].metrics->latency().percentile(0.50));
     }
 
-    // APDU Length's most significant byte is at index 36
-    if (signature_idx != (36 + (buf[36] << 8) + buf[37]))
+    for (size_t i = 0; i < streams.size(); i++)
     {
-        std::cerr << "[!] Error: APDU Length in Payload\n";
-        return false;     
+        if (svStream[i] < 0)
+            continue;
+        const LatencyHistogram &lag = aligner.lag(svStream[i]);
+        report += streams[i].cbName + ": lag behind first arrival p50 " + ms(lag.percentile(0.50))
+                + ", p99 " + ms(lag.percentile(0.99)) + ", max " + ms(lag.max())
+                + ", missing from " + std::to_string(aligner.missing(svStream[i])) + " set(s)"
+                + ", late " + std::to_string(aligner.late(svStream[i]));
+        const LatencyHistogram &latency = streams[i].metrics->latency();
+        if (latency.count())
+            report += ", one-way latency p50 " + ms(latency.percentile(0.50))
+                    + " (asymmetry +" + ms(latency.percentile(0.50) - fastest) + ")";
+        report += "\n";
     }
+    return report;
+}
 
-    // APPID (at indexes 34-35)
-    current_appID = (buf[34] << 8) + buf[35];
-    if (current_appID != std::stoul(cbOut.appID, nullptr, 16))
-    {
-        std::cerr << "[!] Error: Incorrect appID in Payload\n";
-        return false; 
-    }
+/* Reads the 87L settings file: one "key value" pair per line, '#' starts a comment.
+ * Slopes are given in percent. trip_cbName, trip_datSet, trip_appID and trip_multicastIP
+ * describe the R-GOOSE Control Block on which this IED publishes the trip decision.
+ */
+bool read_line_diff_settings(const char *filename, LineDiffSettings &settings, GooseSvData &tripCb)
+{
+    std::ifstream file(filename);
+    if (!file.is_open())
+        return false;
 
-    /* Check PDU
-     *  - First byte at index 38
-     *  - Last byte at index (signature_idx - 1)
-     */
-    if (sess_prot == "GSE")
+    bool appID_set{false}, multicastIP_set{false};
+    std::string line{};
+    while (std::getline(file, line))
     {
-        if (buf[38] != 0x61) //|| buf[39] != 0x81)
-        {
-            std::cerr << "[!] Error: GOOSE PDU Tag\n";
-            return false;         
-        }
-
-        if ((38 + buf[39]) != signature_idx)
-        {
-            std::cerr << "[!] Error: GOOSE PDU Length\n";
-            return false;         
-        }
-
-        // For iterating through the various Tag-Length-Value's of the GOOSE PDU
-        size_t tag_idx{};
-        size_t len_idx{};
-
-        // gocbRef (Tag at index 40 = PDU first byte's index + 3)
-        tag_idx = 40;
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);    // Ensure still 'digging' in the PDU
-        if (buf[tag_idx] != 0x80)
-        {
-            std::cerr << "[!] Error: goCBRef Tag\n";
-            return false;          
-        }
-
-        std::string current_gocbRef{};
-        for (size_t i = 0; i < buf[len_idx]; i++)
-        {
-            current_gocbRef += buf[(len_idx + 1) + i];
-        }
-        if (current_gocbRef != cbOut.cbName)
-        {
-            std::cerr << "[!] Error: goCBRef mismatch\n";
-            return false;          
-        }
-
-        // timeAllowedToLive
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        /* timeAllowedToLive not checked in this implementation */
-
-        // datSet
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        if (buf[tag_idx] != 0x82)
-        {
-            std::cerr << "[!] Error: GOOSE datSet Tag\n";
-            return false;          
-        }
-
-        std::string current_datSet{};
-        for (size_t i = 0; i < buf[len_idx]; i++)
+        std::istringstream iss(line.substr(0, line.find('#')));
+        std::string key{}, value{};
+        if (!(iss >> key >> value))
+            continue;
+
+        if (key == "pickup")
+            settings.pickup = std::stof(value);
+        else if (key == "slope1")
+            settings.slope1 = std::stof(value) / 100;
+        else if (key == "breakpoint")
+            settings.breakpoint = std::stof(value);
+        else if (key == "slope2")
+            settings.slope2 = std::stof(value) / 100;
+        else if (key == "trip_samples")
+            settings.trip_samples = std::max(1ul, std::stoul(value));
+        else if (key == "trip_cbName")
+            tripCb.cbName = value;
+        else if (key == "trip_datSet")
+            tripCb.datSetName = value;
+        else if (key == "trip_appID")
         {
-            current_datSet += buf[(len_idx + 1) + i];
+            tripCb.appID = scl_appid(value);
+            appID_set = true;
         }
-        if (current_datSet != cbOut.datSetName)
+        else if (key == "trip_multicastIP")
         {
-            std::cerr << "[!] Error: datSet mismatch\n";
-            return false;          
+            multicastIP_set = (inet_pton(AF_INET, value.c_str(), &tripCb.multicastIP) == 1);
         }
-
-        // goID
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        if (buf[tag_idx] != 0x83)
-        {
-            std::cerr << "[!] Error: GOOSE goID Tag\n";
-            return false;          
-        }
-        std::string current_goID{};
-        for (size_t i = 0; i < buf[len_idx]; i++)
-        {
-            current_goID += buf[(len_idx + 1) + i];
-        }
-        // Other setups may have a goID different from gocbRef
-        // But for this implementation, goID is checked against cbName (= gocbRef)
-        if (current_goID != cbOut.cbName)
-        {
-            std::cerr << "[!] Error: goID mismatch\n";
-            return false;          
-        }
-
-        // timestamp
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        /* timestamp not checked in this implementation */
-
-        // stNum
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        if (buf[tag_idx] != 0x85)
-        {
-            std::cerr << "[!] Error: GOOSE stNum Tag\n";
-            return false;          
-        }
-
-        unsigned int current_stNum{};
-        for (size_t i = 0; i < buf[len_idx]; i++)
-        {
-            current_stNum = current_stNum << 8;
-            current_stNum += buf[(len_idx + 1) + i];
-        }
-
-        // sqNum
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        if (buf[tag_idx] != 0x86)
-        {
-            std::cerr << "[!] Error: GOOSE sqNum Tag\n";
-            return false;          
-        }
-        
-        unsigned int current_sqNum{};
-        for (size_t i = 0; i < buf[len_idx]; i++)
-        {
-            current_sqNum = current_sqNum << 8;
-            current_sqNum += buf[(len_idx + 1) + i];
-        }
-
-        // test
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        if ( (buf[tag_idx] != 0x87) || (buf[len_idx] != 0x01)|| (buf[len_idx + 1] != 0x00) )
-        {
-            std::cerr << "[!] Error: GOOSE test Tag/Length/Value\n";
-            return false;     
-        }
-
-        // ConfRev
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        if ( (buf[tag_idx] != 0x88) || (buf[len_idx] != 0x01) || (buf[len_idx + 1] != 0x01) )
+        else
         {
-            std::cerr << "[!] Error: GOOSE ConfRev Tag/Length/Value\n";
-            return false;     
+            std::cerr << "[!] Unknown 87L setting \"" << key << "\" in " << filename << '\n';
+            return false;
         }
+    }
+    tripCb.cbType = CbType::GSE;
+    return !tripCb.cbName.empty() && !tripCb.datSetName.empty() && appID_set && multicastIP_set;
+}
 
-        // ndsCom
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        if ( (buf[tag_idx] != 0x89) || (buf[len_idx] != 0x01) || (buf[len_idx + 1] != 0x00) )
-        {
-            std::cerr << "[!] Error: GOOSE ndsCom Tag/Length/Value\n";
-            return false;     
-        }
+/* State of the 87L element (ref: lineDiff.hpp), its last differential/restraint currents, and the
+ * latencies from the receipt of the sample that completed a set to the decision, and to the
+ * trip R-GOOSE handed to the network.
+ */
+std::string line_diff_report(const LineDiff &diff, const LatencyHistogram &decision, const LatencyHistogram &trip)
+{
+    static const char PHASE_NAMES[LineDiff::PHASES] = {'A', 'B', 'C', 'N'};
+    auto us = [](uint64_t ns)
+    {
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(1) << ns / 1e3 << " us";
+        return oss.str();
+    };
+
+    const LineDiffSettings &st = diff.settings();
+    std::ostringstream report;
+    report << "characteristic: Is1 " << st.pickup << " A, k1 " << st.slope1 * 100 << " %, Is2 " << st.breakpoint
+           << " A, k2 " << st.slope2 * 100 << " %, " << st.trip_samples << " consecutive set(s) to trip\n"
+           << diff.evaluations() << " set(s) evaluated, " << diff.missing() << " without both ends, "
+           << diff.trips() << " trip(s), now " << (diff.tripped() ? "TRIPPED" : "not tripped") << '\n';
+    if (diff.evaluations())
+    {
+        const LineDiff::Result &r = diff.last();
+        report << "last set:";
+        for (size_t p = 0; p < LineDiff::PHASES; p++)
+            report << ' ' << PHASE_NAMES[p] << " Idiff " << r.idiff[p] << " / Ibias " << r.ibias[p]
+                   << ((r.operate & (1u << p)) ? " (operate)" : "") << (p + 1 < LineDiff::PHASES ? "," : "\n");
+        report << "sample-in to decision: p50 " << us(decision.percentile(0.50)) << ", p99 " << us(decision.percentile(0.99))
+               << ", max " << us(decision.max()) << '\n';
+    }
+    if (trip.count())
+        report << "sample-in to trip R-GOOSE out: " << trip.count() << " change(s) of state, p50 " << us(trip.percentile(0.50))
+               << ", max " << us(trip.max()) << '\n';
+    return report.str();
+}
 
-        // numDatSetEntries
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        if (buf[tag_idx] != 0x8A)
-        {
-            std::cerr << "[!] Error: GOOSE numDatSetEntries Tag\n";
-            return false;     
-        }
-        int current_numDatSetEntries{buf[len_idx + 1]};
+struct PhasorSettings
+{
+    unsigned int              samples_per_cycle{80};    // DFT window (80: IEC 61850-9-2 LE, protection)
+    float                     frequency{50};            // nominal system frequency (Hz)
+    std::vector<unsigned int> harmonics{1};             // orders estimated (1 = fundamental)
+    float                     reporting_rate{50};       // reports per second
+    std::string               output{};                 // CSV file of the reports (empty: standard output)
+};
+
+/* Reads the phasor estimation settings file: one "key value..." entry per line, '#' starts a comment.
+ * harmonics takes a list of orders. A setting out of range is reported by name.
+ */
+bool read_phasor_settings(const char *filename, PhasorSettings &settings)
+{
+    std::ifstream file(filename);
+    if (!file.is_open())
+        return false;
 
-        // allData
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        if (buf[tag_idx] != 0xAB)
-        {
-            std::cerr << "[!] Error: GOOSE allData Tag\n";
-            return false;         
-        }
+    auto invalid = [filename](const std::string &key, const std::string &value, const char *expected)
+    {
+        std::cerr << "[!] Phasor setting " << key << " = " << value << " in " << filename << ": expected " << expected << '\n';
+        return false;
+    };
 
-        std::vector<unsigned char> current_allData{};
-        for (size_t i = 0; i < buf[len_idx]; i++)
-        {
-            current_allData.push_back(buf[len_idx + 1 + i]);
-        }
+    std::string line{};
+    while (std::getline(file, line))
+    {
+        std::istringstream iss(line.substr(0, line.find('#')));
+        std::string key{}, value{};
+        if (!(iss >> key >> value))
+            continue;
 
-        /* Check: 
-         *  stNum, sqNum, numDatSetEntries & allData
-         */
-        // Check stNum
-        if (current_stNum < cbOut.prev_stNum_Value)
-        {
-            std::cerr << "[!] Error: stNum\n"
-                      << "\tExpected stNum: >=" << (cbOut.prev_stNum_Value) << '\n'
-                      << "\tObserved stNum: " << current_stNum
-                      << "\tObserved sqNum: " << current_sqNum  << '\n';
-            return false; 
-        }
-        // At this point, current stNum >= previous stNum
-        if (current_stNum != cbOut.prev_stNum_Value)
+        try
         {
-            if ( (cbOut.prev_allData_Value == current_allData) 
-                && (current_stNum = cbOut.prev_stNum_Value + 1) )
+            if (key == "samples_per_cycle")
             {
-                std::cerr << "[!] Error: stNum incremented but allData not changed\n";
-                return false; 
+                // The DFT window must divide the smpCnt wrap (4000, IEC 61850-9-2 LE)
+                const unsigned long samples = std::stoul(value);
+                if (samples < 2 || samples > 4000 || 4000 % samples != 0)
+                    return invalid(key, value, "a divisor of 4000, from 2");
+                settings.samples_per_cycle = static_cast<unsigned int>(samples);
             }
-        }
-        /* At this point, current stNum > previous stNum + 1 (i.e. some packet(s) lost)
-         *            or, current stNum == previous stNum + 1 && allData changed
-         *            or, current stNum == previous stNum
-         * All these scenarios are acceptable.
-         */
-
-        // Check sqNum
-        if (current_stNum == cbOut.prev_stNum_Value)
-        {
-            // Check if sqNum is not increasing
-            if (current_sqNum <= cbOut.prev_sqNum_Value && cbOut.prev_sqNum_Value != UINT_MAX)
+            else if (key == "frequency")
             {
-                std::cerr << "[Info] sqNum reused - suspected duplication.\n"; 
-                return false;      
+                settings.frequency = std::stof(value);
+                if (!(settings.frequency >= 1 && settings.frequency <= 1000))
+                    return invalid(key, value, "a nominal frequency from 1 to 1000 Hz");
             }
-        }
-        else
-        {
-            // Ensure receiver module is run before the sender module (otherwise this error will occur)
-            if (current_sqNum != 0)
+            else if (key == "harmonics")
             {
-                std::cerr << "[!] Error: sqNum\n"; 
-                return false;  
+                settings.harmonics.assign(1, std::stoul(value));
+                while (iss >> value)
+                    settings.harmonics.push_back(std::stoul(value));
+            }
+            else if (key == "reporting_rate")
+            {
+                settings.reporting_rate = std::stof(value);
+                if (!(settings.reporting_rate > 0 && std::isfinite(settings.reporting_rate)))
+                    return invalid(key, value, "a positive number of reports per second");
+            }
+            else if (key == "output")
+                settings.output = (value == "-") ? "" : value;
+            else
+            {
+                std::cerr << "[!] Unknown phasor setting \"" << key << "\" in " << filename << '\n';
+                return false;
             }
         }
-
-        // Check numDatSetEntries/allData
-        // Indexes were pointing at allData Tag/Length. Reassign to point to Tag/Length of the 1st allData Value.
-        tag_idx = len_idx + 1;
-        len_idx = tag_idx + 1;
-        for (unsigned int i = 0; i < current_numDatSetEntries; i++)
-        {
-            tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-            len_idx = tag_idx + 1;    
-        }
-        if (tag_idx != signature_idx)
-        {
-            std::cerr << "[!] Error: allData Value(s)\n"; 
-            return false;           
-        }
-
-        // Update output parameter's variables
-        cbOut.prev_spduNum = current_spduNum;
-        cbOut.prev_stNum_Value = current_stNum;
-        cbOut.prev_sqNum_Value = current_sqNum;
-        cbOut.prev_numDatSetEntries = current_numDatSetEntries;
-        cbOut.prev_allData_Value = current_allData;        
-    }
-    else if (sess_prot == "SMV")
-    {
-        /* Assume the following optional fields not present in ASDU:
-         *  - datSet
-         *  - refrTm
-         *  - smpRate
-         *  - SmpMod
-         */
-        if (buf[38] != 0x60) //|| buf[39] != 0x80)
-        {
-            std::cerr << "[!] Error: SV PDU Tag\n";
-            return false;         
-        }
-
-        if ((38 + buf[39]) != signature_idx)
-        {
-            std::cerr << "[!] Error: SV PDU Length\n";
-            return false;         
-        }
-
-        if (buf[40] != 0x80 || buf[41] != 0x01 || buf[42] != 0x01)
-        {
-            std::cerr << "[!] Error: noASDU Tag/Length/Value\n";
-            return false;
-        }
-
-        if (buf[43] != 0xA2)
-        {
-            std::cerr << "[!] Error: Sequence-of-ASDUs Tag\n";
-            return false;
-        }
-
-        if ((43 + buf[44]) != signature_idx)
-        {
-            std::cerr << "[!] Error: Sequence-of-ASDUs Length\n";
-            return false;         
-        }
-
-        if (buf[45] != 0x30)
-        {
-            std::cerr << "[!] Error: ASDU Tag\n";
-            return false;  
-        }
-
-        if ((45 + buf[46]) != signature_idx)
-        {
-            std::cerr << "[!] Error: ASDU Length\n";
-            return false;         
-        }
-
-        // For iterating through the various Tag-Length-Value's of the SV PDU
-        size_t tag_idx{};
-        size_t len_idx{};
-
-        tag_idx = 47;
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);    // Ensure still 'digging' in the PDU
-        if (buf[tag_idx] != 0x80)
-        {
-            std::cerr << "[!] Error: MsvID Tag\n";
-            return false; 
-        }
-
-        std::string current_svID{};
-        for (size_t i = 0; i < buf[len_idx]; i++)
-        {
-            current_svID += buf[(len_idx + 1) + i];
-        }
-        if (current_svID != cbOut.cbName)
-        {
-            std::cerr << "[!] Error: MsvID mismatch\n";
-            return false;          
-        }
-
-        // smpCnt
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        if (buf[tag_idx] != 0x82 || buf[len_idx] != 0x02)
-        {
-            std::cerr << "[!] Error: smpCnt Tag/Length\n";
-            return false;
-        }
-
-        unsigned int current_smpCnt{};
-        for (size_t i = 0; i < buf[len_idx]; i++)
-        {
-            current_smpCnt = current_smpCnt << 8;
-            current_smpCnt += buf[(len_idx + 1) + i];
-        }
-        if ((current_smpCnt < cbOut.prev_smpCnt_Value) && (cbOut.prev_smpCnt_Value != 3999))
-        {
-            std::cerr << "[!] Error: smpCnt Value reused\n";
-            return false; 
-        }
-
-        // confRev
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        if (buf[tag_idx] != 0x83 || buf[len_idx] != 0x04)
-        {
-            std::cerr << "[!] Error: confRev Tag/Length\n";
-            return false;
-        }
-        unsigned int current_confRev = (buf[(len_idx + 1)] << 24) + (buf[(len_idx + 2)] << 16)
-                                        + (buf[(len_idx + 3)] << 8) + (buf[(len_idx + 4)]);
-        if (current_confRev != 0x01)
-        {
-            std::cerr << "[!] Error: SV ConfRev Value\n";
-            return false;     
-        }
-
-        // smpSynch
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        if (buf[tag_idx] != 0x85 || buf[len_idx] != 0x01 || buf[len_idx + 1] != 0x02)
-        {
-            std::cerr << "[!] Error: smpSynch Tag/Length/Value\n";
-            return false;   
-        }
-
-        // Sample
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        if (buf[tag_idx] != 0x87)
-        {
-            std::cerr << "[!] Error: sequenceofdata Tag\n";
-            return false; 
-        }
-
-        std::vector<unsigned char> current_seqOfData{};
-        for (size_t i = 0; i < buf[len_idx]; i++)
-        {
-            current_seqOfData.push_back(buf[len_idx + 1 + i]);
-        }
-
-        // timestamp
-        tag_idx = (len_idx + 1) + buf[len_idx]; // new tag_idx = (old len_idx + 1 = start of Value field) + old length
-        len_idx = tag_idx + 1;
-        assert(len_idx < signature_idx);        // Ensure still 'digging' in the PDU
-        if (buf[tag_idx] != 0x89 || buf[len_idx] != 0x08)
+        catch (const std::exception &)
         {
-            std::cerr << "[!] Error: timestamp Tag/Length\n";
-            return false; 
+            return invalid(key, value, "a number");
         }
-        /* Checking of timestamp Value not yet included */
-
-        // Update output parameter's variables
-        cbOut.prev_spduNum = current_spduNum;
-        cbOut.prev_smpCnt_Value = current_smpCnt;
-        cbOut.prev_seqOfData_Value = current_seqOfData; 
     }
-
     return true;
 }
 
+// Phasor estimation (ref: phasorEstimator.hpp): window, harmonics, reporting rate and reports emitted
+std::string phasor_report(const PhasorEstimator &estimator, const PhasorSettings &settings)
+{
+    std::ostringstream report;
+    report << estimator.channels() << " channel(s), " << estimator.samplesPerCycle() << " samples per cycle at "
+           << settings.frequency << " Hz, harmonics";
+    for (unsigned int h : estimator.harmonics())
+        report << ' ' << h;
+    report << ", a report every " << estimator.samplesPerReport() << " sample(s)\n"
+           << estimator.samples() << " sample set(s), " << estimator.reports() << " report(s) written to "
+           << (settings.output.empty() ? "standard output" : settings.output) << '\n';
+    return report.str();
+}
+
 // HARDCODING: cbSubscribe[1] -- subscribe the 2nd control block in the vector only
 int main(int argc, char *argv[])
 {
-    if (argc != 4)
+    if (argc < 4 || argc > 8)
     {
         if (argv[0])
-            std::cout << "Usage: " << argv[0] << " <SED Filename> <Interface Name to be used on IED> <IED Name>" << '\n';
+            std::cout << "Usage: " << argv[0] << " <SED Filename> <Interface Name to be used on IED> <IED Name> [Transport: udp | mmsg | uring | packet | xdp]"
+                      << " [R-SV alignment wait in us (default 2000)] [87L settings file | -] [phasor settings file]" << '\n';
         else
             // For OS where argv[0] can end up as an empty string instead of the program's name.
             std::cout << "Usage: <program name> <SED Filename> <Interface Name to be used on IED> <IED Name>" << '\n';
@@ -611,102 +428,370 @@ int main(int argc, char *argv[])
     // Specify IED name
     const char *ied_name = argv[3];
 
-    // Specify filename to parse
-    std::vector<ControlBlock> vector_of_ctrl_blks = parse_sed(sed_filename);
-
-    // Find relevant Control Blocks to subscribe to
-    std::vector<GooseSvData> cbSubscribe{};
-    for (const ControlBlock &cb: vector_of_ctrl_blks)
+    // Specify how datagrams are received (default: UDP socket)
+    const std::string transport = (argc >= 5) ? argv[4] : "udp";
+    const bool udp_socket_rx = (transport == "udp" || transport == "mmsg" || transport == "uring");
+    if (!udp_socket_rx && transport != "packet" && transport != "xdp")
     {
-        for (const std::string &stored_ied: cb.subscribingIEDs)
-        {
-            if (ied_name == stored_ied)
-            {
-                GooseSvData tmp_goose_sv_data{};
-                tmp_goose_sv_data.cbName = cb.cbName;
-                tmp_goose_sv_data.cbType = cb.cbType;
-                tmp_goose_sv_data.appID = cb.appID;
-                tmp_goose_sv_data.multicastIP = cb.multicastIP;
+        std::cout << "Unknown transport \"" << transport << "\" (expected: udp, mmsg, uring, packet, xdp). Exiting program now...\n";
+        return 1;
+    }
 
-                if (cb.cbType == "GSE")
-                    tmp_goose_sv_data.datSetName = cb.datSetName;
+    // Specify how long a set of R-SV samples waits for the streams missing from it
+    const uint64_t sv_wait_ns = (argc >= 6) ? std::stoull(argv[5]) * 1000 : 2'000'000;
 
-                cbSubscribe.push_back(tmp_goose_sv_data);
-            }
-        }
+    // Specify the settings of the line differential (87L) element, if it runs on this IED
+    const char *line_diff_filename = (argc >= 7 && std::string(argv[6]) != "-") ? argv[6] : nullptr;
+
+    // Specify the settings of phasor and RMS estimation on the received R-SV streams, if enabled
+    const char *phasor_filename = (argc == 8) ? argv[7] : nullptr;
+
+    // Specify filename to parse: only the Control Blocks this IED publishes or subscribes to are resolved,
+    // or loaded from the compiled configuration while the SED file is unchanged, with the types of the R-GOOSE DataSets
+    std::vector<ControlBlock> vector_of_ctrl_blks{};
+    std::vector<TypedDataSet> dataSets{};
+    try
+    {
+        vector_of_ctrl_blks = load_sed(sed_filename, ied_name, dataSets);
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << "[!] " << e.what() << '\n';
+        exit (EXIT_FAILURE);
     }
+
+    // Find relevant Control Blocks to subscribe to, and with 87L, the IED's own R-SV stream (local end of the line).
+    // The table is the dispatch table of the receive path: it is replaced as a whole when the SED file is reloaded.
+    // R-GOOSE subscriptions whose DataSet types are in the SED file decode allData with them.
+    std::unique_ptr<SubscriptionTable> table = subscription_table(vector_of_ctrl_blks, ied_name, line_diff_filename != nullptr, dataSets);
     
-    if (cbSubscribe.size() == 0)
+    if (table->cbSubscribe.size() == 0)
     {
         std::cout << argv[3] << " has no Control Block(s) to subscribe to." << '\n';
         std::cout << "Please check configuration in " << argv[1] << ". Exiting program now...\n";
         return 1;
     }
 
-    UdpSock sock;
-    diagnose(sock.isGood(), "Opening datagram socket for receive");
+    // For Circuit-Breaker interlocking mechanism
+    unsigned char ownXCBRposition{1};   // 0x01 = Close
 
+    // All sources of events (receive socket, signals, control socket) are served by one event loop
+    EventLoop loop;
+    diagnose(loop.isGood(), "Creating event loop");
+
+    unsigned long long numPackets{0}, numAccepted{0};
+
+    /* Metrics (ref: metrics.hpp): counters of the receive path (this thread) and of every stream subscribed to.
+     * Streams keep their counters across reloads (same subscription key).
+     */
+    MetricsRegistry metrics{};
+    ThreadMetrics &rxMetrics = metrics.thread("receive");
+    auto attach_stream_metrics = [&](SubscriptionTable &t)
+    {
+        metrics.unsubscribeAll();
+        for (GooseSvData &cb : t.cbSubscribe)
+            cb.metrics = &metrics.stream(subscription_key(cb), cb);
+    };
+    attach_stream_metrics(*table);
+
+    /* GOOSE timeAllowedToLive (TAL) supervision
+     * Every valid R-GOOSE re-arms the timer of its subscription for TAL ms. If the timer expires,
+     * the publisher is considered lost and the interlocking logic is told so.
+     * All timers live in one timing wheel (1 tick = 1 ms) which is driven by a single timerfd,
+     * so re-arming costs O(1) whatever the number of subscriptions.
+     */
+    TimingWheel talWheel{monotonic_ms()};
+    auto create_tal_timers = [&](SubscriptionTable &t)
+    {
+        t.talTimers.reserve(t.cbSubscribe.size());      // Timers are linked into the wheel: no reallocation allowed
+        for (size_t i = 0; i < t.cbSubscribe.size(); i++)
+        {
+            t.talTimers.emplace_back([&t, i, ied_name, &rxMetrics]()
+            {
+                std::vector<GooseSvData> &cbSubscribe = t.cbSubscribe;
+                // Stream lost: the state of the remote Circuit Breaker is no longer known
+                cbSubscribe[i].stream_lost = true;
+                cbSubscribe[i].tal_expiry_count++;
+                cbSubscribe[i].metrics->talExpired();
+                rxMetrics.add(Counter::TalExpiries);
+                std::cout << "[!] R-GOOSE stream lost: " << cbSubscribe[i].cbName
+                          << " (no valid message within timeAllowedToLive = " << cbSubscribe[i].timeAllowedToLive << " ms)\n"
+                          << "[Simulation] Circuit-Breaker interlocking mechanism\n"
+                          << '\t' << cbSubscribe[i].datSetName << " is unknown.\n"
+                          << "\tBlock operation of " << ied_name << "$XCBR until the stream is restored.\n";
+            });
+        }
+    };
+    create_tal_timers(*table);
+
+    constexpr uint64_t TAL_NOT_PROGRAMMED{UINT64_MAX};
+    uint64_t talProgrammedTick{TAL_NOT_PROGRAMMED};
+    int talTimerFd{-1};
+
+    // Program the timerfd for the wheel's earliest expiry. Re-arming a TAL only ever delays an expiry,
+    // so the timerfd is reprogrammed only if an earlier wake-up is needed (it may fire early otherwise).
+    auto schedule_tal = [&]()
     {
-        // enable SO_REUSEADDR to allow multiple instances of this application to
-        //    receive copies of the multicast datagrams.
-        int reuse = 1;
-        diagnose(setsockopt(sock(), SOL_SOCKET, SO_REUSEADDR, (char*)&reuse,
-                            sizeof(reuse)) >= 0, "Setting SO_REUSEADDR");
+        uint64_t next_tick{};
+        if (!talWheel.nextExpiry(next_tick) || next_tick >= talProgrammedTick)
+            return;
+
+        uint64_t now = monotonic_ms();
+        uint64_t delay_ns = (next_tick > now) ? (next_tick - now) * 1'000'000 : 1;  // 0 would disarm the timerfd
+        loop.rearmTimer(talTimerFd, delay_ns, 0);
+        talProgrammedTick = next_tick;
+    };
+
+    talTimerFd = loop.addTimer(0, 0, [&](uint64_t /* expirations */)
+    {
+        talProgrammedTick = TAL_NOT_PROGRAMMED;
+        talWheel.advance(monotonic_ms());
+        schedule_tal();
+    });
+    diagnose(talTimerFd >= 0, "Creating timeAllowedToLive supervision timer");
+
+    /* R-SV alignment by smpCnt
+     * Samples of all subscribed R-SV streams are buffered by smpCnt and released as aligned sets,
+     * once every stream has delivered or sv_wait_ns after the first sample of the set arrived.
+     * Arrival times are kernel receive timestamps (CLOCK_REALTIME), so is the expiry timer's clock.
+     */
+    std::unique_ptr<SvAligner> svAligner{};
+    if (table->numSvStreams > 0)
+    {
+        svAligner = std::make_unique<SvAligner>(table->numSvStreams, sv_wait_ns);
+        diagnose(svAligner->isGood(), "Creating R-SV alignment buffer for " + std::to_string(table->numSvStreams) + " stream(s)");
     }
 
-    // Bind to the proper port number with the IP address specified as INADDR_ANY
-    sockaddr_in localSock = {};    // initialize to all zeroes
-    localSock.sin_family      = AF_INET;
-    localSock.sin_port        = htons(IEDUDPPORT);
-    localSock.sin_addr.s_addr = INADDR_ANY;
-    // Note from manpage that bind returns 0 on success
-    diagnose(!bind(sock(), (sockaddr*)&localSock, sizeof(localSock)),
-           "Binding datagram socket");
+    /* Line differential (87L) element (ref: lineDiff.hpp)
+     * Every aligned set holding both ends of the line is evaluated. The trip decision is published
+     * as an R-GOOSE at once on every change of state, then retransmitted like any R-GOOSE.
+     * Latencies are measured from the kernel receive time of the later of the two samples compared.
+     */
+    std::unique_ptr<LineDiff> lineDiff{};
+    GooseSvData tripCb{};
+    std::vector<unsigned char> tripAllData{0x83, 0x01, 0x00};   // Boolean: 87L operated (general)
+    int localStream{-1}, remoteStream{-1};
+    LatencyHistogram decisionLatency{}, tripLatency{};
+    std::unique_ptr<UdpSock> tripSock{};
+    int tripRetransmitTimer{-1};
+
+    // Forms and sends the trip R-GOOSE with the current decision, and schedules its retransmission
+    auto publish_trip = [&]()
+    {
+        publish_message((*tripSock)(), tripCb, rxMetrics, "Sending trip R-GOOSE", &tripAllData);
 
-    // Join the multicast group on the local interface.  Note that this
-    //    IP_ADD_MEMBERSHIP option must be called for each local interface over
-    //    which the multicast datagrams are to be received.
-    ip_mreq group = {};    // initialize to all zeroes
+        uint64_t interval_ns = static_cast<uint64_t>(tripCb.timeAllowedToLive) * 1'000'000 / 2;
+        loop.rearmTimer(tripRetransmitTimer, std::max<uint64_t>(interval_ns, 1), 0);
+    };
 
-    for(int i = 0; i < cbSubscribe.size(); i++)
+    if (line_diff_filename)
     {
-        // Set multicast IPv4 address in group->imr_multiaddr
-        inet_pton(AF_INET, cbSubscribe[i].multicastIP.c_str(), &(group.imr_multiaddr));
-        // NOTE: Above statement processes only the 1st subscription requirement 
-        // (ok if assume only 1 Control Block to subscribe to)
+        LineDiffSettings settings{};
+        diagnose(read_line_diff_settings(line_diff_filename, settings, tripCb),
+                 std::string("Reading 87L settings from ") + line_diff_filename);
+
+        // Stream indices stay valid across reloads: those that change the R-SV subscriptions are refused
+        const int localSubscription = table->localSubscription;
+        localStream = (localSubscription >= 0) ? table->svStream[localSubscription] : -1;
+        for (size_t i = 0; i < table->cbSubscribe.size(); i++)
+        {
+            if (table->svStream[i] >= 0 && static_cast<int>(i) != localSubscription)
+            {
+                remoteStream = table->svStream[i];
+                break;
+            }
+        }
+        diagnose(localStream >= 0 && remoteStream >= 0, "Finding the local and remote R-SV streams of the line");
+        lineDiff = std::make_unique<LineDiff>(settings);
+
+        tripSock = std::make_unique<UdpSock>();
+        diagnose(tripSock->isGood(), "Opening datagram socket for the trip R-GOOSE");
+        in_addr localIface = ((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr;
+        diagnose(setsockopt((*tripSock)(), IPPROTO_IP, IP_MULTICAST_IF, (char*)&localIface,
+                            sizeof(localIface)) >= 0, "Setting local interface for the trip R-GOOSE");
+        int ttl = 16;
+        diagnose(setsockopt((*tripSock)(), IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) >= 0,
+                 "Setting TTL for the trip R-GOOSE");
+
+        tripRetransmitTimer = loop.addTimer(0, 0, [&](uint64_t /* expirations */)
+        {
+            publish_trip();
+        });
+        diagnose(tripRetransmitTimer >= 0, "Creating trip R-GOOSE retransmission timer");
 
-        // Set local network interface to receive multicast messages
-        group.imr_interface = ((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr;
+        std::cout << "87L element: local " << table->cbSubscribe[localSubscription].cbName
+                  << ", trip published on " << tripCb.cbName << '\n';
+        publish_trip();     // Initial state: not tripped
+    }
+
+    /* Phasor (DFT) and true-RMS estimation (ref: phasorEstimator.hpp)
+     * All channels of all R-SV streams are estimated together from the aligned sets. A stream
+     * missing from a set keeps its previous sample. Reports are written as CSV:
+     * smpCnt, stream, channel, RMS, then magnitude (RMS) and angle (degrees) of each harmonic.
+     */
+    std::unique_ptr<PhasorEstimator> phasors{};
+    PhasorSettings phasorSettings{};
+    std::vector<float> phasorInput{};
+    std::ofstream phasorFile{};
+    std::ostream *phasorOut{&std::cout};
 
-        diagnose(setsockopt(sock(), IPPROTO_IP, IP_ADD_MEMBERSHIP, (char*)&group,
-                          sizeof(group)) >= 0, "Adding multicast group");
+    if (phasor_filename)
+    {
+        diagnose(read_phasor_settings(phasor_filename, phasorSettings),
+                 std::string("Reading phasor settings from ") + phasor_filename);
+        diagnose(svAligner != nullptr, "Finding R-SV streams for phasor estimation");
+
+        const double sample_rate = phasorSettings.samples_per_cycle * static_cast<double>(phasorSettings.frequency);
+        const unsigned int samples_per_report = std::max(1u, static_cast<unsigned int>(
+                                                         std::lround(sample_rate / phasorSettings.reporting_rate)));
+        const size_t channels = static_cast<size_t>(table->numSvStreams) * SvAligner::MAX_CHANNELS;
+        phasors = std::make_unique<PhasorEstimator>(channels, phasorSettings.samples_per_cycle,
+                                                    phasorSettings.harmonics, samples_per_report);
+        diagnose(phasors->isGood(), "Creating phasor estimator for " + std::to_string(channels) + " channel(s)");
+        phasorInput.assign(channels, 0.0f);
+
+        if (!phasorSettings.output.empty())
+        {
+            phasorFile.open(phasorSettings.output);
+            diagnose(phasorFile.is_open(), "Opening phasor output file " + phasorSettings.output);
+            phasorOut = &phasorFile;
+        }
+        *phasorOut << "smpCnt,stream,channel,rms";
+        for (unsigned int h : phasorSettings.harmonics)
+            *phasorOut << ",h" << h << "_magnitude,h" << h << "_angle";
+        *phasorOut << std::endl;
     }
-    // For Circuit-Breaker interlocking mechanism
-    unsigned char ownXCBRposition{1};   // 0x01 = Close
 
-    // Keep looping to receive multicast messages
-    while(1)
+    // Writes the phasors and RMS of every channel of every R-SV stream
+    auto write_phasors = [&](unsigned int smpCnt)
+    {
+        const std::vector<GooseSvData> &cbSubscribe = table->cbSubscribe;
+        const std::vector<int> &svStream = table->svStream;
+        for (size_t i = 0; i < cbSubscribe.size(); i++)
+        {
+            if (svStream[i] < 0)
+                continue;
+            for (size_t ch = 0; ch < SvAligner::MAX_CHANNELS; ch++)
+            {
+                const size_t c = svStream[i] * SvAligner::MAX_CHANNELS + ch;
+                *phasorOut << smpCnt << ',' << cbSubscribe[i].cbName << ',' << ch << ',' << phasors->rms(c);
+                for (size_t h = 0; h < phasorSettings.harmonics.size(); h++)
+                {
+                    const PhasorEstimator::Phasor p = phasors->phasor(c, h);
+                    *phasorOut << ',' << p.magnitude << ',' << p.angle;
+                }
+                *phasorOut << '\n';
+            }
+        }
+        phasorOut->flush();
+    };
+
+    // Nothing is printed per sample set (thousands per second): the aligner, the 87L element and the phasor
+    // estimation count them, for the "alignment", "87l" and "phasors" control commands; 87L prints its trip changes
+    auto on_aligned = [&](const SvAligner::AlignedSet &set)
+    {
+        const int numSvStreams = table->numSvStreams;
+
+        if (phasors)
+        {
+            for (int s = 0; s < numSvStreams; s++)
+            {
+                if (set.present & (uint64_t{1} << s))
+                    std::memcpy(&phasorInput[s * SvAligner::MAX_CHANNELS], &set.values[s * SvAligner::MAX_CHANNELS],
+                                SvAligner::MAX_CHANNELS * sizeof(float));
+            }
+            if (phasors->push(set.smpCnt, phasorInput.data()))
+                write_phasors(set.smpCnt);
+        }
+
+        if (!lineDiff)
+            return;
+
+        const uint64_t ends = (uint64_t{1} << localStream) | (uint64_t{1} << remoteStream);
+        if ((set.present & ends) != ends)
+        {
+            lineDiff->missingEnd();
+            return;
+        }
+
+        const LineDiff::Result &r = lineDiff->evaluate(&set.values[localStream * SvAligner::MAX_CHANNELS],
+                                                       &set.values[remoteStream * SvAligner::MAX_CHANNELS]);
+        const uint64_t sample_in = std::max(set.arrival_ns[localStream], set.arrival_ns[remoteStream]);
+        decisionLatency.record(static_cast<int64_t>(realtime_ns() - sample_in));
+        if (r.changed)
+        {
+            tripAllData[2] = r.trip ? 0x01 : 0x00;
+            publish_trip();
+            tripLatency.record(static_cast<int64_t>(realtime_ns() - sample_in));
+            std::cout << "[87L] " << (r.trip ? "TRIP" : "Reset") << " at smpCnt " << set.smpCnt
+                      << " (operating phases mask 0x" << std::hex << r.operate << std::dec << ")\n";
+        }
+    };
+
+    int svAlignTimerFd{-1};
+    // Program the timerfd for the alignment buffer's next expiry (disarmed if nothing is pending)
+    auto schedule_alignment = [&]()
     {
-        // Initialization before each reading of socket
-        int numbytes{};
-        unsigned char buf[MAXBUFLEN]{};
-        struct sockaddr_in their_addr{};
-        socklen_t addr_len{sizeof their_addr};
+        uint64_t deadline{};
+        if (!svAligner || !svAligner->nextDeadline(deadline))
+        {
+            if (svAligner)
+                loop.rearmTimer(svAlignTimerFd, 0, 0);
+            return;
+        }
+        uint64_t now = realtime_ns();
+        loop.rearmTimer(svAlignTimerFd, (deadline > now) ? deadline - now : 1, 0);  // 0 would disarm the timerfd
+    };
+
+    // Created even without R-SV subscriptions: a reload may add some
+    svAlignTimerFd = loop.addTimer(0, 0, [&](uint64_t /* expirations */)
+    {
+        if (svAligner)
+            svAligner->poll(realtime_ns(), on_aligned);
+        schedule_alignment();
+    });
+    diagnose(svAlignTimerFd >= 0, "Creating R-SV alignment timer");
+
+    // Timers to reprogram once a batch of datagrams has been processed
+    auto schedule_timers = [&]()
+    {
+        schedule_tal();
+        schedule_alignment();
+    };
 
-        // Read from the socket
-        diagnose((numbytes = recvfrom(sock(), buf, MAXBUFLEN-1 , 0, 
-                    (struct sockaddr *)&their_addr, &addr_len)) != 1,
-                    "\nReading datagram message");
+    // Checks a datagram (UDP payload) against the subscriptions and acts on its content
+    auto process_datagram = [&](const unsigned char *buf, int numbytes, in_addr source, uint64_t rx_time_ns)
+    {
+        numPackets++;
+        rxMetrics.add(Counter::PacketsReceived);
+        rxMetrics.add(Counter::BytesReceived, numbytes);
+        IED_TRACE2(receive, numbytes, rx_time_ns);
 
         std::cout << ">> " << numbytes << " bytes received from " 
-                    << inet_ntoa(their_addr.sin_addr) << "\n";
+                    << inet_ntoa(source) << "\n";
+
+        // Subscriptions in use (the table is only replaced between two batches of datagrams)
+        std::vector<GooseSvData> &cbSubscribe = table->cbSubscribe;
+        std::vector<WheelTimer> &talTimers = table->talTimers;
+        const std::vector<int> &svStream = table->svStream;
 
+        // Reason of the rejection if no subscription accepts the datagram: the furthest check reached
+        DecodeCheck rejectedBy{DecodeCheck::Length};
+        uint16_t rejectedStream{0};
         for(int i = 0; i < cbSubscribe.size(); i++)
         {
             /* Start checking UDP payload */
-            if (valid_GSE_SMV(buf, numbytes, cbSubscribe[i]))
+            DecodeResult decoded{};
+            if (valid_GSE_SMV(buf, numbytes, cbSubscribe[i], decoded))
             {
-                if (cbSubscribe[i].cbType == "GSE")
+                const int64_t latency_ns = static_cast<int64_t>(rx_time_ns - decoded.t_ns);
+                StreamMetrics &streamMetrics = *cbSubscribe[i].metrics;
+                streamMetrics.latency().record(latency_ns);
+                streamMetrics.accepted(numbytes);
+                streamMetrics.publish(cbSubscribe[i].counters);
+                IED_TRACE3(deliver, cbSubscribe[i].appID, cbSubscribe[i].prev_spduNum, latency_ns);
+
+                if (cbSubscribe[i].cbType == CbType::GSE)
                 {
                     std::cout << "Checked R-GOOSE OK\n"
                               << "cbName: " << cbSubscribe[i].cbName << std::endl
@@ -715,20 +800,36 @@ int main(int argc, char *argv[])
                     {
                         std::cout << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(item) << "  ";
                     }
-                    std::cout << "}\n" << std::dec;
+                    std::cout << "}\n" << std::dec << std::setfill(' ');
+                    if (cbSubscribe[i].datasetPlan)
+                        print_dataset(std::cout, *cbSubscribe[i].datasetPlan, cbSubscribe[i].datasetValues.data());
                     std::cout << "\tstNum = " << cbSubscribe[i].prev_stNum_Value 
                               << "\tsqNum = " << cbSubscribe[i].prev_sqNum_Value << "\t|"
                               << "\tSPDU Number (from Session Header) = " << cbSubscribe[i].prev_spduNum << '\n';
 
+                    // Supervise the stream until the next R-GOOSE is due
+                    talWheel.arm(talTimers[i], monotonic_ms() + cbSubscribe[i].timeAllowedToLive);
+                    if (cbSubscribe[i].stream_lost)
+                    {
+                        cbSubscribe[i].stream_lost = false;
+                        std::cout << "[*] R-GOOSE stream restored: " << cbSubscribe[i].cbName << '\n';
+                    }
+
                     /* Specific to IED receiving Circuit Breaker position
                      * For Circuit Breaker Interlocking Mechanism
                      */
-                    // Check that allData just received is Boolean Tag && 1-byte Length
-                    if (cbSubscribe[i].prev_allData_Value[0] == 0x83 
-                        && cbSubscribe[i].prev_allData_Value[1] == 0x01)
+                    // Position: from the typed DataSet, or else allData just received is Boolean Tag && 1-byte Length
+                    int position{-1};
+                    if (cbSubscribe[i].datasetPlan)
+                        position = dataset_position(*cbSubscribe[i].datasetPlan, cbSubscribe[i].datasetValues.data());
+                    else if (cbSubscribe[i].prev_allData_Value[0] == 0x83
+                             && cbSubscribe[i].prev_allData_Value[1] == 0x01)
+                        position = cbSubscribe[i].prev_allData_Value[2] ? 1 : 0;
+
+                    if (position >= 0)
                     {
                         // Check allData Value
-                        if (!cbSubscribe[i].prev_allData_Value[2])
+                        if (position == 0)
                         {
                             // Fault scenario: output printed at each cycle as long as fault remains
                             std::cout << "[Simulation] Circuit-Breaker interlocking mechanism\n"
@@ -752,7 +853,7 @@ int main(int argc, char *argv[])
                         std::cout << "[!] GOOSE allData not recognised.\n";
                     }
                 }
-                else if (cbSubscribe[i].cbType == "SMV")
+                else if (cbSubscribe[i].cbType == CbType::SMV)
                 {
                     std::cout << "cbName: " << cbSubscribe[i].cbName << std::endl;
                     std::cout << "smpCnt: " << cbSubscribe[i].prev_smpCnt_Value << std::endl;
@@ -785,16 +886,381 @@ int main(int argc, char *argv[])
                         std::cout << std::setprecision(8)<< data.f << " ";
                     }
                     std::cout << "}\n" << std::dec;
+
+                    // Pair with the other R-SV streams' samples of the same smpCnt
+                    float values[SvAligner::MAX_CHANNELS];
+                    size_t count = sv_float_values(cbSubscribe[i].prev_seqOfData_Value, values, SvAligner::MAX_CHANNELS);
+                    svAligner->push(svStream[i], cbSubscribe[i].prev_smpCnt_Value, values, count, rx_time_ns, on_aligned);
                 } 
-                break;         
+                numAccepted++;
+                rxMetrics.add(Counter::PacketsAccepted);
+                return;
             }
             else
             {
+                // Past its APPID, the message was counted in the stream's sequence accounting
+                if (decoded.check > DecodeCheck::Appid)
+                {
+                    cbSubscribe[i].metrics->publish(cbSubscribe[i].counters);
+                    rejectedStream = cbSubscribe[i].appID;
+                }
+                rejectedBy = std::max(rejectedBy, decoded.check);
                 // Ignore the packet and await the next one
                 continue;
             }
         }
+        rxMetrics.rejected(rejectedBy);
+        IED_TRACE3(validation_failure, static_cast<unsigned int>(rejectedBy), rejectedStream, numbytes);
+    };
+
+    std::unique_ptr<UdpSock> sock{};
+    std::unique_ptr<MmsgRecv> mmsg{};
+    std::unique_ptr<UringRecv> uring{};
+    std::unique_ptr<PacketRing> ring{};
+    std::unique_ptr<XdpSock> xsk{};
+
+    // Joins (or leaves) a multicast group on the local interface, with the socket or the AF_PACKET ring in use
+    auto multicast_membership = [&](in_addr multicastIP, bool join) -> bool
+    {
+        if (ring)
+            return join ? ring->addMulticastGroup(multicastIP) : ring->dropMulticastGroup(multicastIP);
+
+        ip_mreq group = {};    // initialize to all zeroes
+        // Set multicast IPv4 address in group->imr_multiaddr
+        group.imr_multiaddr = multicastIP;
+        // Set local network interface to receive multicast messages
+        group.imr_interface = ((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr;
+        return setsockopt((*sock)(), IPPROTO_IP, join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP, (char*)&group,
+                          sizeof(group)) >= 0;
+    };
+
+    if (udp_socket_rx || transport == "xdp")
+    {
+        sock = std::make_unique<UdpSock>();
+        diagnose(sock->isGood(), "Opening datagram socket for receive");
+
+        // With AF_XDP, the socket only joins the multicast groups: datagrams are redirected before reaching it
+        if (udp_socket_rx)
+        {
+            {
+                // enable SO_REUSEADDR to allow multiple instances of this application to
+                //    receive copies of the multicast datagrams.
+                int reuse = 1;
+                diagnose(setsockopt((*sock)(), SOL_SOCKET, SO_REUSEADDR, (char*)&reuse,
+                                    sizeof(reuse)) >= 0, "Setting SO_REUSEADDR");
+            }
+
+            // Bind to the proper port number with the IP address specified as INADDR_ANY
+            sockaddr_in localSock = {};    // initialize to all zeroes
+            localSock.sin_family      = AF_INET;
+            localSock.sin_port        = htons(IEDUDPPORT);
+            localSock.sin_addr.s_addr = INADDR_ANY;
+            // Note from manpage that bind returns 0 on success
+            diagnose(!bind((*sock)(), (sockaddr*)&localSock, sizeof(localSock)),
+                   "Binding datagram socket");
+        }
+
+        // Join the multicast group on the local interface.  Note that this
+        //    IP_ADD_MEMBERSHIP option must be called for each local interface over
+        //    which the multicast datagrams are to be received. Each group is joined once,
+        //    even if several Control Blocks are published on it.
+        for (in_addr multicastIP : multicast_groups(*table))
+            diagnose(multicast_membership(multicastIP, true), "Adding multicast group " + ipv4_string(multicastIP));
+    }
+
+    if (udp_socket_rx)
+    {
+        // Drain every datagram queued on the (non-blocking) socket each time it becomes readable
+        diagnose(fcntl((*sock)(), F_SETFL, fcntl((*sock)(), F_GETFL) | O_NONBLOCK) >= 0,
+                 "Setting socket non-blocking");
+        // Stamp datagrams on arrival in the kernel, for one-way latency (ref: rxTimestamp.hpp)
+        diagnose(enable_rx_timestamps((*sock)()), "Enabling kernel receive timestamps");
     }
+
+    if (transport == "udp")
+    {
+        diagnose(loop.addFd((*sock)(), EPOLLIN, [&](uint32_t /* events */)
+        {
+            while (true)
+            {
+                // Initialization before each reading of socket
+                int numbytes{};
+                unsigned char buf[MAXBUFLEN]{};
+                struct sockaddr_in their_addr{};
+                alignas(cmsghdr) unsigned char control[RX_TIMESTAMP_CONTROL_LEN];
+                iovec iov{buf, MAXBUFLEN-1};
+                msghdr msg{};
+                msg.msg_name       = &their_addr;
+                msg.msg_namelen    = sizeof their_addr;
+                msg.msg_iov        = &iov;
+                msg.msg_iovlen     = 1;
+                msg.msg_control    = control;
+                msg.msg_controllen = sizeof control;
+
+                // Read from the socket (with the kernel receive timestamp as ancillary data)
+                numbytes = recvmsg((*sock)(), &msg, 0);
+                if (numbytes < 0)
+                {
+                    // Interrupted by a signal before a datagram was read: the queue may still hold some
+                    if (errno == EINTR)
+                        continue;
+                    if (errno != EAGAIN && errno != EWOULDBLOCK)
+                        std::cerr << "\nReading datagram message error\n";
+                    break;
+                }
+                process_datagram(buf, numbytes, their_addr.sin_addr, rx_timestamp_ns(msg));
+            }
+            schedule_timers();
+        }), "Registering socket with event loop");
+    }
+    else if (transport == "mmsg")
+    {
+        // Up to MmsgRecv::BATCH datagrams per system call (ref: mmsgRecv.hpp)
+        mmsg = std::make_unique<MmsgRecv>((*sock)());
+
+        diagnose(loop.addFd((*sock)(), EPOLLIN, [&](uint32_t /* events */)
+        {
+            mmsg->drain(process_datagram);
+            schedule_timers();
+        }), "Registering socket with event loop");
+    }
+    else if (transport == "uring")
+    {
+        // Multishot recvmsg into provided buffers: datagrams are decoded in place (ref: uringRecv.hpp)
+        uring = std::make_unique<UringRecv>((*sock)());
+        diagnose(uring->isGood(), "Setting up io_uring with multishot recvmsg and provided buffers");
+
+        diagnose(loop.addFd((*uring)(), EPOLLIN, [&](uint32_t /* events */)
+        {
+            uring->drain(process_datagram);
+            schedule_timers();
+        }), "Registering io_uring with event loop");
+    }
+    else if (transport == "packet")
+    {
+        // Memory-mapped AF_PACKET ring: datagrams are decoded in place, without copying (ref: packetRing.hpp)
+        ring = std::make_unique<PacketRing>(ifname, IEDUDPPORT);
+        diagnose(ring->isGood(), "Opening AF_PACKET socket with TPACKET_V3 receive ring");
+
+        for (in_addr multicastIP : multicast_groups(*table))
+            diagnose(multicast_membership(multicastIP, true), "Adding multicast group " + ipv4_string(multicastIP));
+
+        diagnose(loop.addFd((*ring)(), EPOLLIN, [&](uint32_t /* events */)
+        {
+            ring->drain(process_datagram);
+            schedule_timers();
+        }), "Registering packet ring with event loop");
+    }
+    else if (transport == "xdp")
+    {
+        // AF_XDP socket fed by an XDP program: datagrams are decoded in place in the UMEM (ref: xdpSock.hpp)
+        xsk = std::make_unique<XdpSock>(ifname, IEDUDPPORT);
+        diagnose(xsk->isGood(), "Opening AF_XDP socket and attaching XDP program");
+        std::cout << "AF_XDP running in " << xsk->mode() << " mode\n";
+
+        diagnose(loop.addFd((*xsk)(), EPOLLIN, [&](uint32_t /* events */)
+        {
+            xsk->drain(process_datagram);
+            schedule_timers();
+        }), "Registering AF_XDP socket with event loop");
+    }
+
+    // Datagrams dropped by the kernel before this IED could read them
+    auto receiver_drops = [&]() -> uint64_t
+    {
+        if (ring)
+            return ring->drops();
+        if (xsk)
+            return xsk->drops();
+        return sock->drops();
+    };
+
+    /* Installs the subscription table of a reloaded SED file, on the event loop thread
+     * Streams in both tables keep their state, the multicast groups no longer used are left and the new
+     * ones joined, then the new table replaces the old one. The R-SV alignment buffer is rebuilt if the
+     * R-SV subscriptions changed (pending sample sets are dropped); that is refused while the 87L element
+     * or phasor estimation, which are laid out on those streams, are enabled.
+     */
+    auto install_table = [&](std::unique_ptr<SubscriptionTable> next) -> std::string
+    {
+        // As at start-up, a file without subscriptions for this IED (e.g. half written) is not used
+        if (next->cbSubscribe.empty())
+            return "not applied, no Control Block(s) to subscribe to";
+        const bool same_sv = same_sv_streams(*table, *next);
+        if (!same_sv && (lineDiff || phasors))
+            return "not applied, R-SV subscriptions changed (restart to apply them with 87L or phasor estimation enabled)";
+
+        std::unique_ptr<SvAligner> nextAligner{};
+        if (!same_sv && next->numSvStreams > 0)
+        {
+            nextAligner = std::make_unique<SvAligner>(next->numSvStreams, sv_wait_ns);
+            if (!nextAligner->isGood())
+                return "not applied, cannot create the R-SV alignment buffer for " + std::to_string(next->numSvStreams) + " stream(s)";
+        }
+
+        create_tal_timers(*next);
+        const size_t carried = carry_over_state(*table, *next, talWheel);
+        attach_stream_metrics(*next);
+
+        const std::vector<in_addr> oldGroups = multicast_groups(*table), newGroups = multicast_groups(*next);
+        std::unordered_set<in_addr_t> oldSet{}, newSet{};
+        for (in_addr multicastIP : oldGroups)
+            oldSet.insert(multicastIP.s_addr);
+        for (in_addr multicastIP : newGroups)
+            newSet.insert(multicastIP.s_addr);
+        size_t joined{0}, left{0};
+        for (in_addr multicastIP : newGroups)
+        {
+            if (oldSet.count(multicastIP.s_addr))
+                continue;
+            if (multicast_membership(multicastIP, true))
+                joined++;
+            else
+                std::cout << "[!] Couldn't join multicast group " << ipv4_string(multicastIP) << '\n';
+        }
+        for (in_addr multicastIP : oldGroups)
+        {
+            if (newSet.count(multicastIP.s_addr))
+                continue;
+            if (multicast_membership(multicastIP, false))
+                left++;
+            else
+                std::cout << "[!] Couldn't leave multicast group " << ipv4_string(multicastIP) << '\n';
+        }
+
+        if (!same_sv)
+            svAligner = std::move(nextAligner);
+
+        const std::string summary = std::to_string(next->cbSubscribe.size()) + " Control Block(s) subscribed ("
+                                  + std::to_string(carried) + " unchanged, " + std::to_string(next->cbSubscribe.size() - carried)
+                                  + " new, " + std::to_string(table->cbSubscribe.size() - carried) + " removed), "
+                                  + std::to_string(joined) + " multicast group(s) joined, " + std::to_string(left) + " left";
+        // Nothing refers to the old table any more: the receive path runs on this thread only
+        table = std::move(next);
+        schedule_timers();
+        return summary;
+    };
+
+    /* Reload of the SED file (ref: sedReload.hpp): on SIGHUP, on a change of the file, or the "reload" command.
+     * Parsing runs on a thread of its own; the receive path goes on with the current table meanwhile.
+     */
+    SedReload reload(sed_filename, ied_name, line_diff_filename != nullptr);
+    diagnose(reload.isGood(), std::string("Watching ") + sed_filename + " for changes");
+
+    diagnose(loop.addFd(reload.watchFd(), EPOLLIN, [&](uint32_t /* events */)
+    {
+        if (reload.fileChanged())
+        {
+            std::cout << "[*] " << sed_filename << " changed: reloading\n";
+            reload.request();
+        }
+    }), "Registering SED file watch with event loop");
+
+    diagnose(loop.addFd(reload.readyFd(), EPOLLIN, [&](uint32_t /* events */)
+    {
+        std::unique_ptr<SubscriptionTable> next = reload.take();
+        if (!next)
+        {
+            std::cout << "[!] Reload of " << sed_filename << " failed: " << reload.error() << " (subscriptions unchanged)\n";
+            return;
+        }
+        std::cout << "[*] Reloaded " << sed_filename << ": " << install_table(std::move(next)) << '\n';
+    }), "Registering SED reload with event loop");
+
+    diagnose(loop.addSignals({SIGHUP}, [&](const signalfd_siginfo & /* info */)
+    {
+        std::cout << "[*] Received SIGHUP: reloading " << sed_filename << '\n';
+        reload.request();
+    }), "Setting up SIGHUP handling");
+
+    // Graceful shutdown on Ctrl-C / kill
+    diagnose(loop.addSignals({SIGINT, SIGTERM}, [&](const signalfd_siginfo &info)
+    {
+        std::cout << "\n[*] Received signal " << info.ssi_signo << ", stopping...\n";
+        loop.stop();
+    }), "Setting up signal handling");
+
+    // Control socket for run-time commands
+    std::string ctrl_name = std::string("ied_recv.") + ied_name;
+    diagnose(loop.addControlSocket(ctrl_name, [&](const std::string &command) -> std::string
+    {
+        if (command == "stop")
+        {
+            loop.stop();
+            return "stopping\n";
+        }
+        else if (command == "reload")
+        {
+            reload.request();
+            return std::string("reloading ") + sed_filename + "\n";
+        }
+        else if (command == "status")
+        {
+            const std::vector<GooseSvData> &cbSubscribe = table->cbSubscribe;
+            size_t numLost{0};
+            unsigned long long numSpduLost{0};
+            for (const GooseSvData &cb : cbSubscribe)
+            {
+                numLost += cb.stream_lost;
+                numSpduLost += cb.counters.lost;
+            }
+            return "subscribed to " + std::to_string(cbSubscribe.size()) + " Control Block(s), "
+                    + std::to_string(numAccepted) + " of " + std::to_string(numPackets) + " packet(s) accepted, "
+                    + std::to_string(numLost) + " R-GOOSE stream(s) lost, "
+                    + std::to_string(numSpduLost) + " SPDU(s) lost, "
+                    + std::to_string(receiver_drops()) + " dropped by receiver\n";
+        }
+        else if (command == "latency")
+        {
+            return latency_report(table->cbSubscribe);
+        }
+        else if (command == "streams")
+        {
+            return stream_report(table->cbSubscribe, receiver_drops());
+        }
+        else if (command == "alignment")
+        {
+            if (!svAligner)
+                return "no R-SV stream subscribed\n";
+            return alignment_report(table->cbSubscribe, table->svStream, *svAligner);
+        }
+        else if (command == "87l")
+        {
+            if (!lineDiff)
+                return "87L element not enabled\n";
+            return line_diff_report(*lineDiff, decisionLatency, tripLatency);
+        }
+        else if (command == "phasors")
+        {
+            if (!phasors)
+                return "phasor estimation not enabled\n";
+            return phasor_report(*phasors, phasorSettings);
+        }
+        return "unknown command (expected: status, latency, streams, alignment, 87l, phasors, reload, stop)\n";
+    }), "Opening control socket @" + ctrl_name);
+
+    // Metrics endpoint: IED_METRICS (TCP port of 127.0.0.1, or Unix socket), by default next to the control socket
+    const char *metrics_env = std::getenv("IED_METRICS");
+    const std::string metrics_endpoint = metrics_env ? metrics_env : "@" + ctrl_name + ".metrics";
+    MetricsServer metricsServer{metrics, metrics_endpoint};
+    diagnose(metricsServer.isGood(), "Serving metrics on " + metrics_endpoint);
+
+    loop.run();
+
+    std::cout << "[*] Sequence accounting per stream:\n"
+              << stream_report(table->cbSubscribe, receiver_drops());
+    std::cout << "[*] One-way latency per stream (kernel receive time - message UtcTime):\n"
+              << latency_report(table->cbSubscribe);
+    if (svAligner)
+        std::cout << "[*] R-SV alignment by smpCnt:\n"
+                  << alignment_report(table->cbSubscribe, table->svStream, *svAligner);
+    if (lineDiff)
+        std::cout << "[*] Line differential (87L):\n"
+                  << line_diff_report(*lineDiff, decisionLatency, tripLatency);
+    if (phasors)
+        std::cout << "[*] Phasor and RMS estimation:\n"
+                  << phasor_report(*phasors, phasorSettings);
+    std::cout << "[*] Accepted " << numAccepted << " of " << numPackets << " packet(s) received. Exiting program now...\n";
 /*
 //Debugging
     for (const GooseSvData &cb: cbSubscribe)
@@ -802,8 +1268,8 @@ int main(int argc, char *argv[])
         std::cout << '\n';
         std::cout << "cbName\t: " << cb.cbName << '\n';
         std::cout << "cbType\t: " << cb.cbType << '\n';
-        std::cout << "APP ID\t: " << cb.appID << '\n';
-        std::cout << "M/C IP\t: " << cb.multicastIP << '\n';
+        std::cout << "APP ID\t: " << appid_string(cb.appID) << '\n';
+        std::cout << "M/C IP\t: " << ipv4_string(cb.multicastIP) << '\n';
         std::cout << "datSet\t: " << cb.datSetName << '\n';
         std::cout << "SPDU# \t: " << cb.prev_spduNum << '\n';
         std::cout << "stNum \t: " << cb.prev_stNum_Value << '\n';
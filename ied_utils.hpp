@@ -1,14 +1,74 @@
 /* A collection of data structure and functions for IED operations/debugging */
 
-// GOOSE/SV Data to be tracked per sending/receiving cycle
+/* Sequence accounting of a received stream (ref: account_spdu() in decode_gse_smv.hpp)
+ * Plain counters updated by the receiving thread only: cheap enough to stay on in production.
+ */
+struct StreamCounters
+{
+    static constexpr size_t GAP_BUCKETS = 16;
+    static constexpr unsigned int REORDER_WINDOW = 64;      // in SPDUs
+
+    unsigned long long received{0};             // SPDUs of the stream (whatever their order)
+    unsigned long long lost{0};                 // SPDU Numbers skipped, less those that arrived out of order later
+    unsigned long long reordered{0};            // SPDUs received after a later one, within the reorder window
+    unsigned long long duplicated{0};           // SPDU Number (or GOOSE stNum/sqNum) received again
+    unsigned long long late{0};                 // SPDUs older than the reorder window (not taken off "lost")
+    unsigned long long missed_state_changes{0}; // GOOSE: stNum increments never seen
+    unsigned long long sample_gaps{0};          // SV: smpCnt values skipped beyond those of lost SPDUs (publisher side)
+    std::array<unsigned long long, GAP_BUCKETS> gap_sizes{};   // [k]: gaps of 2^k to 2^(k+1)-1 SPDUs (last: larger)
+
+    // Sequence state
+    bool             spdu_seen{false};
+    unsigned int     highest_spduNum{0};
+    uint64_t         spdu_window{0};            // bit i set: SPDU Number (highest_spduNum - i) was received
+    unsigned int     last_gap{0};               // SPDUs skipped just before the latest one
+};
+
+/* Checks made by valid_GSE_SMV(), in their order: a message is rejected by one of them, which is the
+ * reason of the validation failure (ref: DecodeResult, metrics.hpp)
+ */
+enum class DecodeCheck : unsigned char
+{
+    Length,         // buffer length
+    Session,        // session header, lengths and signature block
+    Payload,        // payload type, simulation and APDU length
+    Appid,          // APPID of the subscription (none for a stream not subscribed to)
+    SpduNumber,     // SPDU Number outdated
+    Pdu,            // GOOSE/SV PDU fields
+    Sequence,       // stNum/sqNum or smpCnt
+    Dataset,        // typed allData (ref: datasetPlan.hpp)
+    Count
+};
+
+const char* decode_check_name(DecodeCheck check)
+{
+    static const char *names[] = {"length", "session", "payload", "appid", "spdu_number", "pdu", "sequence", "dataset"};
+    return (check < DecodeCheck::Count) ? names[static_cast<size_t>(check)] : "unknown";
+}
+
+// What valid_GSE_SMV() found in a message, for the caller's accounting
+struct DecodeResult
+{
+    DecodeCheck check{DecodeCheck::Length};     // furthest check reached: the reason of the rejection, if rejected
+    uint64_t    t_ns{0};                        // UtcTime of an accepted message (GOOSE t / SV timestamp), ns since epoch
+};
+
+struct StreamMetrics;
+
+/* GOOSE/SV Data to be tracked per sending/receiving cycle
+ * cbName and datSetName are compared byte by byte with (or copied into) every message: they are kept
+ * as strings next to the rest of the state rather than looked up in the symbol table.
+ */
 struct GooseSvData
 {
     std::string      cbName{};
-    std::string      cbType{};
-    std::string      appID{};
-    std::string      multicastIP{};
+    CbType           cbType{CbType::Unknown};
+    uint16_t         appID{0};
+    in_addr          multicastIP{};
     unsigned int     prev_spduNum{0};
     unsigned int     s_value{0};
+    StreamCounters   counters{};                // Receiver: loss, reorder and duplicate accounting
+    StreamMetrics   *metrics{nullptr};          // Receiver: counters exported for the stream (ref: metrics.hpp), if any
 
     // Specific to GOOSE
     std::string      datSetName{};
@@ -17,6 +77,11 @@ struct GooseSvData
     unsigned int     prev_sqNum_Value{0};
     unsigned int     prev_numDatSetEntries{0};
     std::vector<unsigned char> prev_allData_Value{};
+    std::shared_ptr<const DatasetPlan> datasetPlan{};  // typed allData (ref: datasetPlan.hpp), or nullptr: allData as is
+    std::vector<DataValue> datasetValues{};            // values of the DataSet (datasetPlan->values() of them, sized once)
+    unsigned int     timeAllowedToLive{0};      // in ms, as sent/received in the latest GOOSE
+    bool             stream_lost{false};        // Receiver: no valid GOOSE within timeAllowedToLive
+    unsigned int     tal_expiry_count{0};
 
     // Specific to SV (Based on IEC 61850-9-2 Light Edition (LE) implementation)
     unsigned int     prev_smpCnt_Value{0};
@@ -79,9 +144,9 @@ void printControlBlock(const ControlBlock &ctrl_blk)
 
     std::cout << "\tControl Block type \t\t= "       << ctrl_blk.cbType      << '\n';
 
-    std::cout << "\tMulticast IP Address \t\t= "     << ctrl_blk.multicastIP << '\n';
+    std::cout << "\tMulticast IP Address \t\t= "     << ipv4_string(ctrl_blk.multicastIP) << '\n';
 
-    std::cout << "\tAPP ID \t\t\t\t= "               << ctrl_blk.appID       << '\n';
+    std::cout << "\tAPP ID \t\t\t\t= "               << appid_string(ctrl_blk.appID) << '\n';
 
     std::cout << "\tVLAN ID \t\t\t= "                << ctrl_blk.vlanID      << '\n';
 
@@ -89,6 +154,9 @@ void printControlBlock(const ControlBlock &ctrl_blk)
 
     std::cout << "\tFully qualified datSetName \t= " << ctrl_blk.datSetName  << '\n';
 
+    if (ctrl_blk.cbType == CbType::GSE)
+        std::cout << "\tMinTime / MaxTime \t\t= "  << ctrl_blk.minTime << " / " << ctrl_blk.maxTime << " ms\n";
+
     std::cout << "\tInformation Model \t\t= ";
                                         display_vector(ctrl_blk.datSetVector);
     std::cout << '\n';
@@ -155,6 +223,22 @@ void convertUINT32IntoBytes(unsigned int num, std::vector<unsigned char> &vecOut
     assert (vecOut.size() >= 1 && vecOut.size() <= 4);
 }
 
+// Appends a BER Length: short form below 128, else long form 0x81 + 1 byte or 0x82 + 2 bytes (up to 0xFFFF)
+void append_ber_length(size_t len, std::vector<unsigned char> &vecOut)
+{
+    assert (len <= 0xFFFF);
+    if (len >= 0x100)
+    {
+        vecOut.push_back(0x82);
+        vecOut.push_back(static_cast<unsigned char>(len >> 8));
+    }
+    else if (len >= 0x80)
+    {
+        vecOut.push_back(0x81);
+    }
+    vecOut.push_back(static_cast<unsigned char>(len & 0xFF));
+}
+
 void getHexFromBinary(std::string binaryString, std::vector<unsigned char> &seqOfData_Value)
 {
     int result = 0;
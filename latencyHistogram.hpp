@@ -0,0 +1,128 @@
+/* Log-linear histogram of latencies (in ns), lock-free
+ *
+ * Values are grouped by power of two, and every power of two is split into SUB_BUCKETS
+ * linear sub-buckets, so the relative error is below 1/SUB_BUCKETS (~3%) over the whole
+ * range from 1 ns to 2^64 ns with a fixed array of counters. Recording is one relaxed
+ * atomic increment (no lock, no allocation), so the histogram is cheap enough to stay on
+ * in production and can be read by another thread while being updated.
+ */
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+class LatencyHistogram {
+  public:
+    static constexpr unsigned int SUB_BITS    = 5;
+    static constexpr uint64_t     SUB_BUCKETS = uint64_t{1} << SUB_BITS;
+    static constexpr size_t       BUCKETS     = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram() = default;
+    // Counters are updated in place (and may be read from other threads): keep the histogram in place
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /* Records one latency. Negative latencies (sender clock ahead of the receiver's)
+     * are counted apart and recorded as 0.
+     */
+    void record(int64_t latency_ns) {
+      if (latency_ns < 0) {
+        m_negative.fetch_add(1, std::memory_order_relaxed);
+        latency_ns = 0;
+      }
+      const uint64_t value = static_cast<uint64_t>(latency_ns);
+      m_counts[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+      m_total.fetch_add(1, std::memory_order_relaxed);
+      m_sum.fetch_add(value, std::memory_order_relaxed);
+
+      uint64_t max = m_max.load(std::memory_order_relaxed);
+      while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        ;
+    }
+
+    uint64_t count() const {
+      return m_total.load(std::memory_order_relaxed);
+    }
+
+    // Sum of the recorded latencies (negative ones as 0), in ns
+    uint64_t sum() const {
+      return m_sum.load(std::memory_order_relaxed);
+    }
+
+    uint64_t max() const {
+      return m_max.load(std::memory_order_relaxed);
+    }
+
+    uint64_t negativeCount() const {
+      return m_negative.load(std::memory_order_relaxed);
+    }
+
+    /* Value below which the fraction q (0..1) of the recorded latencies lie.
+     * Returns the upper bound of the bucket (never below the true percentile), capped at max().
+     */
+    uint64_t percentile(double q) const {
+      const uint64_t total = count();
+      if (total == 0)
+        return 0;
+
+      uint64_t rank = static_cast<uint64_t>(q * total + 0.5);
+      if (rank < 1)
+        rank = 1;
+      if (rank > total)
+        rank = total;
+
+      uint64_t seen = 0;
+      for (size_t b = 0; b < BUCKETS; b++)
+      {
+        seen += m_counts[b].load(std::memory_order_relaxed);
+        if (seen >= rank)
+          return std::min(upperBound(b), max());
+      }
+      return max();
+    }
+
+    /* Number of recorded latencies that are certainly <= limit_ns (buckets entirely below the limit) */
+    uint64_t countAtOrBelow(uint64_t limit_ns) const {
+      uint64_t n = 0;
+      for (size_t b = 0; b < BUCKETS && upperBound(b) <= limit_ns; b++)
+        n += m_counts[b].load(std::memory_order_relaxed);
+      return n;
+    }
+
+    /* Adds the latencies recorded by another histogram (e.g. of the same stream before a reload) */
+    void add(const LatencyHistogram &other) {
+      for (size_t b = 0; b < BUCKETS; b++)
+        m_counts[b].fetch_add(other.m_counts[b].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      m_total.fetch_add(other.count(), std::memory_order_relaxed);
+      m_sum.fetch_add(other.sum(), std::memory_order_relaxed);
+      m_negative.fetch_add(other.negativeCount(), std::memory_order_relaxed);
+
+      const uint64_t value = other.max();
+      uint64_t max = m_max.load(std::memory_order_relaxed);
+      while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        ;
+    }
+
+  private:
+    static size_t bucketOf(uint64_t value) {
+      if (value < SUB_BUCKETS)
+        return static_cast<size_t>(value);
+      const unsigned int shift = 63 - __builtin_clzll(value) - SUB_BITS;
+      return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    // Largest value that falls into bucket b
+    static uint64_t upperBound(size_t b) {
+      if (b < SUB_BUCKETS)
+        return b;
+      const unsigned int shift = static_cast<unsigned int>(b / SUB_BUCKETS) - 1;
+      const uint64_t low = (SUB_BUCKETS + b % SUB_BUCKETS) << shift;
+      return low + ((uint64_t{1} << shift) - 1);
+    }
+
+    std::array<std::atomic<uint64_t>, BUCKETS> m_counts{};
+    std::atomic<uint64_t>                      m_total{0};
+    std::atomic<uint64_t>                      m_sum{0};
+    std::atomic<uint64_t>                      m_max{0};
+    std::atomic<uint64_t>                      m_negative{0};
+};
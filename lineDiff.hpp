@@ -0,0 +1,144 @@
+/* Line differential (87L) element with a percentage-bias characteristic
+ *
+ * Compares the currents measured at both ends of a line, one aligned sample set at a time
+ * (ref: svAligner.hpp). Currents are counted positive into the line at both ends, so their
+ * phasor sum is the current leaving the line through an internal fault:
+ *     Idiff = |I_local + I_remote|              (differential current)
+ *     Ibias = (|I_local| + |I_remote|) / 2      (restraint current)
+ * A phase operates when Idiff lies above the dual-slope characteristic
+ *     Idiff > max(Is1, k1 * min(Ibias, Is2) + k2 * max(Ibias - Is2, 0))
+ * and the element trips once a phase has operated for trip_samples consecutive sets.
+ *
+ * The four phases (A, B, C, N) are computed together, one SIMD lane each
+ * (SSE where available, a plain loop otherwise).
+ */
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
+struct LineDiffSettings
+{
+    float        pickup{0.2f};          // Is1 (A): minimum differential current to operate
+    float        slope1{0.3f};          // k1: bias slope up to the breakpoint
+    float        breakpoint{2.0f};      // Is2 (A): restraint current where slope 2 starts
+    float        slope2{0.8f};          // k2: bias slope beyond the breakpoint (CT saturation on through faults)
+    unsigned int trip_samples{2};       // consecutive operating sets before tripping (>= 1)
+};
+
+class LineDiff {
+  public:
+    static constexpr size_t PHASES = 4;                 // A, B, C, N
+
+    /* R-SV sample layout (SVdata.txt): 4 sets of voltage magnitude, voltage angle,
+     * current magnitude, current angle (degrees), one set per phase
+     */
+    static constexpr size_t VALUES_PER_PHASE = 4;
+    static constexpr size_t CURRENT_MAG      = 2;
+    static constexpr size_t CURRENT_ANGLE    = 3;
+
+    struct Result
+    {
+      alignas(16) std::array<float, PHASES> idiff{};
+      alignas(16) std::array<float, PHASES> ibias{};
+      unsigned int operate{0};      // bit p: phase p above the characteristic
+      bool         trip{false};
+      bool         changed{false};  // trip state differs from the previous set
+    };
+
+    explicit LineDiff(const LineDiffSettings &settings) : m_settings{settings} {}
+
+    /* Evaluates one aligned sample set. local/remote point to the values of one R-SV sample
+     * of each end of the line (at least PHASES * VALUES_PER_PHASE floats).
+     */
+    const Result& evaluate(const float *local, const float *remote) {
+      alignas(16) float l_re[PHASES], l_im[PHASES], r_re[PHASES], r_im[PHASES];
+      alignas(16) float l_mag[PHASES], r_mag[PHASES];
+      toRectangular(local, l_mag, l_re, l_im);
+      toRectangular(remote, r_mag, r_re, r_im);
+
+#ifdef __SSE2__
+      const __m128 sign = _mm_set1_ps(-0.0f);
+      const __m128 re = _mm_add_ps(_mm_load_ps(l_re), _mm_load_ps(r_re));
+      const __m128 im = _mm_add_ps(_mm_load_ps(l_im), _mm_load_ps(r_im));
+      const __m128 idiff = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)));
+      const __m128 ibias = _mm_mul_ps(_mm_set1_ps(0.5f),
+                                      _mm_add_ps(_mm_andnot_ps(sign, _mm_load_ps(l_mag)),
+                                                 _mm_andnot_ps(sign, _mm_load_ps(r_mag))));
+
+      const __m128 is2 = _mm_set1_ps(m_settings.breakpoint);
+      const __m128 below = _mm_min_ps(ibias, is2);
+      const __m128 beyond = _mm_max_ps(_mm_sub_ps(ibias, is2), _mm_setzero_ps());
+      const __m128 threshold = _mm_max_ps(_mm_set1_ps(m_settings.pickup),
+                                          _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m_settings.slope1), below),
+                                                     _mm_mul_ps(_mm_set1_ps(m_settings.slope2), beyond)));
+
+      _mm_store_ps(m_result.idiff.data(), idiff);
+      _mm_store_ps(m_result.ibias.data(), ibias);
+      m_result.operate = static_cast<unsigned int>(_mm_movemask_ps(_mm_cmpgt_ps(idiff, threshold)));
+#else
+      m_result.operate = 0;
+      for (size_t p = 0; p < PHASES; p++)
+      {
+        const float re = l_re[p] + r_re[p], im = l_im[p] + r_im[p];
+        m_result.idiff[p] = std::sqrt(re * re + im * im);
+        m_result.ibias[p] = 0.5f * (std::fabs(l_mag[p]) + std::fabs(r_mag[p]));
+        const float below = std::fmin(m_result.ibias[p], m_settings.breakpoint);
+        const float beyond = std::fmax(m_result.ibias[p] - m_settings.breakpoint, 0.0f);
+        const float threshold = std::fmax(m_settings.pickup, m_settings.slope1 * below + m_settings.slope2 * beyond);
+        if (m_result.idiff[p] > threshold)
+          m_result.operate |= 1u << p;
+      }
+#endif
+
+      bool trip = false;
+      for (size_t p = 0; p < PHASES; p++)
+      {
+        m_consecutive[p] = (m_result.operate & (1u << p)) ? m_consecutive[p] + 1 : 0;
+        trip = trip || (m_consecutive[p] >= m_settings.trip_samples);
+      }
+      m_result.changed = (trip != m_result.trip);
+      m_result.trip = trip;
+
+      m_evaluations++;
+      if (m_result.changed && trip)
+        m_trips++;
+      return m_result;
+    }
+
+    // A set without both ends cannot be compared: operating counts start over
+    void missingEnd() {
+      m_consecutive.fill(0);
+      m_missing++;
+    }
+
+    const LineDiffSettings& settings() const { return m_settings; }
+    const Result& last() const               { return m_result; }
+    bool tripped() const                     { return m_result.trip; }
+    uint64_t evaluations() const             { return m_evaluations; }
+    uint64_t trips() const                   { return m_trips; }
+    uint64_t missing() const                 { return m_missing; }
+
+  private:
+    // Current phasors of one sample (magnitude/angle in degrees) as real and imaginary parts
+    static void toRectangular(const float *values, float *mag, float *re, float *im) {
+      constexpr float DEG_TO_RAD = 3.14159265358979f / 180.0f;
+      for (size_t p = 0; p < PHASES; p++)
+      {
+        mag[p] = values[p * VALUES_PER_PHASE + CURRENT_MAG];
+        const float angle = values[p * VALUES_PER_PHASE + CURRENT_ANGLE] * DEG_TO_RAD;
+        re[p] = mag[p] * std::cos(angle);
+        im[p] = mag[p] * std::sin(angle);
+      }
+    }
+
+    LineDiffSettings                  m_settings;
+    Result                            m_result{};
+    std::array<unsigned int, PHASES>  m_consecutive{};
+    uint64_t                          m_evaluations{0};
+    uint64_t                          m_trips{0};
+    uint64_t                          m_missing{0};
+};
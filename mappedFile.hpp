@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <cstddef>
+#include <fcntl.h>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Read-only memory mapping of a whole file
+ * Pages are read in by the kernel on first access and stay in the page cache: scanning a large
+ * file through the mapping costs no heap memory.
+ */
+class MappedFile {
+  public:
+    explicit MappedFile(const char *filename) {
+      int fd = open(filename, O_RDONLY | O_CLOEXEC);
+      if (fd < 0)
+        return;
+      struct stat st{};
+      if (fstat(fd, &st) == 0 && st.st_size > 0)
+      {
+        void *data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+          m_data = static_cast<const char*>(data);
+          m_size = static_cast<size_t>(st.st_size);
+          madvise(data, m_size, MADV_SEQUENTIAL);
+        }
+      }
+      close(fd);
+    }
+    ~MappedFile() {
+      // make sure the mapping doesn't leak
+      if (isGood())
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+    // Don't need the other default operations
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    std::string_view operator()() const {
+      return std::string_view(m_data, m_size);
+    }
+
+    bool isGood() const {
+      return m_data != nullptr;
+    }
+
+    // Drops the pages before offset from the process (read again from the file if accessed later)
+    void release(size_t offset) {
+      const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+      const size_t end = std::min(offset, m_size) / page * page;
+      if (isGood() && end > m_released)
+      {
+        madvise(const_cast<char*>(m_data) + m_released, end - m_released, MADV_DONTNEED);
+        m_released = end;
+      }
+    }
+
+  private:
+    const char *m_data = nullptr;
+    size_t      m_size = 0;
+    size_t      m_released = 0;
+};
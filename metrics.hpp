@@ -0,0 +1,515 @@
+/* Metrics of an IED, served as Prometheus text on a local endpoint
+ *
+ * Counters are written by the packet threads without ever taking a lock:
+ *  - ThreadMetrics: the counters of one thread (packets, bytes, validation failures by reason, TAL
+ *    expiries, encode and send time), in a block of its own aligned on cache lines, so that no two
+ *    threads write to the same line. A counter has a single writer: it is updated with a relaxed load
+ *    and store (no locked instruction), and read by the exporter with relaxed loads.
+ *  - StreamMetrics: the counters of one received stream, published from its StreamCounters by the
+ *    receiving thread, and its latency histogram. They are kept by subscription key, so that a stream
+ *    unchanged by a reload of the SED file keeps counting.
+ * Blocks are registered once (at start-up, on a reload) and never freed before the registry.
+ * MetricsServer formats them only when scraped, on a thread of its own at the lowest priority
+ * (SCHED_IDLE): HTTP GET /metrics on a Unix socket (abstract name with a leading '@', or a path) or on
+ * a TCP port of 127.0.0.1.
+ */
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Nanoseconds on the monotonic clock (encode and send time)
+inline uint64_t monotonic_ns()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+// Counter with a single writer: incremented without a locked instruction
+inline void single_writer_add(std::atomic<uint64_t> &counter, uint64_t n)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// Counters of a thread
+enum class Counter : unsigned char
+{
+    PacketsReceived,
+    BytesReceived,
+    PacketsAccepted,
+    TalExpiries,
+    PacketsSent,
+    BytesSent,
+    EncodeNs,
+    SendNs,
+    Count
+};
+
+// Counters of a received stream
+enum class StreamCounter : unsigned char
+{
+    Received,
+    Accepted,
+    Bytes,
+    Lost,
+    Reordered,
+    Duplicated,
+    Late,
+    MissedStateChanges,
+    SampleGaps,
+    TalExpiries,
+    Count
+};
+
+class alignas(64) ThreadMetrics {
+  public:
+    explicit ThreadMetrics(const std::string &thread) : m_thread(thread) {}
+    // Counters are updated in place (and read from the exporter thread): keep the block in place
+    ThreadMetrics(const ThreadMetrics&) = delete;
+    ThreadMetrics& operator=(const ThreadMetrics&) = delete;
+
+    // Owning thread only
+    void add(Counter counter, uint64_t n = 1) {
+      single_writer_add(m_counters[static_cast<size_t>(counter)], n);
+    }
+
+    // Owning thread only: a message rejected by valid_GSE_SMV() at the given check
+    void rejected(DecodeCheck reason) {
+      single_writer_add(m_rejected[static_cast<size_t>(reason)], 1);
+    }
+
+    uint64_t value(Counter counter) const {
+      return m_counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    }
+
+    uint64_t rejections(DecodeCheck reason) const {
+      return m_rejected[static_cast<size_t>(reason)].load(std::memory_order_relaxed);
+    }
+
+    const std::string& thread() const {
+      return m_thread;
+    }
+
+  private:
+    alignas(64) std::array<std::atomic<uint64_t>, static_cast<size_t>(Counter::Count)> m_counters{};
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(DecodeCheck::Count)> m_rejected{};
+    const std::string m_thread;
+};
+
+class alignas(64) StreamMetrics {
+  public:
+    StreamMetrics(const GooseSvData &cb) : m_type(cb_type_name(cb.cbType)), m_cbName(cb.cbName), m_appID(appid_string(cb.appID)) {}
+    // Counters are updated in place (and read from the exporter thread): keep the block in place
+    StreamMetrics(const StreamMetrics&) = delete;
+    StreamMetrics& operator=(const StreamMetrics&) = delete;
+
+    // Receiving thread only: a message of the stream accepted
+    void accepted(int bytes) {
+      single_writer_add(m_counters[static_cast<size_t>(StreamCounter::Accepted)], 1);
+      single_writer_add(m_counters[static_cast<size_t>(StreamCounter::Bytes)], static_cast<uint64_t>(bytes));
+    }
+
+    // Receiving thread only: the stream's sequence accounting, once it has changed
+    void publish(const StreamCounters &c) {
+      set(StreamCounter::Received, c.received);
+      set(StreamCounter::Lost, c.lost);
+      set(StreamCounter::Reordered, c.reordered);
+      set(StreamCounter::Duplicated, c.duplicated);
+      set(StreamCounter::Late, c.late);
+      set(StreamCounter::MissedStateChanges, c.missed_state_changes);
+      set(StreamCounter::SampleGaps, c.sample_gaps);
+    }
+
+    // Receiving thread only
+    void talExpired() {
+      single_writer_add(m_counters[static_cast<size_t>(StreamCounter::TalExpiries)], 1);
+    }
+
+    LatencyHistogram& latency() {
+      return m_latency;
+    }
+
+    const LatencyHistogram& latency() const {
+      return m_latency;
+    }
+
+    uint64_t value(StreamCounter counter) const {
+      return m_counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    }
+
+    // Exported only while in the subscription table in use
+    void setSubscribed(bool subscribed) {
+      m_subscribed.store(subscribed, std::memory_order_relaxed);
+    }
+
+    bool subscribed() const {
+      return m_subscribed.load(std::memory_order_relaxed);
+    }
+
+    // Prometheus labels of the stream
+    std::string labels() const;
+
+  private:
+    void set(StreamCounter counter, uint64_t value) {
+      m_counters[static_cast<size_t>(counter)].store(value, std::memory_order_relaxed);
+    }
+
+    alignas(64) std::array<std::atomic<uint64_t>, static_cast<size_t>(StreamCounter::Count)> m_counters{};
+    std::atomic<bool> m_subscribed{true};
+    LatencyHistogram  m_latency{};
+    const std::string m_type;
+    const std::string m_cbName;
+    const std::string m_appID;
+};
+
+// Label value in the Prometheus text format: backslash, double quote and line feed escaped
+std::string prometheus_label(const std::string &value)
+{
+    std::string escaped{};
+    escaped.reserve(value.size());
+    for (char c : value)
+    {
+        if (c == '\\' || c == '"')
+            escaped += '\\';
+        if (c == '\n')
+        {
+            escaped += "\\n";
+            continue;
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+std::string StreamMetrics::labels() const
+{
+    return "type=\"" + m_type + "\",cb=\"" + prometheus_label(m_cbName) + "\",appid=\"" + m_appID + "\"";
+}
+
+class MetricsRegistry {
+  public:
+    MetricsRegistry() = default;
+    // Don't need the other default operations
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+    MetricsRegistry(MetricsRegistry&&) = delete;
+    MetricsRegistry& operator=(MetricsRegistry&&) = delete;
+
+    // Counters of the calling thread (to be called once by each thread)
+    ThreadMetrics& thread(const std::string &name) {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_threads.push_back(std::make_unique<ThreadMetrics>(name));
+      return *m_threads.back();
+    }
+
+    // Counters of the stream of a subscription, by its key: those of an earlier subscription with the same key
+    StreamMetrics& stream(const std::string &key, const GooseSvData &cb) {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      std::unordered_map<std::string, size_t>::iterator found = m_streamIndex.find(key);
+      if (found == m_streamIndex.end())
+      {
+        found = m_streamIndex.emplace(key, m_streams.size()).first;
+        m_streams.push_back(std::make_unique<StreamMetrics>(cb));
+      }
+      m_streams[found->second]->setSubscribed(true);
+      return *m_streams[found->second];
+    }
+
+    // Streams no longer subscribed to (before the streams of a new subscription table are looked up)
+    void unsubscribeAll() {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      for (std::unique_ptr<StreamMetrics> &s : m_streams)
+        s->setSubscribed(false);
+    }
+
+    // Prometheus text format (version 0.0.4) of all the metrics
+    std::string render() const;
+
+  private:
+    mutable std::mutex                          m_mutex;        // registration only: never taken by the packet threads otherwise
+    std::vector<std::unique_ptr<ThreadMetrics>> m_threads{};
+    std::vector<std::unique_ptr<StreamMetrics>> m_streams{};
+    std::unordered_map<std::string, size_t>     m_streamIndex{};
+};
+
+std::string MetricsRegistry::render() const
+{
+    struct Family
+    {
+        const char *name;
+        const char *help;
+        double      scale;      // of the counter's value (ns to s)
+    };
+    static const Family thread_families[] = {
+        {"ied_packets_received_total", "Datagrams received", 0},
+        {"ied_bytes_received_total", "Bytes of the datagrams received (UDP payload)", 0},
+        {"ied_packets_accepted_total", "Datagrams accepted by a subscription", 0},
+        {"ied_tal_expiries_total", "R-GOOSE streams lost (no valid message within timeAllowedToLive)", 0},
+        {"ied_packets_sent_total", "R-GOOSE/R-SV messages sent", 0},
+        {"ied_bytes_sent_total", "Bytes of the messages sent (UDP payload)", 0},
+        {"ied_encode_seconds_total", "Time spent forming the messages sent", 1e-9},
+        {"ied_send_seconds_total", "Time spent sending the messages", 1e-9},
+    };
+    static const Family stream_families[] = {
+        {"ied_stream_received_total", "SPDUs of the stream received, whatever their order", 0},
+        {"ied_stream_accepted_total", "Messages of the stream accepted", 0},
+        {"ied_stream_bytes_total", "Bytes of the messages of the stream accepted", 0},
+        {"ied_stream_lost_total", "SPDU Numbers skipped, less those received out of order later", 0},
+        {"ied_stream_reordered_total", "SPDUs received after a later one", 0},
+        {"ied_stream_duplicated_total", "SPDU Numbers (or GOOSE stNum/sqNum) received again", 0},
+        {"ied_stream_late_total", "SPDUs older than the reorder window", 0},
+        {"ied_stream_missed_state_changes_total", "GOOSE stNum increments never seen", 0},
+        {"ied_stream_sample_gaps_total", "SV smpCnt values skipped by the publisher", 0},
+        {"ied_stream_tal_expiries_total", "Expiries of the stream's timeAllowedToLive", 0},
+    };
+    // Buckets of the latency histograms (in ns)
+    static const uint64_t latency_buckets[] = {10'000, 50'000, 100'000, 250'000, 500'000, 1'000'000, 2'500'000,
+                                               5'000'000, 10'000'000, 25'000'000, 100'000'000, 1'000'000'000};
+
+    // The blocks are never freed: only the list is copied under the lock, not their counters
+    std::vector<const ThreadMetrics*> threads{};
+    std::vector<const StreamMetrics*> streams{};
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        for (const std::unique_ptr<ThreadMetrics> &t : m_threads)
+            threads.push_back(t.get());
+        for (const std::unique_ptr<StreamMetrics> &s : m_streams)
+        {
+            if (s->subscribed())
+                streams.push_back(s.get());
+        }
+    }
+
+    std::string text{};
+    char number[32];
+    auto value = [&number](uint64_t v, double scale) -> const char*
+    {
+        if (scale > 0)
+            std::snprintf(number, sizeof(number), "%.9g", v * scale);
+        else
+            std::snprintf(number, sizeof(number), "%llu", static_cast<unsigned long long>(v));
+        return number;
+    };
+    auto family = [&text](const char *name, const char *help, const char *type)
+    {
+        text += std::string("# HELP ") + name + ' ' + help + "\n# TYPE " + name + ' ' + type + '\n';
+    };
+
+    for (size_t c = 0; c < static_cast<size_t>(Counter::Count); c++)
+    {
+        const Family &f = thread_families[c];
+        family(f.name, f.help, "counter");
+        for (const ThreadMetrics *t : threads)
+            text += std::string(f.name) + "{thread=\"" + prometheus_label(t->thread()) + "\"} "
+                    + value(t->value(static_cast<Counter>(c)), f.scale) + '\n';
+    }
+
+    family("ied_validation_failures_total", "Datagrams rejected by every subscription, by the check that rejected them", "counter");
+    for (const ThreadMetrics *t : threads)
+    {
+        for (size_t r = 0; r < static_cast<size_t>(DecodeCheck::Count); r++)
+            text += "ied_validation_failures_total{thread=\"" + prometheus_label(t->thread()) + "\",reason=\""
+                    + decode_check_name(static_cast<DecodeCheck>(r)) + "\"} "
+                    + value(t->rejections(static_cast<DecodeCheck>(r)), 0) + '\n';
+    }
+
+    if (streams.empty())
+        return text;
+
+    for (size_t c = 0; c < static_cast<size_t>(StreamCounter::Count); c++)
+    {
+        const Family &f = stream_families[c];
+        family(f.name, f.help, "counter");
+        for (const StreamMetrics *s : streams)
+            text += std::string(f.name) + '{' + s->labels() + "} " + value(s->value(static_cast<StreamCounter>(c)), f.scale) + '\n';
+    }
+
+    // Bucket counts are those certainly below the bound (ref: LatencyHistogram::countAtOrBelow())
+    family("ied_stream_latency_seconds", "One-way latency of the stream's messages (UtcTime of the message to reception)", "histogram");
+    for (const StreamMetrics *s : streams)
+    {
+        const LatencyHistogram &latency = s->latency();
+        const uint64_t count = latency.count();
+        const std::string labels = s->labels();
+        for (uint64_t bound : latency_buckets)
+        {
+            text += "ied_stream_latency_seconds_bucket{" + labels + ",le=\"" + value(bound, 1e-9) + "\"} ";
+            text += value(std::min(latency.countAtOrBelow(bound), count), 0);
+            text += '\n';
+        }
+        text += "ied_stream_latency_seconds_bucket{" + labels + ",le=\"+Inf\"} " + value(count, 0) + '\n';
+        text += "ied_stream_latency_seconds_sum{" + labels + "} " + value(latency.sum(), 1e-9) + '\n';
+        text += "ied_stream_latency_seconds_count{" + labels + "} " + value(count, 0) + '\n';
+    }
+    return text;
+}
+
+class MetricsServer {
+  public:
+    /* Serves the registry's metrics on endpoint: a TCP port of 127.0.0.1 (digits only), or else a Unix
+     * socket (abstract name with a leading '@', or a path)
+     */
+    MetricsServer(const MetricsRegistry &registry, const std::string &endpoint) : m_registry(registry) {
+      m_fd = listen_on(endpoint);
+      m_stop = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if (isGood())
+        m_thread = std::thread(&MetricsServer::run, this);
+    }
+    ~MetricsServer() {
+      if (m_thread.joinable()) {
+        const uint64_t one{1};
+        if (write(m_stop, &one, sizeof(one)) == sizeof(one))
+          m_thread.join();
+        else
+          m_thread.detach();
+      }
+      if (m_fd >= 0)
+        close(m_fd);
+      if (m_stop >= 0)
+        close(m_stop);
+      if (!m_path.empty())
+        unlink(m_path.c_str());
+    }
+    // Don't need the other default operations
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+    MetricsServer(MetricsServer&&) = delete;
+    MetricsServer& operator=(MetricsServer&&) = delete;
+
+    bool isGood() const {
+      return m_fd >= 0 && m_stop >= 0;
+    }
+
+  private:
+    int listen_on(const std::string &endpoint) {
+      if (!endpoint.empty() && endpoint.find_first_not_of("0123456789") == std::string::npos) {
+        const unsigned long port = std::stoul(endpoint);
+        if (port > 65535)
+          return -1;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int reuse = 1;
+        if (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0
+            || bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+          if (fd >= 0)
+            close(fd);
+          return -1;
+        }
+        return fd;
+      }
+
+      sockaddr_un addr{};
+      addr.sun_family = AF_UNIX;
+      if (endpoint.empty() || endpoint.size() >= sizeof(addr.sun_path))
+        return -1;
+      endpoint.copy(addr.sun_path, endpoint.size());
+      socklen_t addr_len = offsetof(sockaddr_un, sun_path) + endpoint.size();
+      if (endpoint[0] == '@') {
+        addr.sun_path[0] = '\0';        // abstract namespace
+      } else {
+        // A socket left by an earlier run is replaced (anything else at the path is not)
+        struct stat st{};
+        if (stat(endpoint.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+          unlink(endpoint.c_str());
+        addr_len += 1;
+      }
+      int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      if (fd < 0 || bind(fd, (sockaddr*)&addr, addr_len) < 0 || listen(fd, 16) < 0) {
+        if (fd >= 0)
+          close(fd);
+        return -1;
+      }
+      if (endpoint[0] != '@')
+        m_path = endpoint;
+      return fd;
+    }
+
+    void run() {
+      // Scraping only runs when no other thread of the process has work to do
+      sched_param param{};
+      pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+
+      pollfd fds[2] = {{m_fd, POLLIN, 0}, {m_stop, POLLIN, 0}};
+      for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+          if (errno == EINTR)
+            continue;
+          return;
+        }
+        if (fds[1].revents)
+          return;
+        int conn = accept4(m_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (conn >= 0) {
+          serve(conn);
+          close(conn);
+        }
+      }
+    }
+
+    // One HTTP/1.0 request per connection: GET /metrics (or /)
+    void serve(int conn) {
+      timeval timeout{1, 0};
+      setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+      setsockopt(conn, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+      std::string request{};
+      char buf[1024];
+      while (request.size() < 8192 && request.find("\r\n\r\n") == std::string::npos) {
+        ssize_t n = recv(conn, buf, sizeof(buf), 0);
+        if (n <= 0)
+          break;
+        request.append(buf, n);
+      }
+
+      std::string status{"200 OK"}, body{};
+      const size_t path_end = request.find_first_of(" ?\r\n", 4);
+      const std::string path = (request.compare(0, 4, "GET ") == 0 && path_end != std::string::npos)
+                               ? request.substr(4, path_end - 4) : "";
+      if (path == "/metrics" || path == "/")
+        body = m_registry.render();
+      else if (request.compare(0, 4, "GET ") != 0)
+        status = "405 Method Not Allowed";
+      else
+        status = "404 Not Found";
+
+      std::string response = "HTTP/1.0 " + status + "\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                             "Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+      for (size_t sent = 0; sent < response.size(); ) {
+        ssize_t n = send(conn, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+          return;
+        sent += n;
+      }
+    }
+
+    const MetricsRegistry &m_registry;
+    int                    m_fd{-1};
+    int                    m_stop{-1};       // eventfd: written to stop the thread
+    std::string            m_path{};         // Unix socket path to remove (not in the abstract namespace)
+    std::thread            m_thread{};
+};
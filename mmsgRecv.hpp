@@ -0,0 +1,93 @@
+/* Batched receive from a UDP socket with recvmmsg(2)
+ *
+ * One system call fetches up to BATCH datagrams into a fixed set of buffers, instead of
+ * one recvfrom() per datagram. The socket (not owned) must be bound and non-blocking.
+ */
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+class MmsgRecv {
+  public:
+    static constexpr unsigned int BATCH    = 64;
+    static constexpr unsigned int BUF_SIZE = 2048;
+
+    explicit MmsgRecv(int sd) : m_sd{sd}, m_bufs(static_cast<size_t>(BATCH) * BUF_SIZE) {
+      for (unsigned int i = 0; i < BATCH; i++)
+      {
+        m_iovs[i].iov_base = &m_bufs[static_cast<size_t>(i) * BUF_SIZE];
+        m_iovs[i].iov_len  = BUF_SIZE;
+        m_msgs[i].msg_hdr.msg_iov     = &m_iovs[i];
+        m_msgs[i].msg_hdr.msg_iovlen  = 1;
+        m_msgs[i].msg_hdr.msg_name    = &m_addrs[i];
+        m_msgs[i].msg_hdr.msg_control = &m_controls[i];
+      }
+    }
+    // Don't need the other default operations
+    MmsgRecv(const MmsgRecv&) = delete;
+    MmsgRecv& operator=(const MmsgRecv&) = delete;
+    MmsgRecv(MmsgRecv&&) = delete;
+    MmsgRecv& operator=(MmsgRecv&&) = delete;
+
+    int operator()() const {
+      return m_sd;
+    }
+
+    bool isGood() const {
+      return m_sd >= 0;
+    }
+
+    /* Calls handler(const unsigned char *udp_payload, int length, in_addr source, uint64_t rx_time_ns)
+     * for each datagram queued on the socket, BATCH datagrams per system call.
+     * rx_time_ns is the kernel's receive timestamp if enabled on the socket (ref: rxTimestamp.hpp).
+     * Returns the number of datagrams handed to the handler.
+     */
+    template <typename Handler>
+    size_t drain(Handler &&handler) {
+      size_t count = 0;
+
+      while (true)
+      {
+        for (unsigned int i = 0; i < BATCH; i++)
+        {
+          m_msgs[i].msg_hdr.msg_namelen    = sizeof(sockaddr_in);
+          m_msgs[i].msg_hdr.msg_controllen = sizeof(Control);
+        }
+
+        int n = recvmmsg(m_sd, m_msgs.data(), BATCH, MSG_DONTWAIT, nullptr);
+        if (n <= 0)
+          break;
+
+        for (int i = 0; i < n; i++)
+        {
+          // Truncated datagrams are too long for any R-GOOSE/R-SV message anyway
+          if (m_msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+            continue;
+          handler(&m_bufs[static_cast<size_t>(i) * BUF_SIZE], static_cast<int>(m_msgs[i].msg_len),
+                  m_addrs[i].sin_addr, rx_timestamp_ns(m_msgs[i].msg_hdr));
+          count++;
+        }
+
+        // A partial batch means the queue is empty: spare the call that would return EAGAIN
+        if (static_cast<unsigned int>(n) < BATCH)
+          break;
+      }
+      return count;
+    }
+
+  private:
+    // Ancillary data of one datagram, aligned for cmsghdr
+    struct alignas(cmsghdr) Control {
+      unsigned char bytes[RX_TIMESTAMP_CONTROL_LEN];
+    };
+
+    int                              m_sd = -1;
+    std::vector<unsigned char>       m_bufs{};
+    std::array<iovec, BATCH>         m_iovs{};
+    std::array<sockaddr_in, BATCH>   m_addrs{};
+    std::array<Control, BATCH>       m_controls{};
+    std::array<mmsghdr, BATCH>       m_msgs{};
+};
@@ -0,0 +1,233 @@
+/* AF_PACKET receive socket with a TPACKET_V3 memory-mapped RX ring
+ *
+ * The kernel writes every matching frame straight into a ring of blocks shared
+ * with user space, so datagrams are not copied through the socket layer
+ * (no recvfrom() per packet). A classic BPF filter attached to the socket keeps
+ * only IPv4 UDP datagrams for IEDUDPPORT, and the multicast groups are joined at
+ * link level (PACKET_ADD_MEMBERSHIP) since no UDP socket is bound to the port.
+ *
+ * drain() hands the decoder pointers into the ring blocks themselves; a block is
+ * given back to the kernel only after every datagram in it has been handled.
+ */
+#include <cstdint>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* Locates the UDP payload in an IPv4 packet (already filtered for UDP by a BPF program) */
+bool locate_udp_payload(const unsigned char *l3, size_t l3_len,
+                        const unsigned char *&payload, int &payload_len, in_addr &source) {
+    if (l3_len < sizeof(iphdr))
+        return false;
+
+    const iphdr *ip = reinterpret_cast<const iphdr*>(l3);
+    const size_t ip_hdr_len = ip->ihl * 4u;
+    const size_t ip_tot_len = ntohs(ip->tot_len);
+    if (ip->version != 4 || ip_hdr_len < sizeof(iphdr) || ip_tot_len > l3_len
+        || ip_tot_len < ip_hdr_len + sizeof(udphdr))
+        return false;
+
+    const udphdr *udp = reinterpret_cast<const udphdr*>(l3 + ip_hdr_len);
+    const size_t udp_len = ntohs(udp->len);
+    if (udp_len < sizeof(udphdr) || udp_len > ip_tot_len - ip_hdr_len)
+        return false;
+
+    payload     = l3 + ip_hdr_len + sizeof(udphdr);
+    payload_len = static_cast<int>(udp_len - sizeof(udphdr));
+    source.s_addr = ip->saddr;
+    return true;
+}
+
+class PacketRing {
+  public:
+    // Ring geometry: 64 blocks of 256 KiB, each block retired to user space at most 1 ms after its first frame
+    static constexpr unsigned int BLOCK_SIZE   = 1u << 18;
+    static constexpr unsigned int BLOCK_NR     = 64;
+    static constexpr unsigned int FRAME_SIZE   = 2048;
+    static constexpr unsigned int BLOCK_TMO_MS = 1;
+
+    PacketRing(const char *ifname, uint16_t udp_port) {
+      m_sd = socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, htons(ETH_P_IP));
+      if (m_sd < 0)
+        return;
+      if (!setup(ifname, udp_port)) {
+        close(m_sd);
+        m_sd = -1;
+      }
+    }
+    ~PacketRing() {
+      // make sure the ring and socket resources don't leak
+      if (m_ring != MAP_FAILED)
+        munmap(m_ring, static_cast<size_t>(BLOCK_SIZE) * BLOCK_NR);
+      if (isGood())
+        close(m_sd);
+    }
+    // Don't need the other default operations
+    PacketRing(const PacketRing&) = delete;
+    PacketRing& operator=(const PacketRing&) = delete;
+    PacketRing(PacketRing&&) = delete;
+    PacketRing& operator=(PacketRing&&) = delete;
+
+    int operator()() const {
+      return m_sd;
+    }
+
+    bool isGood() const {
+      return m_sd >= 0;
+    }
+
+    /* Accepts frames for the multicast group on the interface (Ethernet MAC 01:00:5e + low 23 bits of the IPv4 group) */
+    bool addMulticastGroup(in_addr group) {
+      return membership(group, PACKET_ADD_MEMBERSHIP);
+    }
+
+    bool dropMulticastGroup(in_addr group) {
+      return membership(group, PACKET_DROP_MEMBERSHIP);
+    }
+
+    /* Calls handler(const unsigned char *udp_payload, int length, in_addr source, uint64_t rx_time_ns)
+     * for each datagram in every block that the kernel has retired to user space, then gives the blocks back.
+     * rx_time_ns is the kernel's (software) receive timestamp of the frame.
+     * Returns the number of datagrams handed to the handler.
+     */
+    template <typename Handler>
+    size_t drain(Handler &&handler) {
+      size_t count = 0;
+
+      while (true)
+      {
+        auto *block = reinterpret_cast<tpacket_block_desc*>(
+                          static_cast<unsigned char*>(m_ring) + static_cast<size_t>(m_block_idx) * BLOCK_SIZE);
+        if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0)
+          break;
+
+        auto *frame = reinterpret_cast<tpacket3_hdr*>(
+                          reinterpret_cast<unsigned char*>(block) + block->hdr.bh1.offset_to_first_pkt);
+        for (uint32_t i = 0; i < block->hdr.bh1.num_pkts; i++)
+        {
+          const unsigned char *l3 = reinterpret_cast<const unsigned char*>(frame) + frame->tp_net;
+          const size_t l3_len = frame->tp_snaplen - (frame->tp_net - frame->tp_mac);
+
+          const unsigned char *payload{};
+          int payload_len{};
+          in_addr source{};
+          if (locate_udp_payload(l3, l3_len, payload, payload_len, source))
+          {
+            const uint64_t rx_time_ns = static_cast<uint64_t>(frame->tp_sec) * 1'000'000'000 + frame->tp_nsec;
+            handler(payload, payload_len, source, rx_time_ns);
+            count++;
+          }
+          frame = reinterpret_cast<tpacket3_hdr*>(reinterpret_cast<unsigned char*>(frame) + frame->tp_next_offset);
+        }
+
+        // Give the block back to the kernel
+        __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        m_block_idx = (m_block_idx + 1) % BLOCK_NR;
+      }
+      return count;
+    }
+
+    // Frames dropped by the kernel because the ring was full (receiver overload)
+    uint64_t drops() {
+      tpacket_stats_v3 stats{};
+      socklen_t len = sizeof(stats);
+      // Kernel statistics are reset by each read: keep the running total
+      if (getsockopt(m_sd, SOL_PACKET, PACKET_STATISTICS, &stats, &len) == 0)
+        m_drops += stats.tp_drops;
+      return m_drops;
+    }
+
+  private:
+    // PACKET_ADD_MEMBERSHIP / PACKET_DROP_MEMBERSHIP of the Ethernet multicast address of an IPv4 group
+    bool membership(in_addr group, int option) {
+      uint32_t addr = ntohl(group.s_addr);
+
+      packet_mreq mreq{};
+      mreq.mr_ifindex = m_ifindex;
+      mreq.mr_type    = PACKET_MR_MULTICAST;
+      mreq.mr_alen    = ETH_ALEN;
+      mreq.mr_address[0] = 0x01;
+      mreq.mr_address[1] = 0x00;
+      mreq.mr_address[2] = 0x5e;
+      mreq.mr_address[3] = (addr >> 16) & 0x7f;
+      mreq.mr_address[4] = (addr >>  8) & 0xff;
+      mreq.mr_address[5] = (addr      ) & 0xff;
+      return setsockopt(m_sd, SOL_PACKET, option, &mreq, sizeof(mreq)) == 0;
+    }
+
+    bool setup(const char *ifname, uint16_t udp_port) {
+      m_ifindex = if_nametoindex(ifname);
+      if (m_ifindex == 0)
+        return false;
+
+      int version = TPACKET_V3;
+      if (setsockopt(m_sd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+        return false;
+
+      // Frames sent by this host (e.g. on loopback) would otherwise be seen twice
+      int ignore_outgoing = 1;
+      setsockopt(m_sd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &ignore_outgoing, sizeof(ignore_outgoing));
+
+      /* Keep IPv4, non-fragmented, UDP datagrams whose destination port is udp_port
+       * (frames start at the Ethernet header; equivalent to tcpdump -dd "udp dst port 102")
+       */
+      sock_filter filter[] = {
+        BPF_STMT(BPF_LD  | BPF_H   | BPF_ABS, 12),                  // EtherType
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,   ETH_P_IP, 0, 8),
+        BPF_STMT(BPF_LD  | BPF_B   | BPF_ABS, 23),                  // IPv4 protocol
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,   IPPROTO_UDP, 0, 6),
+        BPF_STMT(BPF_LD  | BPF_H   | BPF_ABS, 20),                  // IPv4 flags & fragment offset
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K,  0x1fff, 4, 0),
+        BPF_STMT(BPF_LDX | BPF_B   | BPF_MSH, 14),                  // X = IPv4 header length
+        BPF_STMT(BPF_LD  | BPF_H   | BPF_IND, 16),                  // UDP destination port
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,   udp_port, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K,             0x40000),             // accept (whole frame)
+        BPF_STMT(BPF_RET | BPF_K,             0),                   // drop
+      };
+      sock_fprog prog{};
+      prog.len    = sizeof(filter) / sizeof(filter[0]);
+      prog.filter = filter;
+      if (setsockopt(m_sd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) < 0)
+        return false;
+
+      tpacket_req3 req{};
+      req.tp_block_size       = BLOCK_SIZE;
+      req.tp_block_nr         = BLOCK_NR;
+      req.tp_frame_size       = FRAME_SIZE;
+      req.tp_frame_nr         = (BLOCK_SIZE / FRAME_SIZE) * BLOCK_NR;
+      req.tp_retire_blk_tov   = BLOCK_TMO_MS;
+      req.tp_feature_req_word = 0;
+      if (setsockopt(m_sd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0)
+        return false;
+
+      m_ring = mmap(nullptr, static_cast<size_t>(BLOCK_SIZE) * BLOCK_NR, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_LOCKED | MAP_POPULATE, m_sd, 0);
+      if (m_ring == MAP_FAILED)
+        m_ring = mmap(nullptr, static_cast<size_t>(BLOCK_SIZE) * BLOCK_NR, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, m_sd, 0);     // MAP_LOCKED needs RLIMIT_MEMLOCK
+      if (m_ring == MAP_FAILED)
+        return false;
+
+      // Receive only from the given interface
+      sockaddr_ll sll{};
+      sll.sll_family   = AF_PACKET;
+      sll.sll_protocol = htons(ETH_P_IP);
+      sll.sll_ifindex  = m_ifindex;
+      return bind(m_sd, (sockaddr*)&sll, sizeof(sll)) == 0;
+    }
+
+    int      m_sd = -1;
+    int      m_ifindex = 0;
+    void    *m_ring = MAP_FAILED;
+    unsigned int m_block_idx = 0;
+    uint64_t m_drops = 0;
+};
@@ -3,248 +3,896 @@
 #include "rapidxml-1.13/rapidxml_print.hpp"
 #include "rapidxml-1.13/rapidxml_utils.hpp"
 
+// Names interned, APPID and IP address resolved once (ref: symbolTable.hpp)
+#include "symbolTable.hpp"
+
 /* An aggregate of variables representing
  * information parsed from SED file
  */
 struct ControlBlock
 {
-    std::string              hostIED{};
-    std::string              cbType{};
-    std::string              multicastIP{};
-    std::string              appID{};
-    std::string              vlanID{};
-    std::string              cbName{};
-    std::string              datSetName{};
-    std::vector<std::string> datSetVector{};
-    std::vector<std::string> subscribingIEDs{};
+    Symbol                   hostIED{};
+    CbType                   cbType{CbType::Unknown};
+    in_addr                  multicastIP{};
+    uint16_t                 appID{0};
+    Symbol                   vlanID{};
+    Symbol                   cbName{};
+    Symbol                   datSetName{};
+    unsigned int             minTime{0};            // GSE: <MinTime>/<MaxTime> in ms (0 if absent)
+    unsigned int             maxTime{0};
+    std::vector<Fcda>        datSetVector{};
+    std::vector<Symbol>      subscribingIEDs{};
+};
+
+// Names and attribute values are looked up as views into the parsed document (no copies)
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <stdexcept>
+
+// For scanning an SCL file without parsing all of it (ref: parse_sed() for one IED)
+#include "mappedFile.hpp"
+
+/* A SED file whose Control Blocks can't be read (not SCL, or a Control Block without ldInst)
+ * Thrown by the parse functions, so that a reload of a bad file leaves the running IED as it is
+ * (ref: SedReload); at start-up, the IED reports it and exits.
+ */
+struct SclError : std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+// For reading an SCL file as a stream of elements (ref: parse_sed_stream())
+#include "sclReader.hpp"
+
+using SclNode = rapidxml::xml_node<>;
+
+std::string_view scl_name(const SclNode *node)
+{
+    return std::string_view(node->name(), node->name_size());
+}
+
+// Value of an attribute (empty if the attribute is absent)
+std::string_view scl_attr(const SclNode *node, const char *name)
+{
+    rapidxml::xml_attribute<> *attr = node->first_attribute(name);
+    return attr ? std::string_view(attr->value(), attr->value_size()) : std::string_view{};
+}
+
+/* Index of the <IED> section of an SCL file: IED by name, LDevice by inst, and in the LN0 of each
+ * LDevice, Control Block (GSEControl/SampledValueControl) by Name and DataSet by name.
+ * Built in one pass over the section, so that resolving every Control Block takes linear time.
+ * Keys are views into the parsed document: the index must not outlive it.
+ */
+struct SclLDevice
+{
+    SclNode                                        *node{nullptr};
+    SclNode                                        *ln0{nullptr};
+    std::unordered_map<std::string_view, SclNode*> controls{};
+    std::unordered_map<std::string_view, SclNode*> dataSets{};
 };
 
-/* Function to parse SED file and get Control Blocks' information */
-std::vector<ControlBlock> parse_sed(const char *filename)
+struct SclIed
+{
+    SclNode                                           *node{nullptr};
+    std::unordered_map<std::string_view, SclLDevice>  lDevices{};
+};
+
+using SclIndex = std::unordered_map<std::string_view, SclIed>;
+
+/* Runs work(begin, end, part) over [0, count) split in contiguous parts, one per thread (at most
+ * threads, and at least min_per_part items each): the caller merges the parts in order, so that the
+ * result does not depend on the number of threads
+ */
+template <typename Work>
+void scl_parallel_for(size_t count, unsigned int threads, size_t min_per_part, Work &&work)
+{
+    size_t parts = std::min<size_t>(std::max(1u, threads), std::max<size_t>(1, count / std::max<size_t>(1, min_per_part)));
+    if (parts <= 1)
+    {
+        work(size_t{0}, count, size_t{0});
+        return;
+    }
+
+    std::vector<std::thread> workers{};
+    workers.reserve(parts - 1);
+    for (size_t part = 1; part < parts; part++)
+        workers.emplace_back([&work, count, parts, part]() { work(count * part / parts, count * (part + 1) / parts, part); });
+    work(size_t{0}, count / parts, size_t{0});          // First part on the calling thread
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+// Default number of threads of parse_sed()
+unsigned int scl_threads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Indexes the LDevices of an IED (ref: index_ieds())
+void index_ied(SclIed &ied)
+{
+    for (SclNode *nodeAP = ied.node->first_node("AccessPoint"); nodeAP; nodeAP = nodeAP->next_sibling("AccessPoint"))
+    {
+        for (SclNode *nodeLDev = nodeAP->first_node("LDevice"); nodeLDev; nodeLDev = nodeLDev->next_sibling("LDevice"))
+        {
+            SclLDevice &lDevice = ied.lDevices[scl_attr(nodeLDev, "inst")];
+            if (lDevice.node)
+                continue;
+            lDevice.node = nodeLDev;
+
+            // Assume only 1x LN0 node per LDevice node
+            lDevice.ln0 = nodeLDev->first_node("LN0");
+            if (!lDevice.ln0)
+                continue;
+
+            for (SclNode *node = lDevice.ln0->first_node(); node; node = node->next_sibling())
+            {
+                std::string_view name = scl_name(node);
+                if (name == "GSEControl" || name == "SampledValueControl")
+                    lDevice.controls.emplace(scl_attr(node, "Name"), node);
+                else if (name == "DataSet")
+                    lDevice.dataSets.emplace(scl_attr(node, "name"), node);
+            }
+        }
+    }
+}
+
+/* The IEDs are listed first (the first <IED> of a given name is the one used), then indexed each
+ * on its own, by up to threads threads: the document is only read.
+ */
+SclIndex index_ieds(SclNode *root_node, unsigned int threads = 1)
+{
+    SclIndex index{};
+    std::vector<SclIed*> ieds{};
+    for (SclNode *nodeIED = root_node->first_node("IED"); nodeIED; nodeIED = nodeIED->next_sibling("IED"))
+    {
+        SclIed &ied = index[scl_attr(nodeIED, "name")];
+        if (ied.node)
+            continue;
+        ied.node = nodeIED;
+        ieds.push_back(&ied);
+    }
+
+    scl_parallel_for(ieds.size(), threads, 64, [&ieds](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++)
+            index_ied(*ieds[i]);
+    });
+    return index;
+}
+
+/* Completes a Control Block found under <Communication> (hostIED, ldInst, not-yet-fully-qualified
+ * cbName) from its <IED> section: fully qualified cbName and datSetName, Information Model of the
+ * DataSet and subscribing IEDs. Returns false if the IED, LDevice or Control Block is not found.
+ * Only reads the index and the document: Control Blocks can be resolved concurrently (warnings go to log).
+ */
+bool resolve_control_block(const SclIndex &index, std::string_view ldInst, ControlBlock &ctrl_blk, std::ostream &log = std::cout)
+{
+    SclIndex::const_iterator ied = index.find(ctrl_blk.hostIED.view());
+    if (ied == index.end())
+        return false;
+    std::unordered_map<std::string_view, SclLDevice>::const_iterator lDevice = ied->second.lDevices.find(ldInst);
+    if (lDevice == ied->second.lDevices.end() || !lDevice->second.ln0)
+        return false;
+    std::unordered_map<std::string_view, SclNode*>::const_iterator control = lDevice->second.controls.find(ctrl_blk.cbName.view());
+    if (control == lDevice->second.controls.end())
+        return false;
+
+    std::string_view datSetName = scl_attr(control->second, "datSet");
+    std::string prefix = std::string(ldInst) + '/' + std::string(scl_attr(lDevice->second.ln0, "lnClass")) + '.';
+    ctrl_blk.cbName = Symbol(prefix + ctrl_blk.cbName.str());
+    ctrl_blk.datSetName = Symbol(prefix + std::string(datSetName));
+
+    /*
+     * Compile the Cyber component for the CPMapping from the DataSet named by the Control Block
+     * (datSetName, not yet fully qualified).
+     */
+    std::unordered_map<std::string_view, SclNode*>::const_iterator dataSet = lDevice->second.dataSets.find(datSetName);
+    if (dataSet != lDevice->second.dataSets.end())
+    {
+        for (SclNode *nodeFCDA = dataSet->second->first_node("FCDA"); nodeFCDA; nodeFCDA = nodeFCDA->next_sibling())
+        {
+            // Assume required attribute names are present and correctly formed (no error-checking implemented)
+            ctrl_blk.datSetVector.push_back(Fcda{ctrl_blk.hostIED, Symbol(scl_attr(nodeFCDA, "lnClass")),
+                                                 Symbol(scl_attr(nodeFCDA, "doName")), Symbol(scl_attr(nodeFCDA, "daName"))});
+        }
+    }
+    else
+    {
+        log << "\t[!] Couldn't find DataSet \"" << datSetName << "\" of Control Block " << ctrl_blk.cbName << " in its LN0 node.\n";
+    }
+
+    for (SclNode *nodeIEDName = control->second->first_node("IEDName"); nodeIEDName; nodeIEDName = nodeIEDName->next_sibling("IEDName"))
+        ctrl_blk.subscribingIEDs.emplace_back(std::string_view(nodeIEDName->value(), nodeIEDName->value_size()));
+    return true;
+}
+
+/* Control Block information (partial) from a <GSE>/<SMV> node of the ConnectedAP of iedName:
+ * type, addresses and not-yet-fully-qualified cbName
+ */
+ControlBlock communication_control_block(SclNode *cbNode, std::string_view iedName)
+{
+    if (!cbNode->first_attribute("ldInst"))
+    {
+        std::cout << "    [!] But 'ldInst' is not found in Control Block's node\n";
+        throw SclError("'ldInst' not found in Control Block " + std::string(scl_attr(cbNode, "cbName")) + " of "
+                       + std::string(iedName));
+    }
+
+    ControlBlock CB_tmp{};
+    CB_tmp.hostIED = Symbol(iedName);
+    CB_tmp.cbType = cb_type(scl_name(cbNode));
+
+    SclNode *nodeAddress = cbNode->first_node("Address");
+    for (SclNode *nodeP = nodeAddress ? nodeAddress->first_node("P") : nullptr; nodeP; nodeP = nodeP->next_sibling())
+    {
+        std::string_view p_type = scl_attr(nodeP, "type");
+
+        if (p_type == "IP")
+        {
+            CB_tmp.multicastIP = scl_ipv4(std::string_view(nodeP->value(), nodeP->value_size()));
+        }
+        else if (p_type == "APPID")
+        {
+            CB_tmp.appID = scl_appid(std::string_view(nodeP->value(), nodeP->value_size()));
+        }
+        else if (p_type == "VLAN-ID")
+        {
+            CB_tmp.vlanID = Symbol(std::string_view(nodeP->value(), nodeP->value_size()));
+        }
+    }
+
+    // GOOSE retransmission times (in ms, or in s without multiplier="m")
+    for (SclNode *nodeTime = cbNode->first_node(); nodeTime; nodeTime = nodeTime->next_sibling())
+    {
+        std::string_view name = scl_name(nodeTime);
+        if (name != "MinTime" && name != "MaxTime")
+            continue;
+        unsigned int ms = static_cast<unsigned int>(std::strtoul(nodeTime->value(), nullptr, 10));
+        if (scl_attr(nodeTime, "multiplier") != "m")
+            ms *= 1000;
+        (name == "MinTime" ? CB_tmp.minTime : CB_tmp.maxTime) = ms;
+    }
+
+    // Not-yet-fully-qualified cbName
+    CB_tmp.cbName = Symbol(scl_attr(cbNode, "cbName"));
+    return CB_tmp;
+}
+
+/* Function to parse SED file and get Control Blocks' information
+ * One pass over <Communication> collects the Control Blocks (with their ldInst), one pass over the
+ * IEDs indexes them (ref: index_ieds()), then each Control Block is resolved by hash lookups.
+ * Indexing and resolution are split across threads (default: one per core), each on a contiguous
+ * part of the IEDs or Control Blocks; the result and the output are the same for any number of threads.
+ */
+std::vector<ControlBlock> parse_sed(const char *filename, unsigned int threads = scl_threads())
 {
     std::vector<ControlBlock> vector_of_ctrl_blks{};
+    std::vector<std::string_view> ldInsts{};        // ldInst of each Control Block, same order
 
     rapidxml::file<> xmlFile(filename);
     rapidxml::xml_document<> doc;
     doc.parse<0>(xmlFile.data());
 
     // Find out the root node: prints "Root Node's name: SCL" for a SED file
-    rapidxml::xml_node<> *root_node = doc.first_node();
-    if (static_cast<std::string>(root_node->name()) == "SCL")
+    SclNode *root_node = doc.first_node();
+    if (root_node && scl_name(root_node) == "SCL")
     {
         std::cout << "[*] Successfully parsed XML data in " << filename << '\n'
                   << "Name of Root Node in SED file = " << root_node->name() << "\n\n";
     }
     else
     {
-        std::cout << "Name of Root Node is not \"SCL\"! Please check format of SED file: " << filename << '\n';
-        exit (EXIT_FAILURE);
+        throw SclError("Name of Root Node is not \"SCL\"! Please check format of SED file: " + std::string(filename));
     }
 
-    // Create a map with key = IED Name & value = vector of LD(s) that contain Control Block(s)
-    std::map<std::string, std::vector<std::string>> map_of_ld_with_cb;
-
-    for (rapidxml::xml_node<> *lvl_1_node = root_node->first_node("Communication"); lvl_1_node; lvl_1_node = lvl_1_node->next_sibling("Communication"))
+    for (SclNode *lvl_1_node = root_node->first_node("Communication"); lvl_1_node; lvl_1_node = lvl_1_node->next_sibling("Communication"))
     {
         std::cout << "[*] Searching for Control Block(s) in <" << lvl_1_node->name() << "> element...\n";
 
-        for (rapidxml::xml_node<> *lvl_2_node = lvl_1_node->first_node("SubNetwork"); lvl_2_node; lvl_2_node = lvl_2_node->next_sibling("SubNetwork"))
+        for (SclNode *lvl_2_node = lvl_1_node->first_node("SubNetwork"); lvl_2_node; lvl_2_node = lvl_2_node->next_sibling("SubNetwork"))
         {
-            for (rapidxml::xml_node<> *lvl_3_node = lvl_2_node->first_node("ConnectedAP"); lvl_3_node; lvl_3_node = lvl_3_node->next_sibling("ConnectedAP"))
+            for (SclNode *lvl_3_node = lvl_2_node->first_node("ConnectedAP"); lvl_3_node; lvl_3_node = lvl_3_node->next_sibling("ConnectedAP"))
             {
-                std::vector<std::string> vector_of_LDs_with_CBs{};
+                std::string_view iedName = scl_attr(lvl_3_node, "iedName");
+                size_t numFound{0};
 
-                for (rapidxml::xml_node<> *lvl_4_node = lvl_3_node->first_node(); lvl_4_node; lvl_4_node = lvl_4_node->next_sibling())
+                for (SclNode *lvl_4_node = lvl_3_node->first_node(); lvl_4_node; lvl_4_node = lvl_4_node->next_sibling())
                 {
-                    rapidxml::xml_attribute<>* attr_tmp = nullptr;
-                    ControlBlock CB_tmp{};
-
-                    if (   (static_cast<std::string>(lvl_4_node->name()) == "GSE")
-                        || (static_cast<std::string>(lvl_4_node->name()) == "SMV")   )
-                    {
-                        std::cout << "    "        << lvl_4_node->name() << " Control Block found in:\n"
-                                  << "    -> "     << lvl_2_node->name() << ": " << lvl_2_node->first_attribute("name")->value() << '\n'
-                                  << "        -> " << lvl_3_node->name() << ": " << lvl_3_node->first_attribute("iedName")->value() << '\n';
-
-                        attr_tmp = lvl_4_node->first_attribute("ldInst");
-                        if (attr_tmp)
-                        {
-                            vector_of_LDs_with_CBs.push_back(static_cast<std::string>(lvl_4_node->first_attribute("ldInst")->value()));
-                        }
-                        else
-                        {
-                            std::cout << "    [!] But 'ldInst' is not found in Control Block's node\n";
-                            exit (EXIT_FAILURE);
-                        }
-
-                        /* Prepare Control Block information (partial) */
-                        CB_tmp.hostIED = static_cast<std::string>(lvl_3_node->first_attribute("iedName")->value());
-                        CB_tmp.cbType = static_cast<std::string>(lvl_4_node->name());
-
-                        for (rapidxml::xml_node<> *nodeP = lvl_4_node->first_node("Address")->first_node("P");
-                                nodeP;
-                                    nodeP = nodeP->next_sibling())
-                        {
-                            std::string p_type = static_cast<std::string>(nodeP->first_attribute("type")->value());
-
-                            if (p_type == "IP")
-                            {
-                                CB_tmp.multicastIP = nodeP->value();
-                            }
-                            else if (p_type == "APPID")
-                            {
-                                CB_tmp.appID = nodeP->value();
-                            }
-                            else if (p_type == "VLAN-ID")
-                            {
-                                CB_tmp.vlanID = nodeP->value();
-                            }
-                        }
-
-                        // Not-yet-fully-qualified cbName
-                        CB_tmp.cbName = static_cast<std::string>(lvl_4_node->first_attribute("cbName")->value());
-
-                        vector_of_ctrl_blks.push_back(CB_tmp);
-                    }
+                    std::string_view cbType = scl_name(lvl_4_node);
+                    if (cbType != "GSE" && cbType != "SMV")
+                        continue;
 
-                }
+                    std::cout << "    "        << cbType << " Control Block found in:\n"
+                              << "    -> "     << lvl_2_node->name() << ": " << scl_attr(lvl_2_node, "name") << '\n'
+                              << "        -> " << lvl_3_node->name() << ": " << iedName << '\n';
 
-                if (!vector_of_LDs_with_CBs.empty())
-                {
-                    map_of_ld_with_cb[static_cast<std::string>(lvl_3_node->first_attribute("iedName")->value())] = vector_of_LDs_with_CBs;
-                    std::cout << "    Saved " << vector_of_LDs_with_CBs.size() << " LD(s) with CB(s) for IED " << lvl_3_node->first_attribute("iedName")->value() << " - to be checked later...\n\n";
+                    vector_of_ctrl_blks.push_back(communication_control_block(lvl_4_node, iedName));
+                    ldInsts.push_back(scl_attr(lvl_4_node, "ldInst"));
+                    numFound++;
                 }
 
+                if (numFound)
+                    std::cout << "    Saved " << numFound << " Control Block(s) for IED " << iedName << " - to be resolved later...\n\n";
             }
         }
     }
 
     std::cout << "[*] Found a total of " << vector_of_ctrl_blks.size() << " Control Block(s).\n\n";
 
-    // Look for prefix <LDName>/<LNName> for each cbName
-    for (auto item : map_of_ld_with_cb)
+    // Look for prefix <LDName>/<LNName>, DataSet and subscribers of each Control Block
+    SclIndex index = index_ieds(root_node, threads);
+    std::cout << "[*] Indexed " << index.size() << " IED(s) in the SED file\n";
+
+    // Each part resolves its Control Blocks in place; its warnings are printed after those of the previous parts
+    std::vector<std::ostringstream> logs(std::max(1u, threads));
+    std::vector<size_t> numResolvedOf(logs.size(), 0);
+    scl_parallel_for(vector_of_ctrl_blks.size(), threads, 64, [&](size_t begin, size_t end, size_t part) {
+        size_t resolved{0};
+        for (size_t i = begin; i < end; i++)
+        {
+            if (resolve_control_block(index, ldInsts[i], vector_of_ctrl_blks[i], logs[part]))
+                resolved++;
+            else
+                logs[part] << "\t[!] Control Block " << vector_of_ctrl_blks[i].cbName << " of IED " << vector_of_ctrl_blks[i].hostIED
+                           << " (LDevice " << ldInsts[i] << ") not found in the IED section.\n";
+        }
+        numResolvedOf[part] = resolved;
+    });
+    size_t numResolved{0};
+    for (size_t part = 0; part < logs.size(); part++)
+    {
+        std::cout << logs[part].str();
+        numResolved += numResolvedOf[part];
+    }
+    std::cout << "[*] Resolved " << numResolved << " of " << vector_of_ctrl_blks.size() << " Control Block(s)\n";
+
+    std::cout << "\n[*] Finished parsing SED file for Control Blocks.\n\n\n";
+    return vector_of_ctrl_blks;
+}
+
+/* Next <tag ...>...</tag> (or <tag .../>) element of an SCL text at or after pos, as a view of its text.
+ * pos is moved past it. Only for elements that do not nest (IED, ConnectedAP).
+ */
+bool scl_next_element(std::string_view text, size_t &pos, std::string_view tag, std::string_view &element)
+{
+    const std::string open = "<" + std::string(tag);
+    while ((pos = text.find(open, pos)) != std::string_view::npos)
     {
-        for (rapidxml::xml_node<> *lvl_1_node = root_node->first_node("IED");
-                lvl_1_node;
-                    lvl_1_node = lvl_1_node->next_sibling("IED"))
+        const size_t start = pos;
+        pos += open.size();
+        // <IED must not match <IEDName
+        if (pos < text.size() && (std::isspace(static_cast<unsigned char>(text[pos])) || text[pos] == '>' || text[pos] == '/'))
         {
-            if (static_cast<std::string>(lvl_1_node->first_attribute("name")->value()) == item.first)
+            const size_t start_tag_end = text.find('>', pos);
+            if (start_tag_end == std::string_view::npos)
+                return false;
+            size_t end = start_tag_end;
+            if (text[start_tag_end - 1] != '/')
             {
-                std::cout << "[*] Checking Control Block(s) in IED name = " << lvl_1_node->first_attribute("name")->value() << "...\n";
+                // </IED must not match </IEDName
+                const std::string close = "</" + std::string(tag);
+                for (end = text.find(close, start_tag_end); end != std::string_view::npos; end = text.find(close, end + 1))
+                {
+                    const size_t after = end + close.size();
+                    if (after < text.size() && (std::isspace(static_cast<unsigned char>(text[after])) || text[after] == '>'))
+                        break;
+                }
+                end = (end == std::string_view::npos) ? end : text.find('>', end);
+                if (end == std::string_view::npos)
+                    return false;
+            }
+            pos = end + 1;
+            element = text.substr(start, pos - start);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Value of an attribute in the start tag of an element's text (empty if absent)
+std::string_view scl_tag_attr(std::string_view element, std::string_view name)
+{
+    const std::string_view start_tag = element.substr(0, element.find('>'));
+    for (size_t pos = start_tag.find(name); pos != std::string_view::npos; pos = start_tag.find(name, pos + 1))
+    {
+        size_t eq = pos + name.size();
+        if (!std::isspace(static_cast<unsigned char>(start_tag[pos - 1])) || eq + 1 >= start_tag.size()
+            || start_tag[eq] != '=' || (start_tag[eq + 1] != '"' && start_tag[eq + 1] != '\''))
+            continue;
+        const size_t value_end = start_tag.find(start_tag[eq + 1], eq + 2);
+        if (value_end != std::string_view::npos)
+            return start_tag.substr(eq + 2, value_end - eq - 2);
+    }
+    return std::string_view{};
+}
+
+// One element of an SCL file parsed on its own (rapidxml parses in place: the copy must live as long as the nodes)
+struct SclFragment
+{
+    std::vector<char>         text{};
+    rapidxml::xml_document<>  doc{};
 
-                // Each IED has only one AccessPoint (no need to iterate with for-loop)
-                rapidxml::xml_node<> *nodeAP = lvl_1_node->first_node("AccessPoint");
+    explicit SclFragment(std::string_view element) : text(element.begin(), element.end()) {
+      text.push_back('\0');
+      doc.parse<0>(text.data());
+    }
+};
+
+/* Function to parse SED file for one IED's view: the Control Blocks it publishes, and those whose
+ * <IEDName> lists it (same Control Blocks, in the same order, as parse_sed() then filtered).
+ * The file is only scanned as text (memory-mapped): an <IED> is parsed only if its text contains
+ * the IED name, and a <ConnectedAP> only if it belongs to a publisher found that way. Startup time and
+ * memory then depend on the IED's own configuration rather than on the size of the substation.
+ */
+std::vector<ControlBlock> parse_sed(const char *filename, const char *ied_name)
+{
+    std::vector<ControlBlock> vector_of_ctrl_blks{};
+    const std::string_view own{ied_name};
 
-                for (rapidxml::xml_node<> *nodeLDev = nodeAP->first_node("LDevice");
-                        nodeLDev;
-                            nodeLDev = nodeLDev->next_sibling("LDevice"))
+    MappedFile file(filename);
+    const std::string_view text = file.isGood() ? file() : std::string_view{};
+    if (text.find("<SCL") == std::string_view::npos)
+    {
+        throw SclError("Name of Root Node is not \"SCL\"! Please check format of SED file: " + std::string(filename));
+    }
+    std::cout << "[*] Scanning " << filename << " for the Control Blocks of IED " << own << " and those it subscribes to\n";
+
+    // IED sections that may matter: its own, and any that mentions its name
+    std::vector<std::unique_ptr<SclFragment>> fragments{};
+    SclIndex index{};
+    std::unordered_set<std::string> wanted{};               // hostIED/ldInst/cbName of the relevant Control Blocks
+    std::unordered_set<std::string_view> publishers{};
+    size_t numIEDs{0};
+    std::string_view element{};
+    for (size_t pos = 0; scl_next_element(text, pos, "IED", element); )
+    {
+        numIEDs++;
+        if (element.find(own) == std::string_view::npos)
+            continue;
+
+        fragments.push_back(std::make_unique<SclFragment>(element));
+        SclIndex partial = index_ieds(&fragments.back()->doc);
+        for (const auto &[iedName, ied] : partial)
+        {
+            for (const auto &[ldInst, lDevice] : ied.lDevices)
+            {
+                for (const auto &[cbName, control] : lDevice.controls)
                 {
-                    // Check for match with ldInst from Control Block information under Communication node
-                    if (   (!item.second.empty())
-                        && (static_cast<std::string>(nodeLDev->first_attribute("inst")->value()) == item.second[item.second.size() - 1])   )
-                    {
-                        std::string cbName{};
-                        std::string datSetName{};
-                        std::vector<std::string> datSetVector{};
-
-                        // Assume only 1x LN0 node per LDevice node
-                        rapidxml::xml_node<> *nodeLN = nodeLDev->first_node("LN0");
-
-                        for (rapidxml::xml_node<> *nodeCB = nodeLN->first_node();
-                                nodeCB;
-                                    nodeCB = nodeCB->next_sibling())
-                        {
-                            // Check for presence of a Control Block
-                            if (   (static_cast<std::string>(nodeCB->name()) == "GSEControl")
-                                || (static_cast<std::string>(nodeCB->name()) == "SampledValueControl")   )
-                            {
-                                cbName = static_cast<std::string>(nodeCB->first_attribute("Name")->value());
-                                datSetName = static_cast<std::string>(nodeCB->first_attribute("datSet")->value());
-
-                                for (rapidxml::xml_node<> *nodeDataSet = nodeLN->first_node("DataSet");
-                                        nodeDataSet;
-                                            nodeDataSet = nodeDataSet->next_sibling("DataSet"))
-                                {
-                                    /*
-                                     * Check that the parsed DataSet has the same datSetName (not yet fully qualified)
-                                     * as the Control Block, then compile the Cyber component for the CPMapping.
-                                     */
-                                    if (static_cast<std::string>(nodeDataSet->first_attribute("name")->value()) == datSetName)
-                                    {
-                                        for (rapidxml::xml_node<> *nodeFCDA = nodeDataSet->first_node("FCDA");
-                                                nodeFCDA;
-                                                    nodeFCDA = nodeFCDA->next_sibling())
-                                        {
-                                            std::string currentCyber{};
-
-                                            // Assume required attribute names are present and correctly formed (no error-checking implemented)
-                                            currentCyber = static_cast<std::string>(lvl_1_node->first_attribute("name")->value())
-                                                            + '.'
-                                                            + static_cast<std::string>(nodeFCDA->first_attribute("lnClass")->value())
-                                                            + '.'
-                                                            + static_cast<std::string>(nodeFCDA->first_attribute("doName")->value())
-                                                            + '.'
-                                                            + static_cast<std::string>(nodeFCDA->first_attribute("daName")->value());
-
-                                            datSetVector.push_back(currentCyber);
-                                        }
-                                    }
-                                    if (datSetVector.empty())
-                                    {
-                                        std::cout << "\t[!] Couldn't find a matching datSet Name in LN Node as the Control Block's.\n";
-                                        exit (EXIT_FAILURE);
-                                    }
-                                }
-
-                                for (size_t i = 0; i < vector_of_ctrl_blks.size() ; i++)
-                                {
-                                    /* Check if Control Block in vector matches
-                                     * the current Control Block parsed from the IED section of SED file
-                                     */
-                                    if (   (vector_of_ctrl_blks[i].hostIED == item.first)
-                                        && (vector_of_ctrl_blks[i].cbName == cbName)   )
-                                    {
-                                        std::string prefix = static_cast<std::string>(nodeLDev->first_attribute("inst")->value())
-                                                            + '/'
-                                                            + static_cast<std::string>(nodeLN->first_attribute("lnClass")->value())
-                                                            + '.';
-                                        cbName = prefix + cbName;
-                                        datSetName = prefix + datSetName;
-
-                                        /* Prepare Control Block information (full) */
-                                        vector_of_ctrl_blks[i].cbName = cbName;
-                                        vector_of_ctrl_blks[i].datSetName = datSetName;
-                                        vector_of_ctrl_blks[i].datSetVector = datSetVector;
-
-                                        for (rapidxml::xml_node<> *nodeIEDName = nodeCB->first_node("IEDName");
-                                                nodeIEDName;
-                                                    nodeIEDName = nodeIEDName->next_sibling("IEDName"))
-                                        {
-                                            vector_of_ctrl_blks[i].subscribingIEDs.push_back(static_cast<std::string>(nodeIEDName->value()));
-                                        }
-
-                                        /*
-                                         * Since we found the current matching Control Block already,
-                                         * skip checking the rest of the saved Control Blocks in:
-                                         *  // for (size_t i = 0; i < vector_of_ctrl_blks.size() ; i++)
-                                         */
-                                        break;
-                                    }
-                                }
-                            }
-                        }
-                        item.second.pop_back();
-                        if (item.second.empty())
-                        {
-                            // Skip checking other LDevices if there're no more Control Blocks to find
-                            break;
-                        }
-                    }
+                    bool relevant = (iedName == own);
+                    for (SclNode *nodeIEDName = control->first_node("IEDName"); !relevant && nodeIEDName; nodeIEDName = nodeIEDName->next_sibling("IEDName"))
+                        relevant = (std::string_view(nodeIEDName->value(), nodeIEDName->value_size()) == own);
+                    if (!relevant)
+                        continue;
+                    wanted.insert(std::string(iedName) + '/' + std::string(ldInst) + '/' + std::string(cbName));
+                    publishers.insert(iedName);
                 }
             }
         }
+        index.merge(partial);
     }
 
-    std::cout << "\n[*] Finished parsing SED file for Control Blocks.\n\n\n";
+    // Addresses of the relevant Control Blocks (all of the IED's own, even if absent from its IED section)
+    size_t numAPs{0};
+    for (size_t pos = 0; scl_next_element(text, pos, "ConnectedAP", element); )
+    {
+        std::string_view iedName = scl_tag_attr(element, "iedName");
+        if (iedName != own && publishers.find(iedName) == publishers.end())
+            continue;
+
+        numAPs++;
+        SclFragment ap(element);
+        SclNode *nodeAP = ap.doc.first_node();
+        for (SclNode *cbNode = nodeAP ? nodeAP->first_node() : nullptr; cbNode; cbNode = cbNode->next_sibling())
+        {
+            std::string_view cbType = scl_name(cbNode);
+            if (cbType != "GSE" && cbType != "SMV")
+                continue;
+            std::string_view ldInst = scl_attr(cbNode, "ldInst");
+            std::string_view cbName = scl_attr(cbNode, "cbName");
+            if (iedName != own && wanted.find(std::string(iedName) + '/' + std::string(ldInst) + '/' + std::string(cbName)) == wanted.end())
+                continue;
+
+            ControlBlock CB_tmp = communication_control_block(cbNode, iedName);
+            if (!resolve_control_block(index, ldInst, CB_tmp))
+                std::cout << "\t[!] Control Block " << CB_tmp.cbName << " of IED " << CB_tmp.hostIED
+                          << " (LDevice " << ldInst << ") not found in the IED section.\n";
+            vector_of_ctrl_blks.push_back(std::move(CB_tmp));
+        }
+    }
+
+    std::cout << "[*] Parsed " << fragments.size() << " of " << numIEDs << " IED section(s) and " << numAPs
+              << " ConnectedAP(s): " << vector_of_ctrl_blks.size() << " Control Block(s) for IED " << own << "\n\n";
     return vector_of_ctrl_blks;
 }
+
+/* Control Block as read from the LN0 of its <IED> section by parse_sed_stream(): what
+ * resolve_control_block() takes from the document, copied out of the stream
+ */
+struct SclStreamControl
+{
+    std::string              lnClass{};             // of the LN0
+    std::string              datSet{};
+    bool                     datSetFound{false};
+    std::vector<Fcda>        datSetVector{};
+    std::vector<std::string> subscribingIEDs{};
+};
+
+/* Element handler of parse_sed_stream() (ref: SclReader)
+ * Follows the same paths as parse_sed(): SCL/Communication/SubNetwork/ConnectedAP/{GSE,SMV} and
+ * SCL/IED/AccessPoint/LDevice/LN0/{GSEControl,SampledValueControl,DataSet}, with the same rules
+ * (the first IED, LDevice, LN0, Control Block and DataSet of a given name is the one used).
+ * Only one LN0 is held at a time: its Control Blocks are resolved when it ends, and once the
+ * <Communication> section has been read, only those it lists are kept.
+ */
+class SclStreamHandler {
+  public:
+    std::vector<ControlBlock>                         vector_of_ctrl_blks{};
+    std::vector<std::string>                          ldInsts{};            // ldInst of each Control Block, same order
+    std::unordered_map<std::string, SclStreamControl> controls{};           // by hostIED/ldInst/cbName
+    size_t                                            numIEDs{0};
+
+    void startElement(std::string_view name, const SclReader::Attributes &attrs) {
+      const size_t depth = m_depth;
+      push(name);
+      if (m_skip)
+        return;
+
+      if (depth == 0)
+      {
+        if (name != "SCL")
+        {
+          throw SclError("Name of Root Node is not \"SCL\"! Please check format of SED file");
+        }
+      }
+      else if (depth == 1 && name == "Communication")
+      {
+        std::cout << "[*] Searching for Control Block(s) in <" << name << "> element...\n";
+      }
+      else if (depth == 2 && name == "SubNetwork" && parent(1) == "Communication")
+      {
+        m_subNetwork = attrs["name"];
+      }
+      else if (depth == 3 && name == "ConnectedAP" && parent(1) == "SubNetwork" && parent(2) == "Communication")
+      {
+        m_iedName = attrs["iedName"];
+        m_numFound = 0;
+      }
+      else if (depth == 4 && (name == "GSE" || name == "SMV") && parent(1) == "ConnectedAP" && parent(2) == "SubNetwork"
+               && parent(3) == "Communication")
+      {
+        std::cout << "    "        << name << " Control Block found in:\n"
+                  << "    -> "     << "SubNetwork: " << m_subNetwork << '\n'
+                  << "        -> " << "ConnectedAP: " << m_iedName << '\n';
+        if (!has(attrs, "ldInst"))
+        {
+          std::cout << "    [!] But 'ldInst' is not found in Control Block's node\n";
+          throw SclError("'ldInst' not found in Control Block " + std::string(attrs["cbName"]) + " of " + std::string(m_iedName));
+        }
+        m_cb = ControlBlock{};
+        m_cb.hostIED = Symbol(m_iedName);
+        m_cb.cbType = cb_type(name);
+        m_cb.cbName = Symbol(attrs["cbName"]);
+        m_multicastIP.clear();
+        m_appID.clear();
+        m_vlanID.clear();
+        m_ldInst = attrs["ldInst"];
+        m_inCb = true;
+        m_addressSeen = false;
+      }
+      else if (m_inCb && depth == 5 && name == "Address" && !m_addressSeen)
+      {
+        m_addressSeen = m_inAddress = true;
+        m_pSeen = false;
+      }
+      else if (m_inAddress && depth == 6 && (name == "P" || m_pSeen))
+      {
+        // From the first <P>, every element of the Address (as parse_sed())
+        m_pSeen = true;
+        const std::string_view type = attrs["type"];
+        if (type == "IP")
+          capture(m_multicastIP);
+        else if (type == "APPID")
+          capture(m_appID);
+        else if (type == "VLAN-ID")
+          capture(m_vlanID);
+      }
+      else if (m_inCb && depth == 5 && (name == "MinTime" || name == "MaxTime"))
+      {
+        m_timeIsMin = (name == "MinTime");
+        m_timeInMs = (attrs["multiplier"] == "m");
+        capture(m_time);
+      }
+      else if (depth == 1 && name == "IED")
+      {
+        // The first <IED> of a given name is the one used
+        m_iedName = attrs["name"];
+        m_iedSymbol = Symbol(m_iedName);
+        if (!m_ieds.insert(m_iedName).second)
+          skip();
+        else
+          numIEDs++;
+        m_lDevices.clear();
+      }
+      else if (depth == 3 && name == "LDevice" && parent(1) == "AccessPoint" && parent(2) == "IED")
+      {
+        // The first <LDevice> of a given inst in the IED is the one used
+        m_ldInst = attrs["inst"];
+        if (!m_lDevices.insert(m_ldInst).second)
+          skip();
+        m_ln0Seen = false;
+      }
+      else if (depth == 4 && name == "LN0" && parent(1) == "LDevice" && parent(3) == "IED")
+      {
+        // Assume only 1x LN0 node per LDevice node
+        if (m_ln0Seen)
+        {
+          skip();
+          return;
+        }
+        m_ln0Seen = m_inLN0 = true;
+        m_lnClass = attrs["lnClass"];
+      }
+      else if (m_inLN0 && depth == 5 && (name == "GSEControl" || name == "SampledValueControl"))
+      {
+        // The first Control Block of a given Name in the LN0 is the one used
+        auto [control, added] = m_ln0Controls.try_emplace(std::string(attrs["Name"]));
+        if (!added)
+        {
+          skip();
+          return;
+        }
+        control->second.lnClass = m_lnClass;
+        control->second.datSet = attrs["datSet"];
+        m_control = &control->second;
+      }
+      else if (m_control && depth == 6 && name == "IEDName")
+      {
+        capture(m_control->subscribingIEDs.emplace_back());
+      }
+      else if (m_inLN0 && depth == 5 && name == "DataSet")
+      {
+        // The first DataSet of a given name in the LN0 is the one used
+        auto [dataSet, added] = m_ln0DataSets.try_emplace(std::string(attrs["name"]));
+        if (!added)
+        {
+          skip();
+          return;
+        }
+        m_dataSet = &dataSet->second;
+        m_fcdaSeen = false;
+      }
+      else if (m_dataSet && depth == 6 && (name == "FCDA" || m_fcdaSeen))
+      {
+        // From the first <FCDA>, every element of the DataSet (as parse_sed())
+        m_fcdaSeen = true;
+        m_dataSet->push_back(Fcda{m_iedSymbol, Symbol(attrs["lnClass"]), Symbol(attrs["doName"]), Symbol(attrs["daName"])});
+      }
+    }
+
+    void endElement(std::string_view name) {
+      if (m_depth == 0)
+        return;             // Unbalanced end tag
+      const size_t depth = m_depth - 1;
+      if (m_skip)
+      {
+        if (m_depth-- == m_skip)
+          m_skip = 0;
+        return;
+      }
+      if (m_depth == m_captureDepth)
+        m_target = nullptr;
+      end(name, depth);
+      m_depth--;
+    }
+
+    // The first run of text of an element that is not only whitespace is its value (as the value() of a rapidxml node)
+    void text(std::string_view text) {
+      if (!m_target || m_skip || m_depth != m_captureDepth
+          || text.find_first_not_of(" \t\n\r") == std::string_view::npos)
+        return;
+      m_target->assign(text);
+      m_target = nullptr;
+    }
+
+  private:
+    void end(std::string_view name, size_t depth) {
+
+      if (depth == 1 && name == "Communication")
+      {
+        m_communicationRead = true;
+      }
+      else if (depth == 3 && name == "ConnectedAP" && parent(1) == "SubNetwork" && parent(2) == "Communication")
+      {
+        if (m_numFound)
+          std::cout << "    Saved " << m_numFound << " Control Block(s) for IED " << m_iedName << " - to be resolved later...\n\n";
+      }
+      else if (m_inCb && depth == 4)
+      {
+        m_cb.multicastIP = scl_ipv4(m_multicastIP);
+        m_cb.appID = scl_appid(m_appID);
+        m_cb.vlanID = Symbol(m_vlanID);
+        m_wanted.insert(m_cb.hostIED.str() + '/' + m_ldInst + '/' + m_cb.cbName.str());
+        vector_of_ctrl_blks.push_back(std::move(m_cb));
+        ldInsts.push_back(m_ldInst);
+        m_numFound++;
+        m_inCb = m_inAddress = false;
+      }
+      else if (m_inAddress && depth == 5)
+      {
+        m_inAddress = false;
+      }
+      else if (m_inCb && depth == 5 && (name == "MinTime" || name == "MaxTime"))
+      {
+        unsigned int ms = static_cast<unsigned int>(std::strtoul(m_time.c_str(), nullptr, 10));
+        if (!m_timeInMs)
+          ms *= 1000;
+        (m_timeIsMin ? m_cb.minTime : m_cb.maxTime) = ms;
+      }
+      else if (m_inLN0 && depth == 4)
+      {
+        endLN0();
+      }
+      else if (m_control && depth == 5)
+      {
+        m_control = nullptr;
+      }
+      else if (m_dataSet && depth == 5)
+      {
+        m_dataSet = nullptr;
+      }
+    }
+
+    void push(std::string_view name) {
+      if (m_path.size() == m_depth)
+        m_path.emplace_back();
+      m_path[m_depth++].assign(name);
+    }
+
+    // Name of the n-th ancestor of the current element
+    std::string_view parent(size_t n) const {
+      return (n < m_depth) ? std::string_view(m_path[m_depth - 1 - n]) : std::string_view{};
+    }
+
+    static bool has(const SclReader::Attributes &attrs, std::string_view name) {
+      for (const std::pair<std::string_view, std::string_view> &item : attrs.items)
+      {
+        if (item.first == name)
+          return true;
+      }
+      return false;
+    }
+
+    // Ignores the current element and its children
+    void skip() {
+      m_skip = m_depth;
+    }
+
+    void capture(std::string &target) {
+      target.clear();
+      m_target = &target;
+      m_captureDepth = m_depth;
+    }
+
+    // Resolves the Control Blocks of the LN0 (kept only if listed under <Communication>, once read)
+    void endLN0() {
+      for (auto &[cbName, control] : m_ln0Controls)
+      {
+        std::string key = m_iedName + '/' + m_ldInst + '/' + cbName;
+        if (m_communicationRead && m_wanted.find(key) == m_wanted.end())
+          continue;
+        std::unordered_map<std::string, std::vector<Fcda>>::iterator dataSet = m_ln0DataSets.find(control.datSet);
+        if (dataSet != m_ln0DataSets.end())
+        {
+          control.datSetFound = true;
+          control.datSetVector = dataSet->second;
+        }
+        controls.emplace(std::move(key), std::move(control));
+      }
+      m_ln0Controls.clear();
+      m_ln0DataSets.clear();
+      m_inLN0 = false;
+    }
+
+    std::vector<std::string>     m_path{};          // names of the open elements (capacity reused)
+    size_t                       m_depth{0};
+    size_t                       m_skip{0};         // depth of an element being ignored (0: none)
+    std::string                 *m_target{nullptr}; // value being read
+    size_t                       m_captureDepth{0};
+
+    // <Communication>
+    bool                         m_communicationRead{false};
+    std::unordered_set<std::string> m_wanted{};     // hostIED/ldInst/cbName of the Control Blocks listed
+    std::string                  m_subNetwork{};
+    std::string                  m_iedName{};       // of the ConnectedAP, then of the IED
+    size_t                       m_numFound{0};
+    ControlBlock                 m_cb{};
+    std::string                  m_multicastIP{};   // <P> values of m_cb, resolved at its end
+    std::string                  m_appID{};
+    std::string                  m_vlanID{};
+    bool                         m_inCb{false};
+    bool                         m_addressSeen{false};
+    bool                         m_inAddress{false};
+    bool                         m_pSeen{false};
+    std::string                  m_time{};
+    bool                         m_timeIsMin{false};
+    bool                         m_timeInMs{false};
+
+    // <IED>
+    std::unordered_set<std::string> m_ieds{};
+    std::unordered_set<std::string> m_lDevices{};   // of the current IED
+    Symbol                       m_iedSymbol{};     // of the IED (FCDAs)
+    std::string                  m_ldInst{};        // of the GSE/SMV, then of the LDevice
+    bool                         m_ln0Seen{false};
+    bool                         m_inLN0{false};
+    std::string                  m_lnClass{};
+    std::unordered_map<std::string, SclStreamControl>         m_ln0Controls{};
+    std::unordered_map<std::string, std::vector<Fcda>>        m_ln0DataSets{};
+    SclStreamControl            *m_control{nullptr};
+    std::vector<Fcda>           *m_dataSet{nullptr};
+    bool                         m_fcdaSeen{false};
+};
+
+/* Function to parse SED file as a stream of elements (ref: SclReader): same Control Blocks, in the
+ * same order, as parse_sed(filename), without a document tree. Memory stays bounded by the read
+ * buffer (or the mapped window, with use_mmap) and the Control Blocks found, whatever the size of
+ * the file: for SCD files of a large substation, that parse_sed() would hold whole in memory.
+ * <Communication> is expected before the IEDs, as in the SCL schema: otherwise every Control Block
+ * of the IEDs is kept until the end.
+ */
+std::vector<ControlBlock> parse_sed_stream(const char *filename, bool use_mmap = true)
+{
+    SclReader reader(filename, use_mmap);
+    if (!reader.isGood())
+    {
+        throw SclError("Couldn't read SED file: " + std::string(filename));
+    }
+    std::cout << "[*] Streaming " << filename << (use_mmap ? " (memory-mapped)" : "") << " for Control Blocks\n\n";
+
+    SclStreamHandler handler{};
+    if (!reader.parse(handler))
+    {
+        throw SclError("Malformed SED file " + std::string(filename) + ": " + reader.error());
+    }
+
+    std::vector<ControlBlock> &vector_of_ctrl_blks = handler.vector_of_ctrl_blks;
+    std::cout << "[*] Found a total of " << vector_of_ctrl_blks.size() << " Control Block(s).\n\n"
+              << "[*] Read " << handler.numIEDs << " IED(s) in the SED file\n";
+
+    // Look for prefix <LDName>/<LNName>, DataSet and subscribers of each Control Block
+    size_t numResolved{0};
+    for (size_t i = 0; i < vector_of_ctrl_blks.size(); i++)
+    {
+        ControlBlock &ctrl_blk = vector_of_ctrl_blks[i];
+        std::unordered_map<std::string, SclStreamControl>::iterator control
+            = handler.controls.find(ctrl_blk.hostIED.str() + '/' + handler.ldInsts[i] + '/' + ctrl_blk.cbName.str());
+        if (control == handler.controls.end())
+        {
+            std::cout << "\t[!] Control Block " << ctrl_blk.cbName << " of IED " << ctrl_blk.hostIED
+                      << " (LDevice " << handler.ldInsts[i] << ") not found in the IED section.\n";
+            continue;
+        }
+
+        std::string prefix = handler.ldInsts[i] + '/' + control->second.lnClass + '.';
+        ctrl_blk.cbName = Symbol(prefix + ctrl_blk.cbName.str());
+        ctrl_blk.datSetName = Symbol(prefix + control->second.datSet);
+        if (control->second.datSetFound)
+            ctrl_blk.datSetVector = control->second.datSetVector;
+        else
+            std::cout << "\t[!] Couldn't find DataSet \"" << control->second.datSet << "\" of Control Block " << ctrl_blk.cbName << " in its LN0 node.\n";
+        for (const std::string &subscriber : control->second.subscribingIEDs)
+            ctrl_blk.subscribingIEDs.emplace_back(subscriber);
+        numResolved++;
+    }
+    std::cout << "[*] Resolved " << numResolved << " of " << vector_of_ctrl_blks.size() << " Control Block(s)\n";
+
+    std::cout << "\n[*] Finished parsing SED file for Control Blocks.\n\n\n";
+    return std::move(vector_of_ctrl_blks);
+}
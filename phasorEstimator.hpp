@@ -0,0 +1,185 @@
+/* Streaming phasor (sliding-window DFT) and true-RMS estimation of sampled channels
+ *
+ * Every channel keeps the last N samples (one cycle, N = samples per cycle). For each selected
+ * harmonic h, the DFT over that window is updated recursively as each sample x replaces the one
+ * of the previous cycle at the same position n of the window:
+ *     X_h += (x - x_old) * e^(-j 2 pi h n / N)
+ * and the sum of squares the same way for the RMS. An update costs O(harmonics) per channel
+ * instead of O(N) for a full DFT. Samples are placed in the window by smpCnt, so the phasor
+ * angles are referred to the start of the cycle (smpCnt multiple of N) and do not rotate.
+ * The running sums are recomputed from the window every REFRESH_CYCLES cycles, so that
+ * float rounding does not build up.
+ *
+ * Channels are laid out side by side (all channels of all streams) and updated 4 at a time,
+ * one SIMD lane each (SSE where available, a plain loop otherwise).
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
+class PhasorEstimator {
+  public:
+    static constexpr unsigned int REFRESH_CYCLES = 50;
+
+    struct Phasor
+    {
+      float magnitude{};        // RMS value of the harmonic
+      float angle{};            // degrees, referred to the start of the cycle
+    };
+
+    /* channels: number of values in each sample (all streams side by side)
+     * samples_per_cycle: DFT window length N (a divisor of smpCnt_wrap)
+     * harmonics: orders to estimate (1 = fundamental), each < N / 2
+     * samples_per_report: a report is due each time smpCnt enters a new block of this many samples
+     */
+    PhasorEstimator(size_t channels, unsigned int samples_per_cycle, const std::vector<unsigned int> &harmonics,
+                    unsigned int samples_per_report, unsigned int smpCnt_wrap = 4000)
+      : m_channels{channels}, m_stride{(channels + 3) / 4 * 4}, m_n{samples_per_cycle},
+        m_harmonics{harmonics}, m_per_report{samples_per_report}, m_wrap{smpCnt_wrap},
+        m_window(static_cast<size_t>(samples_per_cycle) * m_stride),
+        m_re(harmonics.size() * m_stride), m_im(harmonics.size() * m_stride), m_sumsq(m_stride), m_input(m_stride),
+        m_cos(harmonics.size() * samples_per_cycle), m_sin(harmonics.size() * samples_per_cycle) {
+      for (size_t h = 0; h < m_harmonics.size(); h++)
+      {
+        for (unsigned int n = 0; n < m_n; n++)
+        {
+          // Exact angle: reduce h * n modulo N before scaling
+          const double angle = 2 * M_PI * ((static_cast<uint64_t>(m_harmonics[h]) * n) % m_n) / m_n;
+          m_cos[h * m_n + n] = static_cast<float>(std::cos(angle));
+          m_sin[h * m_n + n] = static_cast<float>(-std::sin(angle));
+        }
+      }
+    }
+    // Don't need the other default operations
+    PhasorEstimator(const PhasorEstimator&) = delete;
+    PhasorEstimator& operator=(const PhasorEstimator&) = delete;
+
+    bool isGood() const {
+      if (m_channels == 0 || m_n < 2 || m_wrap % m_n != 0 || m_per_report == 0 || m_per_report > m_wrap
+          || m_harmonics.empty())
+        return false;
+      return std::all_of(m_harmonics.begin(), m_harmonics.end(),
+                         [this](unsigned int h) { return h >= 1 && 2 * h < m_n; });
+    }
+
+    /* Adds the sample of every channel for smpCnt (values: channels floats).
+     * Returns true when a report is due: one full cycle has been seen and smpCnt entered
+     * a new reporting block since the last report.
+     */
+    bool push(unsigned int smpCnt, const float *values) {
+      smpCnt %= m_wrap;
+      const unsigned int pos = smpCnt % m_n;
+      float *window = &m_window[static_cast<size_t>(pos) * m_stride];
+      std::memcpy(m_input.data(), values, m_channels * sizeof(float));
+
+#ifdef __SSE2__
+      for (size_t c = 0; c < m_stride; c += 4)
+      {
+        const __m128 x = _mm_loadu_ps(&m_input[c]);
+        const __m128 old = _mm_loadu_ps(&window[c]);
+        const __m128 d = _mm_sub_ps(x, old);
+        _mm_storeu_ps(&window[c], x);
+        _mm_storeu_ps(&m_sumsq[c], _mm_add_ps(_mm_loadu_ps(&m_sumsq[c]),
+                                              _mm_sub_ps(_mm_mul_ps(x, x), _mm_mul_ps(old, old))));
+        for (size_t h = 0; h < m_harmonics.size(); h++)
+        {
+          float *re = &m_re[h * m_stride + c];
+          float *im = &m_im[h * m_stride + c];
+          _mm_storeu_ps(re, _mm_add_ps(_mm_loadu_ps(re), _mm_mul_ps(d, _mm_set1_ps(m_cos[h * m_n + pos]))));
+          _mm_storeu_ps(im, _mm_add_ps(_mm_loadu_ps(im), _mm_mul_ps(d, _mm_set1_ps(m_sin[h * m_n + pos]))));
+        }
+      }
+#else
+      for (size_t c = 0; c < m_stride; c++)
+      {
+        const float x = m_input[c], old = window[c], d = x - old;
+        window[c] = x;
+        m_sumsq[c] += x * x - old * old;
+        for (size_t h = 0; h < m_harmonics.size(); h++)
+        {
+          m_re[h * m_stride + c] += d * m_cos[h * m_n + pos];
+          m_im[h * m_stride + c] += d * m_sin[h * m_n + pos];
+        }
+      }
+#endif
+
+      m_samples++;
+      if (m_samples % (static_cast<uint64_t>(m_n) * REFRESH_CYCLES) == 0)
+        refresh();
+
+      const unsigned int block = smpCnt / m_per_report;
+      if (m_samples < m_n || (m_reported && block == m_last_block))
+        return false;
+      m_reported = true;
+      m_last_block = block;
+      m_reports++;
+      return true;
+    }
+
+    // Harmonic m_harmonics[h] of a channel, over the last cycle
+    Phasor phasor(size_t channel, size_t h) const {
+      const float re = m_re[h * m_stride + channel], im = m_im[h * m_stride + channel];
+      const float scale = static_cast<float>(M_SQRT2) / m_n;
+      constexpr float RAD_TO_DEG = 180.0f / 3.14159265358979f;
+      return Phasor{scale * std::sqrt(re * re + im * im), std::atan2(im, re) * RAD_TO_DEG};
+    }
+
+    // True RMS of a channel, over the last cycle
+    float rms(size_t channel) const {
+      return std::sqrt(std::max(m_sumsq[channel], 0.0f) / m_n);
+    }
+
+    size_t channels() const                              { return m_channels; }
+    unsigned int samplesPerCycle() const                 { return m_n; }
+    unsigned int samplesPerReport() const                { return m_per_report; }
+    const std::vector<unsigned int>& harmonics() const   { return m_harmonics; }
+    uint64_t samples() const                             { return m_samples; }
+    uint64_t reports() const                             { return m_reports; }
+
+  private:
+    // Recomputes the running sums from the window (plain DFT of the last cycle)
+    void refresh() {
+      std::fill(m_sumsq.begin(), m_sumsq.end(), 0.0f);
+      std::fill(m_re.begin(), m_re.end(), 0.0f);
+      std::fill(m_im.begin(), m_im.end(), 0.0f);
+      for (unsigned int n = 0; n < m_n; n++)
+      {
+        const float *window = &m_window[static_cast<size_t>(n) * m_stride];
+        for (size_t c = 0; c < m_stride; c++)
+        {
+          m_sumsq[c] += window[c] * window[c];
+          for (size_t h = 0; h < m_harmonics.size(); h++)
+          {
+            m_re[h * m_stride + c] += window[c] * m_cos[h * m_n + n];
+            m_im[h * m_stride + c] += window[c] * m_sin[h * m_n + n];
+          }
+        }
+      }
+    }
+
+    size_t                     m_channels;
+    size_t                     m_stride;            // channels rounded up to a multiple of 4 (SIMD width)
+    unsigned int               m_n;
+    std::vector<unsigned int>  m_harmonics;
+    unsigned int               m_per_report;
+    unsigned int               m_wrap;
+
+    std::vector<float>         m_window{};          // [position in cycle][channel]
+    std::vector<float>         m_re{};              // [harmonic][channel]
+    std::vector<float>         m_im{};              // [harmonic][channel]
+    std::vector<float>         m_sumsq{};           // [channel]
+    std::vector<float>         m_input{};           // one sample, padded to the stride
+    std::vector<float>         m_cos{};             // [harmonic][position in cycle]
+    std::vector<float>         m_sin{};             // [harmonic][position in cycle], negated
+
+    uint64_t                   m_samples{0};
+    uint64_t                   m_reports{0};
+    bool                       m_reported{false};
+    unsigned int               m_last_block{0};
+};
@@ -0,0 +1,39 @@
+#include <cstdint>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#ifndef IEDUDPPORT
+#define IEDUDPPORT 102
+#endif
+
+/* Publishing of one message of a Control Block: by ied_send for the IED's own Control Blocks, and by
+ * ied_recv for the 87L trip R-GOOSE. The message is formed with the next SPDU Number and sequence (ref:
+ * form_udp_data()), sent on socket sd to the multicast group of the Control Block, and counted in the
+ * metrics of the sending thread: time to form and to send it, messages and bytes sent.
+ * allData: GOOSE dataset values to send (nullptr: read from GOOSEdata.txt)
+ */
+void publish_message(int sd, GooseSvData &cb, ThreadMetrics &metrics, const std::string &action,
+                     const std::vector<unsigned char> *allData = nullptr)
+{
+    const uint64_t start_ns = monotonic_ns();
+    std::vector<unsigned char> udp_data{};
+    form_udp_data(cb, udp_data, allData);
+    const uint64_t encoded_ns = monotonic_ns();
+
+    // Set multicast protocol network parameters
+    sockaddr_in groupSock = {};   // init to all zeroes
+    groupSock.sin_family = AF_INET;
+    groupSock.sin_port = htons(IEDUDPPORT);
+    groupSock.sin_addr = cb.multicastIP;
+
+    diagnose(sendto(sd, &udp_data[0], udp_data.size(), 0,
+                    (sockaddr*)&groupSock, sizeof(groupSock)) >= 0, action);
+    IED_TRACE3(send, cb.appID, cb.prev_spduNum - 1, udp_data.size());
+    metrics.add(Counter::EncodeNs, encoded_ns - start_ns);
+    metrics.add(Counter::SendNs, monotonic_ns() - encoded_ns);
+    metrics.add(Counter::PacketsSent);
+    metrics.add(Counter::BytesSent, udp_data.size());
+}
@@ -0,0 +1,24 @@
+#!/bin/bash
+# Runs ied_recv with the AF_XDP transport across a veth pair:
+#   veth_pub (this namespace, ied_send)  <-->  veth_sub (namespace ied_sub, ied_recv)
+# veth has no zero-copy support, so the XDP program normally runs in native copy or generic (skb) mode.
+# Usage: ./run_xdp_veth.sh [seconds to run, default 10]
+
+DURATION=${1:-10}
+
+sudo ip netns add ied_sub
+sudo ip link add veth_pub type veth peer name veth_sub
+sudo ip link set veth_sub netns ied_sub
+sudo ip addr add 10.61.85.1/24 dev veth_pub
+sudo ip link set veth_pub up
+sudo ip netns exec ied_sub ip addr add 10.61.85.2/24 dev veth_sub
+sudo ip netns exec ied_sub ip link set veth_sub up
+sudo ip netns exec ied_sub ip link set lo up
+
+sudo ip netns exec ied_sub timeout $((DURATION + 2)) ./build/ied_recv sample.sed veth_sub S2_IED0 xdp &
+sleep 1
+sudo timeout $DURATION ./build/ied_send sample.sed veth_pub S1_IED22 > /dev/null
+wait
+
+sudo ip link del veth_pub
+sudo ip netns del ied_sub
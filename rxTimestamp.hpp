@@ -0,0 +1,48 @@
+/* Receive timestamps taken by the kernel (SO_TIMESTAMPNS)
+ *
+ * The kernel stamps each datagram when it is received by the network stack, in CLOCK_REALTIME,
+ * and passes the stamp as ancillary data (SCM_TIMESTAMPNS) with recvmsg()/recvmmsg()/io_uring.
+ * This excludes the time the datagram waits in the socket queue for the receiver to run, so the
+ * stamp can be compared with the UtcTime set by the publisher (same time base) for one-way latency.
+ */
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#include <sys/socket.h>
+
+// Room for the ancillary data of one datagram (the timestamp)
+#define RX_TIMESTAMP_CONTROL_LEN CMSG_SPACE(sizeof(timespec))
+
+// Nanoseconds since the epoch on CLOCK_REALTIME
+uint64_t realtime_ns()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+// Asks the kernel for a software receive timestamp with every datagram of the socket
+bool enable_rx_timestamps(int sd)
+{
+    int on = 1;
+    return setsockopt(sd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) == 0;
+}
+
+/* Receive timestamp (ns since the epoch) found in the ancillary data of a received message,
+ * or the current time if the kernel did not provide one (e.g. truncated control buffer)
+ */
+uint64_t rx_timestamp_ns(const msghdr &msg)
+{
+    for (const cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&msg), const_cast<cmsghdr*>(cmsg)))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS
+            && cmsg->cmsg_len >= CMSG_LEN(sizeof(timespec)))
+        {
+            timespec ts{};
+            std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+        }
+    }
+    return realtime_ns();
+}
@@ -0,0 +1,367 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+/* Streaming (SAX-style) reader of an SCL file
+ *
+ * The file is read chunk by chunk, either with read() into a buffer of CHUNK_SIZE bytes, or through
+ * a memory mapping (ref: mappedFile.hpp) whose pages are dropped once read. No document tree is built:
+ * every element is handed to the handler as it is read,
+ *     handler.startElement(std::string_view name, const SclReader::Attributes &attributes)
+ *     handler.text(std::string_view text)        a run of character data between two tags (entities
+ *                                                decoded, whitespace included), whole
+ *     handler.endElement(std::string_view name)  also called for <.../>
+ * and the views are valid during the call only. Memory is bounded by the chunk size (or the largest
+ * single token) plus whatever the handler keeps.
+ * Comments, CDATA sections, processing instructions and <!DOCTYPE> are skipped, as rapidxml does for
+ * the value of an element. End tags are not matched against start tags.
+ */
+class SclReader {
+  public:
+    static constexpr size_t CHUNK_SIZE = 1 << 20;
+
+    // Attributes of a start tag, values with entities decoded
+    struct Attributes
+    {
+      std::vector<std::pair<std::string_view, std::string_view>> items{};
+      std::vector<std::string>                                   decoded{};
+
+      // Value of an attribute (empty if absent)
+      std::string_view operator[](std::string_view name) const {
+        for (const std::pair<std::string_view, std::string_view> &item : items)
+        {
+          if (item.first == name)
+            return item.second;
+        }
+        return std::string_view{};
+      }
+    };
+
+    SclReader(const char *filename, bool use_mmap) {
+      if (use_mmap)
+      {
+        m_map = std::make_unique<MappedFile>(filename);
+        return;
+      }
+      m_fd = open(filename, O_RDONLY | O_CLOEXEC);
+      if (m_fd >= 0)
+        posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    ~SclReader() {
+      // make sure the file descriptor doesn't leak
+      if (m_fd >= 0)
+        close(m_fd);
+    }
+    // Don't need the other default operations
+    SclReader(const SclReader&) = delete;
+    SclReader& operator=(const SclReader&) = delete;
+    SclReader(SclReader&&) = delete;
+    SclReader& operator=(SclReader&&) = delete;
+
+    bool isGood() const {
+      return m_map ? m_map->isGood() : m_fd >= 0;
+    }
+
+    // Reads the whole file. Returns false on a read error or malformed markup (ref: error()).
+    template <typename Handler>
+    bool parse(Handler &handler) {
+      if (!isGood())
+        return fail("cannot open file");
+      return m_map ? parseMapped(handler) : parseRead(handler);
+    }
+
+    const std::string& error() const { return m_error; }
+    uint64_t bytes() const           { return m_bytes; }
+
+  private:
+    template <typename Handler>
+    bool parseMapped(Handler &handler) {
+      const std::string_view file = (*m_map)();
+      size_t done = 0, window = CHUNK_SIZE;
+      while (done < file.size())
+      {
+        const size_t end = std::min(file.size(), done + window);
+        const bool final = (end == file.size());
+        size_t consumed = 0;
+        if (!tokens(file.substr(done, end - done), final, handler, consumed))
+          return false;
+        if (consumed == 0 && final)
+          return fail("unterminated markup");
+        // A token longer than the window: widen it until the token fits
+        window = (consumed == 0) ? window * 2 : CHUNK_SIZE;
+        done += consumed;
+        m_bytes = done;
+        m_map->release(done);
+      }
+      return true;
+    }
+
+    template <typename Handler>
+    bool parseRead(Handler &handler) {
+      std::vector<char> buffer(CHUNK_SIZE);
+      size_t filled = 0;
+      bool eof = false;
+      while (!eof || filled > 0)
+      {
+        if (!eof && filled < buffer.size())
+        {
+          ssize_t n = read(m_fd, buffer.data() + filled, buffer.size() - filled);
+          if (n < 0)
+            return fail(std::string("read: ") + strerror(errno));
+          eof = (n == 0);
+          filled += static_cast<size_t>(n);
+          m_bytes += static_cast<uint64_t>(n);
+          if (!eof && filled < buffer.size())
+            continue;
+        }
+
+        size_t consumed = 0;
+        if (!tokens(std::string_view(buffer.data(), filled), eof, handler, consumed))
+          return false;
+        if (consumed == 0)
+        {
+          if (eof)
+            return fail("unterminated markup");
+          // A token longer than the buffer: grow the buffer until the token fits
+          buffer.resize(buffer.size() * 2);
+          continue;
+        }
+        std::memmove(buffer.data(), buffer.data() + consumed, filled - consumed);
+        filled -= consumed;
+      }
+      return true;
+    }
+
+    /* Hands every complete token of buf to the handler. consumed: bytes of the tokens handed over
+     * (an incomplete token at the end is left for the next call, unless final).
+     */
+    template <typename Handler>
+    bool tokens(std::string_view buf, bool final, Handler &handler, size_t &consumed) {
+      size_t pos = 0;
+      while (pos < buf.size())
+      {
+        if (buf[pos] != '<')
+        {
+          size_t lt = buf.find('<', pos);
+          if (lt == std::string_view::npos)
+          {
+            if (!final)
+              break;
+            lt = buf.size();
+          }
+          handler.text(decode(buf.substr(pos, lt - pos), m_text));
+          pos = lt;
+          continue;
+        }
+
+        const std::string_view rest = buf.substr(pos);
+        size_t end{};
+        if (rest.compare(0, 4, "<!--") == 0)
+        {
+          if ((end = rest.find("-->", 4)) == std::string_view::npos)
+            break;
+          pos += end + 3;
+        }
+        else if (rest.compare(0, 9, "<![CDATA[") == 0)
+        {
+          if ((end = rest.find("]]>", 9)) == std::string_view::npos)
+            break;
+          pos += end + 3;
+        }
+        else if (rest.compare(0, 2, "<?") == 0)
+        {
+          if ((end = rest.find("?>", 2)) == std::string_view::npos)
+            break;
+          pos += end + 2;
+        }
+        else if (rest.size() < 9 && !final && (std::string_view("<!--").compare(0, rest.size(), rest) == 0
+                                               || std::string_view("<![CDATA[").compare(0, rest.size(), rest) == 0))
+        {
+          break;        // Too short yet to tell a comment or CDATA from a declaration
+        }
+        else if (rest.compare(0, 2, "<!") == 0)
+        {
+          if ((end = rest.find('>', 2)) == std::string_view::npos)
+            break;
+          pos += end + 1;
+        }
+        else if (rest.compare(0, 2, "</") == 0)
+        {
+          if ((end = rest.find('>', 2)) == std::string_view::npos)
+            break;
+          handler.endElement(trim(rest.substr(2, end - 2)));
+          pos += end + 1;
+        }
+        else
+        {
+          bool self_closing = false;
+          if (!startTag(rest, end, self_closing))
+          {
+            if (end == std::string_view::npos)
+              break;
+            return fail("malformed start tag at byte " + std::to_string(m_bytes_before(buf) + pos));
+          }
+          handler.startElement(m_name, m_attributes);
+          if (self_closing)
+            handler.endElement(m_name);
+          pos += end + 1;
+        }
+      }
+      if (pos < buf.size() && final)
+        return fail("unterminated markup at end of file");
+      consumed = pos;
+      return true;
+    }
+
+    /* Parses the start tag at the beginning of rest into m_name/m_attributes. end: offset of its '>'
+     * (npos if the tag is not complete in rest, returning false).
+     */
+    bool startTag(std::string_view rest, size_t &end, bool &self_closing) {
+      // '>' of the tag, outside of attribute values
+      char quote = 0;
+      for (end = 1; end < rest.size(); end++)
+      {
+        if (quote)
+          quote = (rest[end] == quote) ? 0 : quote;
+        else if (rest[end] == '"' || rest[end] == '\'')
+          quote = rest[end];
+        else if (rest[end] == '>')
+          break;
+      }
+      if (end == rest.size())
+      {
+        end = std::string_view::npos;
+        return false;
+      }
+
+      std::string_view tag = rest.substr(1, end - 1);
+      self_closing = !tag.empty() && tag.back() == '/';
+      if (self_closing)
+        tag.remove_suffix(1);
+
+      size_t i = 0;
+      while (i < tag.size() && !isSpace(tag[i]))
+        i++;
+      m_name = tag.substr(0, i);
+      if (m_name.empty())
+        return false;
+
+      m_attributes.items.clear();
+      std::vector<std::pair<std::string_view, std::string_view>> &raw = m_raw;
+      raw.clear();
+      while (true)
+      {
+        while (i < tag.size() && isSpace(tag[i]))
+          i++;
+        if (i == tag.size())
+          break;
+        const size_t name_start = i;
+        while (i < tag.size() && tag[i] != '=' && !isSpace(tag[i]))
+          i++;
+        const std::string_view name = tag.substr(name_start, i - name_start);
+        while (i < tag.size() && isSpace(tag[i]))
+          i++;
+        if (name.empty() || i == tag.size() || tag[i] != '=')
+          return false;
+        i++;
+        while (i < tag.size() && isSpace(tag[i]))
+          i++;
+        if (i == tag.size() || (tag[i] != '"' && tag[i] != '\''))
+          return false;
+        const size_t value_end = tag.find(tag[i], i + 1);
+        if (value_end == std::string_view::npos)
+          return false;
+        raw.emplace_back(name, tag.substr(i + 1, value_end - i - 1));
+        i = value_end + 1;
+      }
+
+      // Decoded values are stored first (no reallocation afterwards: the views stay valid)
+      m_attributes.decoded.assign(raw.size(), std::string{});
+      for (size_t a = 0; a < raw.size(); a++)
+        m_attributes.items.emplace_back(raw[a].first, decode(raw[a].second, m_attributes.decoded[a]));
+      return true;
+    }
+
+    static bool isSpace(char c) {
+      return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    static std::string_view trim(std::string_view s) {
+      while (!s.empty() && isSpace(s.front()))
+        s.remove_prefix(1);
+      while (!s.empty() && isSpace(s.back()))
+        s.remove_suffix(1);
+      return s;
+    }
+
+    // Character data with the XML entities replaced (the input itself if it has none)
+    static std::string_view decode(std::string_view in, std::string &out) {
+      if (in.find('&') == std::string_view::npos)
+        return in;
+      out.clear();
+      for (size_t i = 0; i < in.size(); i++)
+      {
+        const size_t semicolon = (in[i] == '&') ? in.find(';', i) : std::string_view::npos;
+        if (semicolon == std::string_view::npos)
+        {
+          out.push_back(in[i]);
+          continue;
+        }
+        const std::string_view entity = in.substr(i + 1, semicolon - i - 1);
+        unsigned long code{};
+        if (entity == "lt") code = '<';
+        else if (entity == "gt") code = '>';
+        else if (entity == "amp") code = '&';
+        else if (entity == "quot") code = '"';
+        else if (entity == "apos") code = '\'';
+        else if (entity.size() > 1 && entity[0] == '#')
+          code = (entity[1] == 'x') ? std::strtoul(std::string(entity.substr(2)).c_str(), nullptr, 16)
+                                    : std::strtoul(std::string(entity.substr(1)).c_str(), nullptr, 10);
+        else
+        {
+          out.push_back(in[i]);         // Unknown entity: kept as is
+          continue;
+        }
+        // UTF-8 encoding of the code point
+        if (code < 0x80)
+          out.push_back(static_cast<char>(code));
+        else if (code < 0x800)
+          out.append({static_cast<char>(0xC0 | (code >> 6)), static_cast<char>(0x80 | (code & 0x3F))});
+        else if (code < 0x10000)
+          out.append({static_cast<char>(0xE0 | (code >> 12)), static_cast<char>(0x80 | ((code >> 6) & 0x3F)),
+                      static_cast<char>(0x80 | (code & 0x3F))});
+        else
+          out.append({static_cast<char>(0xF0 | (code >> 18)), static_cast<char>(0x80 | ((code >> 12) & 0x3F)),
+                      static_cast<char>(0x80 | ((code >> 6) & 0x3F)), static_cast<char>(0x80 | (code & 0x3F))});
+        i = semicolon;
+      }
+      return out;
+    }
+
+    // Offset in the file of the start of buf (for error messages)
+    uint64_t m_bytes_before(std::string_view buf) const {
+      return m_map ? static_cast<uint64_t>(buf.data() - (*m_map)().data()) : m_bytes - buf.size();
+    }
+
+    bool fail(const std::string &error) {
+      m_error = error;
+      return false;
+    }
+
+    std::unique_ptr<MappedFile> m_map{};
+    int                         m_fd{-1};
+    uint64_t                    m_bytes{0};         // read so far
+    std::string                 m_error{};
+
+    std::string_view            m_name{};           // of the current start tag
+    Attributes                  m_attributes{};
+    std::vector<std::pair<std::string_view, std::string_view>> m_raw{};    // attributes as written
+    std::string                 m_text{};           // decoded character data
+};
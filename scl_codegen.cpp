@@ -0,0 +1,348 @@
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// For parsing SED file (in XML format)
+#include "parse_sed.hpp"
+
+// For the types of the members of each DataSet (DataTypeTemplates)
+#include "scl_types.hpp"
+
+/* Generates C++ codecs for the DataSets of a SED file: for each DataSet of a Control Block, a struct
+ * with one member per basic value, and functions that encode it into, and decode it from, R-GOOSE
+ * allData (the Data of its entries) or R-SV seqOfData.
+ *
+ * The layout of every DataSet is known when the code is generated, so each codec is straight-line
+ * code at constant offsets, with no branch on the data:
+ *  - R-GOOSE: the fixed-length encoding of IEC 61850-8-1 (fixedOffs): every value of a type takes the
+ *    same number of bytes (e.g. INT32: 85 04 and 4 bytes, FLOAT32: 87 05 08 and 4 bytes), so that
+ *    allData has one size. The decoder checks the length once, and every tag and length byte with
+ *    one accumulated comparison.
+ *  - R-SV: the fixed-length encoding of IEC 61850-9-2: values without tags (BOOLEAN: 1 byte, INT32
+ *    and FLOAT32: 4 bytes, Quality: 4 bytes, Timestamp: 8 bytes).
+ *
+ * A DataSet that cannot be typed (e.g. an FCDA naming a DA that its DO type does not have) is
+ * reported and left out.
+ */
+
+struct Codec
+{
+    std::ostringstream fields{};
+    std::ostringstream encode{};
+    std::ostringstream decode{};
+    std::set<std::string> names{};
+    size_t offset{0};
+};
+
+// C++ identifier of a name of the SCL file
+std::string identifier(std::string_view name)
+{
+    std::string id{};
+    for (char c : name)
+        id += (std::isalnum(static_cast<unsigned char>(c)) ? c : '_');
+    if (id.empty() || std::isdigit(static_cast<unsigned char>(id[0])))
+        id.insert(0, 1, '_');
+    return id;
+}
+
+const char* cpp_type(BasicType type)
+{
+    switch (type)
+    {
+        case BasicType::Boolean:   return "bool";
+        case BasicType::Int8:      return "int8_t";
+        case BasicType::Int16:     return "int16_t";
+        case BasicType::Int32:     return "int32_t";
+        case BasicType::Int8U:     return "uint8_t";
+        case BasicType::Int16U:    return "uint16_t";
+        case BasicType::Int32U:    return "uint32_t";
+        case BasicType::Float32:   return "float";
+        case BasicType::Enum:      return "int8_t";
+        case BasicType::Dbpos:     return "uint8_t";       // 0: intermediate, 1: off, 2: on, 3: bad
+        case BasicType::Quality:   return "uint16_t";      // the 13 bits, first one as most significant bit
+        case BasicType::Timestamp: return "uint64_t";      // the 8 bytes, first one as most significant byte
+        default:                   return "";
+    }
+}
+
+// Bytes of the value of a basic type (after its tag and length in R-GOOSE)
+size_t value_size(BasicType type, bool gse)
+{
+    switch (type)
+    {
+        case BasicType::Boolean: case BasicType::Int8: case BasicType::Int8U: case BasicType::Enum: case BasicType::Dbpos:
+            return 1;
+        case BasicType::Int16: case BasicType::Int16U:
+            return 2;
+        case BasicType::Quality:
+            return gse ? 2 : 4;
+        case BasicType::Timestamp:
+            return 8;
+        default:
+            return 4;
+    }
+}
+
+// Tag, length and leading bytes of a basic value in R-GOOSE (fixed-length encoding)
+std::vector<unsigned int> gse_header(BasicType type)
+{
+    const unsigned int size = static_cast<unsigned int>(value_size(type, true));
+    switch (type)
+    {
+        case BasicType::Boolean:   return {0x83, 0x01};
+        case BasicType::Int8: case BasicType::Int16: case BasicType::Int32: case BasicType::Enum:
+                                   return {0x85, size};
+        case BasicType::Int8U: case BasicType::Int16U: case BasicType::Int32U:
+                                   return {0x86, size + 1, 0x00};
+        case BasicType::Float32:   return {0x87, 0x05, 0x08};
+        case BasicType::Dbpos:     return {0x84, 0x02, 0x06};
+        case BasicType::Quality:   return {0x84, 0x03, 0x03};
+        case BasicType::Timestamp: return {0x91, 0x08};
+        default:                   return {};
+    }
+}
+
+// Tag and length bytes of a length (short form below 128, long form above)
+std::vector<unsigned int> ber_length(size_t length)
+{
+    if (length < 0x80)
+        return {static_cast<unsigned int>(length)};
+    if (length <= 0xFF)
+        return {0x81, static_cast<unsigned int>(length)};
+    return {0x82, static_cast<unsigned int>(length >> 8), static_cast<unsigned int>(length & 0xFF)};
+}
+
+// Bytes of an encoded value
+size_t encoded_size(const TypedValue &value, bool gse)
+{
+    if (value.type != BasicType::Struct)
+        return (gse ? gse_header(value.type).size() : 0) + value_size(value.type, gse);
+    size_t size{0};
+    for (const TypedValue &member : value.members)
+        size += encoded_size(member, gse);
+    return gse ? 1 + ber_length(size).size() + size : size;
+}
+
+void emit_bytes(Codec &codec, const std::vector<unsigned int> &bytes)
+{
+    char hex[8];
+    for (unsigned int byte : bytes)
+    {
+        std::snprintf(hex, sizeof(hex), "0x%02X", byte);
+        codec.encode << "    out[" << codec.offset << "] = " << hex << ";\n";
+        codec.decode << "    bad |= in[" << codec.offset << "] ^ " << hex << "u;\n";
+        codec.offset++;
+    }
+}
+
+void emit_value(const TypedValue &value, const std::string &path, bool gse, Codec &codec)
+{
+    if (value.type == BasicType::Struct)
+    {
+        if (gse)
+        {
+            size_t content{0};
+            for (const TypedValue &member : value.members)
+                content += encoded_size(member, gse);
+            std::vector<unsigned int> header = ber_length(content);
+            header.insert(header.begin(), 0xA2);
+            emit_bytes(codec, header);
+        }
+        for (const TypedValue &member : value.members)
+            emit_value(member, path + '.' + member.name, gse, codec);
+        return;
+    }
+
+    // Member of the struct (made unique if two FCDAs name the same value)
+    std::string member = identifier(path.substr(1));
+    for (int n = 2; !codec.names.insert(member).second; n++)
+        member = identifier(path.substr(1)) + '_' + std::to_string(n);
+    const std::string declaration = std::string(cpp_type(value.type)) + ' ' + member + "{};";
+    codec.fields << "    " << declaration << std::string(declaration.size() < 40 ? 40 - declaration.size() : 1, ' ')
+                 << "// " << path.substr(1) << " (" << basic_type_name(value.type) << ")\n";
+
+    if (gse)
+        emit_bytes(codec, gse_header(value.type));
+
+    const size_t at = codec.offset;
+    const std::string put = "out + " + std::to_string(at), get = "in + " + std::to_string(at);
+    switch (value.type)
+    {
+        case BasicType::Boolean:
+            codec.encode << "    out[" << at << "] = static_cast<unsigned char>(data." << member << ");\n";
+            codec.decode << "    data." << member << " = in[" << at << "] != 0;\n";
+            break;
+        case BasicType::Int8: case BasicType::Enum: case BasicType::Int8U:
+            codec.encode << "    out[" << at << "] = static_cast<unsigned char>(data." << member << ");\n";
+            codec.decode << "    data." << member << " = static_cast<" << cpp_type(value.type) << ">(in[" << at << "]);\n";
+            break;
+        case BasicType::Dbpos:
+            if (gse)
+            {
+                codec.encode << "    out[" << at << "] = static_cast<unsigned char>((data." << member << " & 0x03) << 6);\n";
+                codec.decode << "    data." << member << " = in[" << at << "] >> 6;\n";
+            }
+            else
+            {
+                codec.encode << "    out[" << at << "] = data." << member << " & 0x03;\n";
+                codec.decode << "    data." << member << " = in[" << at << "] & 0x03;\n";
+            }
+            break;
+        case BasicType::Int16: case BasicType::Int16U:
+            codec.encode << "    codegen_put16(" << put << ", static_cast<uint16_t>(data." << member << "));\n";
+            codec.decode << "    data." << member << " = static_cast<" << cpp_type(value.type) << ">(codegen_get16(" << get << "));\n";
+            break;
+        case BasicType::Quality:
+            codec.encode << (gse ? "    codegen_put16(" : "    codegen_put32(") << put << ", data." << member << ");\n";
+            codec.decode << "    data." << member << " = static_cast<uint16_t>(" << (gse ? "codegen_get16(" : "codegen_get32(") << get << "));\n";
+            break;
+        case BasicType::Int32: case BasicType::Int32U:
+            codec.encode << "    codegen_put32(" << put << ", static_cast<uint32_t>(data." << member << "));\n";
+            codec.decode << "    data." << member << " = static_cast<" << cpp_type(value.type) << ">(codegen_get32(" << get << "));\n";
+            break;
+        case BasicType::Float32:
+            codec.encode << "    codegen_put_float(" << put << ", data." << member << ");\n";
+            codec.decode << "    data." << member << " = codegen_get_float(" << get << ");\n";
+            break;
+        case BasicType::Timestamp:
+            codec.encode << "    codegen_put64(" << put << ", data." << member << ");\n";
+            codec.decode << "    data." << member << " = codegen_get64(" << get << ");\n";
+            break;
+        default:
+            break;
+    }
+    codec.offset += value_size(value.type, gse);
+}
+
+// Byte order helpers of the generated codecs (once per translation unit)
+const char *const CODEGEN_HELPERS = R"(#ifndef SCL_CODEGEN_HELPERS
+#define SCL_CODEGEN_HELPERS
+inline void codegen_put16(unsigned char *p, uint16_t v) { p[0] = v >> 8; p[1] = v & 0xFF; }
+inline void codegen_put32(unsigned char *p, uint32_t v) { codegen_put16(p, v >> 16); codegen_put16(p + 2, v & 0xFFFF); }
+inline void codegen_put64(unsigned char *p, uint64_t v) { codegen_put32(p, v >> 32); codegen_put32(p + 4, v & 0xFFFFFFFF); }
+inline void codegen_put_float(unsigned char *p, float f) { uint32_t v; std::memcpy(&v, &f, sizeof(v)); codegen_put32(p, v); }
+inline uint16_t codegen_get16(const unsigned char *p) { return static_cast<uint16_t>(p[0] << 8 | p[1]); }
+inline uint32_t codegen_get32(const unsigned char *p) { return uint32_t{codegen_get16(p)} << 16 | codegen_get16(p + 2); }
+inline uint64_t codegen_get64(const unsigned char *p) { return uint64_t{codegen_get32(p)} << 32 | codegen_get32(p + 4); }
+inline float codegen_get_float(const unsigned char *p) { uint32_t v = codegen_get32(p); float f; std::memcpy(&f, &v, sizeof(f)); return f; }
+#endif
+)";
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        std::cout << "Usage: " << (argv[0] ? argv[0] : "scl_codegen") << " <SED Filename> <Output Header> [IED Name...]" << '\n';
+        return 1;
+    }
+    const char *sed_filename = argv[1];
+    const std::set<std::string> ied_names{argv + 3, argv + argc};
+
+    rapidxml::file<> xmlFile(sed_filename);
+    rapidxml::xml_document<> doc;
+    doc.parse<0>(xmlFile.data());
+    SclNode *root_node = doc.first_node();
+    if (!root_node || scl_name(root_node) != "SCL")
+    {
+        std::cout << "Name of Root Node is not \"SCL\"! Please check format of SED file: " << sed_filename << '\n';
+        return 1;
+    }
+    std::vector<TypedDataSet> dataSets = typed_datasets(root_node);
+
+    // Subscribers of each Control Block, for the selection by IED
+    std::set<std::pair<std::string, std::string>> subscribers{};
+    if (!ied_names.empty())
+    {
+        std::streambuf *cout_buf = std::cout.rdbuf(nullptr);    // Progress of every Control Block parsed
+        try
+        {
+            for (const ControlBlock &cb : parse_sed(sed_filename, 1))
+            {
+                for (Symbol subscriber : cb.subscribingIEDs)
+                    subscribers.emplace(cb.hostIED.str() + '/' + cb.cbName.str(), subscriber.str());
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cout.rdbuf(cout_buf);
+            std::cout << "[!] " << e.what() << '\n';
+            return 1;
+        }
+        std::cout.rdbuf(cout_buf);
+    }
+
+    std::ostringstream header{};
+    header << "/* Codecs of the DataSets of " << sed_filename << ", generated by scl_codegen: do not edit\n"
+           << " *\n"
+           << " * For each DataSet: its struct, <Name>_ENTRIES (numDatSetEntries), <Name>_SIZE (bytes of R-GOOSE allData\n"
+           << " * or R-SV seqOfData), encode_<Name>() (writes <Name>_SIZE bytes, returns that size) and decode_<Name>()\n"
+           << " * (false if the bytes are not a fixed-length encoding of the DataSet).\n"
+           << " */\n"
+           << "#include <cstddef>\n#include <cstdint>\n#include <cstring>\n\n" << CODEGEN_HELPERS;
+
+    std::set<std::string> generated{};
+    size_t count{0};
+    for (const TypedDataSet &dataSet : dataSets)
+    {
+        const std::string label = dataSet.iedName + ' ' + dataSet.datSetName;
+        if (!ied_names.empty() && !ied_names.count(dataSet.iedName))
+        {
+            bool subscribed{false};
+            for (const std::string &ied : ied_names)
+                subscribed = subscribed || subscribers.count({dataSet.iedName + '/' + dataSet.cbName, ied});
+            if (!subscribed)
+                continue;
+        }
+        if (!dataSet.error.empty())
+        {
+            std::cout << "[!] " << label << " left out: " << dataSet.error << '\n';
+            continue;
+        }
+
+        // A DataSet of several Control Blocks is generated once
+        const std::string name = identifier(dataSet.iedName + '_' + dataSet.datSetName.substr(0, dataSet.datSetName.find('/'))
+                                            + '_' + dataSet.datSetName.substr(dataSet.datSetName.find('.') + 1));
+        if (!generated.insert(name + (dataSet.cbType == CbType::GSE ? "/GSE" : "/SMV")).second)
+            continue;
+        const std::string type_name = generated.count(name + "/GSE") && generated.count(name + "/SMV")
+                                      ? name + (dataSet.cbType == CbType::GSE ? "_GSE" : "_SMV") : name;
+
+        const bool gse = (dataSet.cbType == CbType::GSE);
+        Codec codec{};
+        size_t size{0};
+        for (const TypedValue &entry : dataSet.entries)
+        {
+            emit_value(entry, '.' + entry.name, gse, codec);
+            size += encoded_size(entry, gse);
+        }
+
+        header << "\n// " << label << " (" << (gse ? "R-GOOSE allData" : "R-SV seqOfData") << " of " << dataSet.cbName << "): "
+               << dataSet.entries.size() << " entries, " << size << " bytes\n"
+               << "struct " << type_name << "\n{\n" << codec.fields.str() << "};\n\n"
+               << "constexpr size_t " << type_name << "_ENTRIES = " << dataSet.entries.size() << ";\n"
+               << "constexpr size_t " << type_name << "_SIZE = " << size << ";\n\n"
+               << "inline size_t encode_" << type_name << "(const " << type_name << " &data, unsigned char *out)\n{\n"
+               << codec.encode.str() << "    return " << size << ";\n}\n\n"
+               << "inline bool decode_" << type_name << "(const unsigned char *in, size_t len, " << type_name << " &data)\n{\n"
+               << "    if (len != " << size << ")\n        return false;\n"
+               << (gse ? "    unsigned int bad{0};\n" : "") << codec.decode.str()
+               << "    return " << (gse ? "bad == 0" : "true") << ";\n}\n";
+        std::cout << "[*] " << label << ": " << type_name << ", " << dataSet.entries.size() << " entries, " << size << " bytes\n";
+        count++;
+    }
+
+    std::ofstream output(argv[2]);
+    output << header.str();
+    if (!output.flush())
+    {
+        std::cout << "[!] Couldn't write " << argv[2] << '\n';
+        return 1;
+    }
+    std::cout << "[*] Generated the codecs of " << count << " DataSet(s) in " << argv[2] << '\n';
+    return 0;
+}
@@ -0,0 +1,466 @@
+/* Types of the members of a DataSet, from the <DataTypeTemplates> of an SCL file
+ *
+ * Each FCDA of a DataSet names a Data Object (doName, with its sub Data Objects: "A.phsA") and
+ * optionally one of its Data Attributes (daName, with its Basic Data Attributes: "cVal.mag.f") of a
+ * Logical Node. Its type is found by following the lnType of the LN instance to its <LNodeType>, the
+ * DO to its <DOType>, and the DA to its <DAType>, down to basic types (bType). An FCDA without daName
+ * is the whole Data Object, restricted to the attributes of its functional constraint (fc).
+ *
+ * Types that a file uses without defining them (e.g. sample.sed gives "WYE" or "DPC" as DO type)
+ * are taken from the Common Data Classes of IEC 61850-7-3 named so, in a reduced form: the status
+ * or measured value, quality and time stamp of each.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Basic types of a Data Attribute (bType), as carried in GOOSE allData and R-SV seqOfData
+enum class BasicType : uint8_t
+{
+    Boolean,
+    Int8,
+    Int16,
+    Int32,
+    Int8U,
+    Int16U,
+    Int32U,
+    Float32,
+    Enum,
+    Dbpos,          // double point position: 2-bit bit-string
+    Quality,        // 13-bit bit-string
+    Timestamp,      // UtcTime: 4 bytes of seconds, 3 of fraction, 1 of quality
+    Struct,
+};
+
+// Basic type of a bType attribute: false if it is not supported in a DataSet here (e.g. VisString255)
+bool basic_type(std::string_view bType, BasicType &type)
+{
+    static const std::unordered_map<std::string_view, BasicType> types{
+        {"BOOLEAN", BasicType::Boolean}, {"INT8", BasicType::Int8}, {"INT16", BasicType::Int16},
+        {"INT32", BasicType::Int32}, {"INT8U", BasicType::Int8U}, {"INT16U", BasicType::Int16U},
+        {"INT32U", BasicType::Int32U}, {"FLOAT32", BasicType::Float32}, {"Enum", BasicType::Enum},
+        {"Dbpos", BasicType::Dbpos}, {"Quality", BasicType::Quality}, {"Timestamp", BasicType::Timestamp},
+        {"Struct", BasicType::Struct}};
+    std::unordered_map<std::string_view, BasicType>::const_iterator found = types.find(bType);
+    if (found == types.end())
+        return false;
+    type = found->second;
+    return true;
+}
+
+const char* basic_type_name(BasicType type)
+{
+    static const char *const names[] = {"BOOLEAN", "INT8", "INT16", "INT32", "INT8U", "INT16U", "INT32U",
+                                        "FLOAT32", "Enum", "Dbpos", "Quality", "Timestamp", "Struct"};
+    return names[static_cast<unsigned int>(type)];
+}
+
+// A value of a DataSet: a basic type, or a structure of values
+struct TypedValue
+{
+    std::string             name{};         // e.g. "A.phsA.cVal" (an FCDA), or "mag" (a member of a structure)
+    BasicType               type{BasicType::Boolean};
+    std::vector<TypedValue> members{};      // of a Struct, in order
+};
+
+/* Index of <DataTypeTemplates>: the DOs of each LNodeType, and the attributes of each DOType (DA, SDO)
+ * and DAType (BDA), by id
+ */
+struct SclTypes
+{
+    struct Attribute
+    {
+        std::string name{};
+        std::string fc{};           // DA of a DOType only
+        std::string bType{};        // empty for an SDO
+        std::string type{};         // DOType of an SDO, DAType of a Struct, EnumType of an Enum
+    };
+
+    std::unordered_map<std::string, std::unordered_map<std::string, std::string>> lNodeTypes{};    // DO name -> DOType id
+    std::unordered_map<std::string, std::string>                                  lnClassTypes{};  // first LNodeType of each lnClass
+    std::unordered_map<std::string, std::vector<Attribute>>                       doTypes{};
+    std::unordered_map<std::string, std::vector<Attribute>>                       daTypes{};
+};
+
+/* Common Data Classes used in place of the DOTypes/DATypes that a file does not define
+ * Each attribute is "name/fc/bType/type" (an SDO: "name//SDO/type").
+ */
+void add_standard_types(SclTypes &types)
+{
+    static const char *const doTypes[][2] = {
+        {"SPS", "stVal/ST/BOOLEAN/ q/ST/Quality/ t/ST/Timestamp/"},
+        {"SPC", "stVal/ST/BOOLEAN/ q/ST/Quality/ t/ST/Timestamp/"},
+        {"DPS", "stVal/ST/Dbpos/ q/ST/Quality/ t/ST/Timestamp/"},
+        {"DPC", "stVal/ST/Dbpos/ q/ST/Quality/ t/ST/Timestamp/"},
+        {"INS", "stVal/ST/INT32/ q/ST/Quality/ t/ST/Timestamp/"},
+        {"INC", "stVal/ST/INT32/ q/ST/Quality/ t/ST/Timestamp/"},
+        {"ENS", "stVal/ST/Enum/ q/ST/Quality/ t/ST/Timestamp/"},
+        {"ENC", "stVal/ST/Enum/ q/ST/Quality/ t/ST/Timestamp/"},
+        {"ACT", "general/ST/BOOLEAN/ q/ST/Quality/ t/ST/Timestamp/"},
+        {"ACD", "general/ST/BOOLEAN/ q/ST/Quality/ t/ST/Timestamp/"},
+        {"MV",  "mag/MX/Struct/AnalogueValue q/MX/Quality/ t/MX/Timestamp/"},
+        {"CMV", "cVal/MX/Struct/Vector q/MX/Quality/ t/MX/Timestamp/"},
+        {"WYE", "phsA//SDO/CMV phsB//SDO/CMV phsC//SDO/CMV neut//SDO/CMV net//SDO/CMV res//SDO/CMV"},
+        {"DEL", "phsAB//SDO/CMV phsBC//SDO/CMV phsCA//SDO/CMV"},
+    };
+    static const char *const daTypes[][2] = {
+        {"AnalogueValue", "f//FLOAT32/"},
+        {"Vector",        "mag//Struct/AnalogueValue ang//Struct/AnalogueValue"},
+    };
+
+    auto attributes = [](std::string_view text) {
+        std::vector<SclTypes::Attribute> list{};
+        size_t pos{0};
+        while (pos < text.size())
+        {
+            size_t end = std::min(text.find(' ', pos), text.size());
+            std::string_view item = text.substr(pos, end - pos);
+            std::string_view parts[4]{};
+            for (int i = 0; i < 4; i++)
+            {
+                size_t slash = std::min(item.find('/'), item.size());
+                parts[i] = item.substr(0, slash);
+                item.remove_prefix(std::min(slash + 1, item.size()));
+            }
+            list.push_back(SclTypes::Attribute{std::string(parts[0]), std::string(parts[1]),
+                                               parts[2] == "SDO" ? std::string() : std::string(parts[2]), std::string(parts[3])});
+            pos = end + 1;
+        }
+        return list;
+    };
+    for (const auto &doType : doTypes)
+        types.doTypes.emplace(doType[0], attributes(doType[1]));
+    for (const auto &daType : daTypes)
+        types.daTypes.emplace(daType[0], attributes(daType[1]));
+}
+
+// Reads the <DataTypeTemplates> of an SCL document (those of the file take precedence over the standard ones)
+SclTypes read_scl_types(SclNode *root_node)
+{
+    SclTypes types{};
+    for (SclNode *nodeDTT = root_node->first_node("DataTypeTemplates"); nodeDTT; nodeDTT = nodeDTT->next_sibling("DataTypeTemplates"))
+    {
+        for (SclNode *node = nodeDTT->first_node(); node; node = node->next_sibling())
+        {
+            std::string_view name = scl_name(node);
+            std::string id{scl_attr(node, "id")};
+            if (name == "LNodeType")
+            {
+                std::unordered_map<std::string, std::string> &dos = types.lNodeTypes[id];
+                for (SclNode *nodeDO = node->first_node("DO"); nodeDO; nodeDO = nodeDO->next_sibling("DO"))
+                    dos.emplace(scl_attr(nodeDO, "name"), scl_attr(nodeDO, "type"));
+                types.lnClassTypes.emplace(scl_attr(node, "lnClass"), id);
+            }
+            else if (name == "DOType" || name == "DAType")
+            {
+                std::vector<SclTypes::Attribute> &attributes = (name == "DOType") ? types.doTypes[id] : types.daTypes[id];
+                for (SclNode *nodeAttr = node->first_node(); nodeAttr; nodeAttr = nodeAttr->next_sibling())
+                {
+                    std::string_view element = scl_name(nodeAttr);
+                    if (element != "DA" && element != "SDO" && element != "BDA")
+                        continue;
+                    attributes.push_back(SclTypes::Attribute{std::string(scl_attr(nodeAttr, "name")), std::string(scl_attr(nodeAttr, "fc")),
+                                                             std::string(scl_attr(nodeAttr, "bType")), std::string(scl_attr(nodeAttr, "type"))});
+                }
+            }
+        }
+    }
+    add_standard_types(types);
+    return types;
+}
+
+// Splits "a.b.c" into its names
+std::vector<std::string_view> scl_path(std::string_view path)
+{
+    std::vector<std::string_view> names{};
+    while (!path.empty())
+    {
+        size_t dot = std::min(path.find('.'), path.size());
+        names.push_back(path.substr(0, dot));
+        path.remove_prefix(std::min(dot + 1, path.size()));
+    }
+    return names;
+}
+
+/* Type of an attribute (basic, or the structure of its DAType), named name
+ * Returns false, with the reason in error, if a type is unknown or unsupported.
+ */
+bool scl_attribute_value(const SclTypes &types, const SclTypes::Attribute &attribute, const std::string &name,
+                         TypedValue &value, std::string &error, int depth = 0)
+{
+    value.name = name;
+    if (!basic_type(attribute.bType, value.type))
+    {
+        error = "unsupported bType \"" + attribute.bType + "\" of " + name;
+        return false;
+    }
+    if (value.type != BasicType::Struct)
+        return true;
+
+    std::unordered_map<std::string, std::vector<SclTypes::Attribute>>::const_iterator daType = types.daTypes.find(attribute.type);
+    if (daType == types.daTypes.end() || depth > 8)
+    {
+        error = "unknown DAType \"" + attribute.type + "\" of " + name;
+        return false;
+    }
+    for (const SclTypes::Attribute &bda : daType->second)
+    {
+        value.members.emplace_back();
+        if (!scl_attribute_value(types, bda, bda.name, value.members.back(), error, depth + 1))
+            return false;
+    }
+    return true;
+}
+
+// Structure of the attributes (and SDOs) of a DOType with functional constraint fc
+bool scl_data_object_value(const SclTypes &types, const std::string &doType, std::string_view fc, const std::string &name,
+                           TypedValue &value, std::string &error, int depth = 0)
+{
+    std::unordered_map<std::string, std::vector<SclTypes::Attribute>>::const_iterator found = types.doTypes.find(doType);
+    if (found == types.doTypes.end() || depth > 8)
+    {
+        error = "unknown DOType \"" + doType + "\" of " + name;
+        return false;
+    }
+    value.name = name;
+    value.type = BasicType::Struct;
+    for (const SclTypes::Attribute &attribute : found->second)
+    {
+        TypedValue member{};
+        if (attribute.bType.empty())
+        {
+            if (!scl_data_object_value(types, attribute.type, fc, attribute.name, member, error, depth + 1))
+                return false;
+            if (member.members.empty())
+                continue;
+        }
+        else if (attribute.fc != fc)
+        {
+            continue;
+        }
+        else if (!scl_attribute_value(types, attribute, attribute.name, member, error))
+        {
+            return false;
+        }
+        value.members.push_back(std::move(member));
+    }
+    return true;
+}
+
+/* Type of an FCDA of an LN of type lnType: the DA daName of the DO doName, or the whole DO (fc only)
+ * if daName is empty. Returns false, with the reason in error, if it cannot be typed.
+ */
+bool scl_fcda_value(const SclTypes &types, const std::string &lnType, std::string_view doName, std::string_view daName,
+                    std::string_view fc, TypedValue &value, std::string &error)
+{
+    std::unordered_map<std::string, std::unordered_map<std::string, std::string>>::const_iterator lNodeType = types.lNodeTypes.find(lnType);
+    if (lNodeType == types.lNodeTypes.end())
+    {
+        error = "unknown LNodeType \"" + lnType + "\"";
+        return false;
+    }
+
+    // DO, then its SDOs
+    std::vector<std::string_view> doPath = scl_path(doName);
+    std::unordered_map<std::string, std::string>::const_iterator dataObject =
+        doPath.empty() ? lNodeType->second.end() : lNodeType->second.find(std::string(doPath[0]));
+    if (dataObject == lNodeType->second.end())
+    {
+        error = "no DO \"" + std::string(doName) + "\" in LNodeType \"" + lnType + "\"";
+        return false;
+    }
+    std::string doType = dataObject->second;
+    for (size_t i = 1; i < doPath.size(); i++)
+    {
+        std::unordered_map<std::string, std::vector<SclTypes::Attribute>>::const_iterator found = types.doTypes.find(doType);
+        if (found == types.doTypes.end())
+        {
+            error = "unknown DOType \"" + doType + "\" of " + std::string(doName);
+            return false;
+        }
+        std::vector<SclTypes::Attribute>::const_iterator sdo = std::find_if(found->second.begin(), found->second.end(),
+            [&doPath, i](const SclTypes::Attribute &attribute) { return attribute.bType.empty() && attribute.name == doPath[i]; });
+        if (sdo == found->second.end())
+        {
+            error = "no SDO \"" + std::string(doPath[i]) + "\" in DOType \"" + doType + "\"";
+            return false;
+        }
+        doType = sdo->type;
+    }
+
+    const std::string name = std::string(doName) + (daName.empty() ? "" : ".") + std::string(daName);
+    if (daName.empty())
+        return scl_data_object_value(types, doType, fc, name, value, error);
+
+    // DA, then its BDAs
+    std::unordered_map<std::string, std::vector<SclTypes::Attribute>>::const_iterator found = types.doTypes.find(doType);
+    if (found == types.doTypes.end())
+    {
+        error = "unknown DOType \"" + doType + "\" of " + std::string(doName);
+        return false;
+    }
+    std::vector<std::string_view> daPath = scl_path(daName);
+    std::vector<SclTypes::Attribute>::const_iterator attribute = std::find_if(found->second.begin(), found->second.end(),
+        [&daPath](const SclTypes::Attribute &da) { return !da.bType.empty() && da.name == daPath[0]; });
+    if (attribute == found->second.end())
+    {
+        error = "no DA \"" + std::string(daPath[0]) + "\" in DOType \"" + doType + "\" of " + std::string(doName);
+        return false;
+    }
+    if (attribute->fc != fc)
+    {
+        error = "DA \"" + name + "\" has fc " + attribute->fc + ", not " + std::string(fc);
+        return false;
+    }
+    for (size_t i = 1; i < daPath.size(); i++)
+    {
+        std::unordered_map<std::string, std::vector<SclTypes::Attribute>>::const_iterator daType = types.daTypes.find(attribute->type);
+        if (attribute->bType != "Struct" || daType == types.daTypes.end())
+        {
+            error = "no BDA \"" + std::string(daPath[i]) + "\" in " + name;
+            return false;
+        }
+        attribute = std::find_if(daType->second.begin(), daType->second.end(),
+                                 [&daPath, i](const SclTypes::Attribute &bda) { return bda.name == daPath[i]; });
+        if (attribute == daType->second.end())
+        {
+            error = "no BDA \"" + std::string(daPath[i]) + "\" in DAType \"" + daType->first + "\"";
+            return false;
+        }
+    }
+    return scl_attribute_value(types, *attribute, name, value, error);
+}
+
+/* lnType of the LN (or LN0) of an LDevice with the given prefix, lnClass and inst. Falls back to the
+ * first LNodeType of that lnClass if the LDevice has no such LN.
+ */
+std::string scl_ln_type(const SclTypes &types, const SclNode *lDevice, std::string_view prefix, std::string_view lnClass,
+                        std::string_view lnInst)
+{
+    for (SclNode *node = lDevice ? lDevice->first_node() : nullptr; node; node = node->next_sibling())
+    {
+        std::string_view name = scl_name(node);
+        if ((name == "LN" || name == "LN0") && scl_attr(node, "lnClass") == lnClass
+            && scl_attr(node, "prefix") == prefix && (name == "LN0" || scl_attr(node, "inst") == lnInst))
+            return std::string(scl_attr(node, "lnType"));
+    }
+    std::unordered_map<std::string, std::string>::const_iterator found = types.lnClassTypes.find(std::string(lnClass));
+    return (found == types.lnClassTypes.end()) ? std::string() : found->second;
+}
+
+// The DataSet of a Control Block, with the type of each of its members (FCDAs)
+struct TypedDataSet
+{
+    std::string             iedName{};
+    CbType                  cbType{CbType::Unknown};
+    std::string             cbName{};           // fully qualified, as ControlBlock::cbName
+    std::string             datSetName{};       // fully qualified, as ControlBlock::datSetName
+    std::vector<TypedValue> entries{};          // one per FCDA, in order
+    std::string             error{};            // why the DataSet could not be typed (empty if it was)
+};
+
+/* DataSets of every Control Block (GSEControl, SampledValueControl) of an SCL document, in document
+ * order, typed from its DataTypeTemplates
+ */
+std::vector<TypedDataSet> typed_datasets(SclNode *root_node)
+{
+    const SclTypes types = read_scl_types(root_node);
+    const SclIndex index = index_ieds(root_node);
+    std::vector<TypedDataSet> dataSets{};
+
+    for (SclNode *nodeIED = root_node->first_node("IED"); nodeIED; nodeIED = nodeIED->next_sibling("IED"))
+    {
+        SclIndex::const_iterator ied = index.find(scl_attr(nodeIED, "name"));
+        if (ied == index.end() || ied->second.node != nodeIED)
+            continue;
+
+        for (SclNode *nodeAP = nodeIED->first_node("AccessPoint"); nodeAP; nodeAP = nodeAP->next_sibling("AccessPoint"))
+        {
+            for (SclNode *nodeLDev = nodeAP->first_node("LDevice"); nodeLDev; nodeLDev = nodeLDev->next_sibling("LDevice"))
+            {
+                std::unordered_map<std::string_view, SclLDevice>::const_iterator lDevice = ied->second.lDevices.find(scl_attr(nodeLDev, "inst"));
+                if (lDevice == ied->second.lDevices.end() || lDevice->second.node != nodeLDev || !lDevice->second.ln0)
+                    continue;
+
+                const std::string prefix = std::string(scl_attr(nodeLDev, "inst")) + '/' + std::string(scl_attr(lDevice->second.ln0, "lnClass")) + '.';
+                for (SclNode *control = lDevice->second.ln0->first_node(); control; control = control->next_sibling())
+                {
+                    std::string_view element = scl_name(control);
+                    if (element != "GSEControl" && element != "SampledValueControl")
+                        continue;
+
+                    TypedDataSet dataSet{};
+                    dataSet.iedName = std::string(scl_attr(nodeIED, "name"));
+                    dataSet.cbType = (element == "GSEControl") ? CbType::GSE : CbType::SMV;
+                    dataSet.cbName = prefix + std::string(scl_attr(control, "Name"));
+                    dataSet.datSetName = prefix + std::string(scl_attr(control, "datSet"));
+
+                    std::unordered_map<std::string_view, SclNode*>::const_iterator nodeDataSet = lDevice->second.dataSets.find(scl_attr(control, "datSet"));
+                    if (nodeDataSet == lDevice->second.dataSets.end())
+                        dataSet.error = "DataSet not found";
+                    for (SclNode *nodeFCDA = (nodeDataSet == lDevice->second.dataSets.end()) ? nullptr : nodeDataSet->second->first_node("FCDA");
+                         nodeFCDA && dataSet.error.empty(); nodeFCDA = nodeFCDA->next_sibling("FCDA"))
+                    {
+                        // An FCDA without ldInst is taken from the LDevice of its DataSet
+                        std::string_view ldInst = scl_attr(nodeFCDA, "ldInst");
+                        std::unordered_map<std::string_view, SclLDevice>::const_iterator fcdaLDevice =
+                            ldInst.empty() ? lDevice : ied->second.lDevices.find(ldInst);
+                        const std::string lnType = scl_ln_type(types, (fcdaLDevice == ied->second.lDevices.end()) ? nullptr : fcdaLDevice->second.node,
+                                                               scl_attr(nodeFCDA, "prefix"), scl_attr(nodeFCDA, "lnClass"), scl_attr(nodeFCDA, "lnInst"));
+
+                        TypedValue value{};
+                        std::string error{};
+                        if (scl_fcda_value(types, lnType, scl_attr(nodeFCDA, "doName"), scl_attr(nodeFCDA, "daName"), scl_attr(nodeFCDA, "fc"), value, error))
+                            dataSet.entries.push_back(std::move(value));
+                        else
+                            dataSet.error = std::string(scl_attr(nodeFCDA, "lnClass")) + '.' + std::string(scl_attr(nodeFCDA, "doName"))
+                                            + '.' + std::string(scl_attr(nodeFCDA, "daName")) + ": " + error;
+                    }
+                    dataSets.push_back(std::move(dataSet));
+                }
+            }
+        }
+    }
+    return dataSets;
+}
+
+/* DataSets of the Control Blocks of some IEDs only: their <IED> sections and the <DataTypeTemplates>
+ * are found by scanning the file as text (ref: parse_sed() for one IED), and only they are parsed
+ */
+std::vector<TypedDataSet> typed_datasets(const char *filename, const std::vector<std::string> &ied_names)
+{
+    MappedFile file(filename);
+    const std::string_view text = file.isGood() ? file() : std::string_view{};
+
+    std::string view{"<SCL>"};
+    std::string_view element{};
+    for (size_t pos = 0; scl_next_element(text, pos, "IED", element); )
+    {
+        if (std::find(ied_names.begin(), ied_names.end(), scl_tag_attr(element, "name")) != ied_names.end())
+            view.append(element);
+    }
+    for (size_t pos = 0; scl_next_element(text, pos, "DataTypeTemplates", element); )
+        view.append(element);
+    view.append("</SCL>");
+
+    rapidxml::xml_document<> doc;
+    doc.parse<0>(view.data());
+    return typed_datasets(doc.first_node());
+}
+
+/* Typed DataSets of the R-GOOSE Control Blocks of a view of the SED file (ref: typed_datasets()):
+ * only the <IED> sections of their publishers and the <DataTypeTemplates> are parsed
+ */
+std::vector<TypedDataSet> goose_datasets(const char *filename, const std::vector<ControlBlock> &ctrl_blks)
+{
+    std::vector<std::string> publishers{};
+    for (const ControlBlock &cb : ctrl_blks)
+    {
+        if (cb.cbType == CbType::GSE && std::find(publishers.begin(), publishers.end(), cb.hostIED.view()) == publishers.end())
+            publishers.push_back(cb.hostIED.str());
+    }
+    return publishers.empty() ? std::vector<TypedDataSet>{} : typed_datasets(filename, publishers);
+}
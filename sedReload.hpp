@@ -0,0 +1,310 @@
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/* Subscriptions of ied_recv: the dispatch table of its receive path, and the state kept per subscription
+ * The receive path only reads it through one pointer, owned by the event loop thread. On a reload,
+ * a new table is built from the new SED file and takes the place of the old one (ref: SedReload).
+ */
+struct SubscriptionTable
+{
+    std::vector<GooseSvData>      cbSubscribe{};
+    std::vector<WheelTimer>       talTimers{};          // timeAllowedToLive supervision (linked into the receiver's wheel)
+    std::vector<int>              svStream{};           // index of each R-SV subscription in the alignment buffer (-1 for R-GOOSE)
+    int                           numSvStreams{0};
+    int                           localSubscription{-1};    // 87L: the IED's own R-SV stream (-1 if not received)
+};
+
+/* Subscriptions of ied_name in its view of the SED file: the Control Blocks whose <IEDName> lists it,
+ * then its own first R-SV Control Block if local_sv (87L: the local end of the line).
+ * An R-GOOSE subscription whose DataSet is in dataSets (ref: goose_datasets()) decodes its allData.
+ */
+std::unique_ptr<SubscriptionTable> subscription_table(const std::vector<ControlBlock> &vector_of_ctrl_blks,
+                                                      const char *ied_name, bool local_sv,
+                                                      const std::vector<TypedDataSet> &dataSets = {})
+{
+    std::unique_ptr<SubscriptionTable> table = std::make_unique<SubscriptionTable>();
+    std::vector<GooseSvData> &cbSubscribe = table->cbSubscribe;
+
+    // Find relevant Control Blocks to subscribe to
+    for (const ControlBlock &cb: vector_of_ctrl_blks)
+    {
+        for (Symbol stored_ied: cb.subscribingIEDs)
+        {
+            if (ied_name == stored_ied)
+            {
+                GooseSvData tmp_goose_sv_data{};
+                tmp_goose_sv_data.cbName = cb.cbName.str();
+                tmp_goose_sv_data.cbType = cb.cbType;
+                tmp_goose_sv_data.appID = cb.appID;
+                tmp_goose_sv_data.multicastIP = cb.multicastIP;
+
+                if (cb.cbType == CbType::GSE)
+                {
+                    tmp_goose_sv_data.datSetName = cb.datSetName.str();
+                    tmp_goose_sv_data.datasetPlan = dataset_plan(dataSets, cb);
+                    if (tmp_goose_sv_data.datasetPlan)
+                        tmp_goose_sv_data.datasetValues.resize(tmp_goose_sv_data.datasetPlan->values());
+                }
+
+                cbSubscribe.push_back(tmp_goose_sv_data);
+            }
+        }
+    }
+
+    // 87L: the IED's own R-SV stream (local end of the line) is received too, to be compared with the remote one
+    for (const ControlBlock &cb: vector_of_ctrl_blks)
+    {
+        if (local_sv && table->localSubscription < 0 && cb.hostIED == ied_name && cb.cbType == CbType::SMV)
+        {
+            GooseSvData tmp_sv_data{};
+            tmp_sv_data.cbName = cb.cbName.str();
+            tmp_sv_data.cbType = cb.cbType;
+            tmp_sv_data.appID = cb.appID;
+            tmp_sv_data.multicastIP = cb.multicastIP;
+
+            table->localSubscription = static_cast<int>(cbSubscribe.size());
+            cbSubscribe.push_back(tmp_sv_data);
+        }
+    }
+
+    table->svStream.assign(cbSubscribe.size(), -1);
+    for (size_t i = 0; i < cbSubscribe.size(); i++)
+    {
+        if (cbSubscribe[i].cbType == CbType::SMV)
+            table->svStream[i] = table->numSvStreams++;
+    }
+    return table;
+}
+
+// A subscription is the same stream across a reload only if all of its configuration is the same
+std::string subscription_key(const GooseSvData &cb)
+{
+    return std::string(cb_type_name(cb.cbType)) + '/' + cb.cbName + '/' + appid_string(cb.appID) + '/' + ipv4_string(cb.multicastIP) + '/' + cb.datSetName;
+}
+
+// True if both tables subscribe to the same R-SV streams, in the same order (same alignment buffer layout)
+bool same_sv_streams(const SubscriptionTable &a, const SubscriptionTable &b)
+{
+    std::vector<std::string> keys_a{}, keys_b{};
+    for (const GooseSvData &cb : a.cbSubscribe)
+        if (cb.cbType == CbType::SMV)
+            keys_a.push_back(subscription_key(cb));
+    for (const GooseSvData &cb : b.cbSubscribe)
+        if (cb.cbType == CbType::SMV)
+            keys_b.push_back(subscription_key(cb));
+    return keys_a == keys_b && (a.localSubscription >= 0) == (b.localSubscription >= 0);
+}
+
+// Multicast groups of a table, each once, in order of first subscription
+std::vector<in_addr> multicast_groups(const SubscriptionTable &table)
+{
+    std::vector<in_addr> groups{};
+    std::unordered_set<in_addr_t> seen{};
+    for (const GooseSvData &cb : table.cbSubscribe)
+    {
+        if (seen.insert(cb.multicastIP.s_addr).second)
+            groups.push_back(cb.multicastIP);
+    }
+    return groups;
+}
+
+/* Carries the state of every subscription found in both tables (same key) from old to next: sequence
+ * numbers, counters, metrics (with the latency histogram) and timeAllowedToLive supervision, so that an unchanged stream
+ * is accepted across a reload without re-synchronising. The DataSet types are those of next (the
+ * latest allData is decoded again with them). The timers of next must be created; those of old are
+ * cancelled. Returns the number of subscriptions carried over.
+ */
+size_t carry_over_state(SubscriptionTable &old, SubscriptionTable &next, TimingWheel &wheel)
+{
+    std::unordered_map<std::string, size_t> old_index{};
+    for (size_t i = 0; i < old.cbSubscribe.size(); i++)
+        old_index.emplace(subscription_key(old.cbSubscribe[i]), i);
+
+    size_t carried{0};
+    for (size_t j = 0; j < next.cbSubscribe.size(); j++)
+    {
+        std::unordered_map<std::string, size_t>::iterator found = old_index.find(subscription_key(next.cbSubscribe[j]));
+        if (found == old_index.end())
+            continue;
+        const size_t i = found->second;
+        std::shared_ptr<const DatasetPlan> plan = next.cbSubscribe[j].datasetPlan;
+        next.cbSubscribe[j] = old.cbSubscribe[i];
+        GooseSvData &cb = next.cbSubscribe[j];
+        if (cb.datasetPlan != plan)
+        {
+            cb.datasetPlan = plan;
+            cb.datasetValues.assign(plan ? plan->values() : 0, DataValue{});
+            if (plan)
+                plan->decode(cb.prev_allData_Value.data(), cb.prev_allData_Value.size(), cb.datasetValues.data());
+        }
+        if (old.talTimers[i].armed)
+            wheel.arm(next.talTimers[j], old.talTimers[i].expiry);
+        carried++;
+    }
+
+    for (WheelTimer &timer : old.talTimers)
+        wheel.cancel(timer);
+    return carried;
+}
+
+/* Reload of the SED file while receiving
+ * A reload is requested on SIGHUP, on a change of the SED file (inotify on its directory: written
+ * and closed, or renamed over), or from the control socket. The file is parsed on a thread of its own
+ * (load_sed(), then subscription_table()), so that the receive path keeps running meanwhile; the new
+ * table is published with an atomic pointer store, and the event loop is woken up through an eventfd
+ * to take it (take()) and install it between two batches of datagrams. The loop thread is the only
+ * reader of the table in use, so the old table can be freed as soon as it is replaced, and the
+ * receive path never takes a lock.
+ * A request made while a parse is running starts another parse once it is done.
+ */
+class SedReload {
+  public:
+    SedReload(const char *sed_filename, const char *ied_name, bool local_sv)
+      : m_sed_filename{sed_filename}, m_ied_name{ied_name}, m_local_sv{local_sv} {
+      m_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+      if (m_inotify_fd < 0)
+        return;
+
+      // Editors replace the file rather than write it in place: the directory is watched
+      const size_t slash = m_sed_filename.find_last_of('/');
+      const std::string dir = (slash == std::string::npos) ? "." : m_sed_filename.substr(0, slash + 1);
+      m_basename = (slash == std::string::npos) ? m_sed_filename : m_sed_filename.substr(slash + 1);
+      if (inotify_add_watch(m_inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+      {
+        close(m_inotify_fd);
+        m_inotify_fd = -1;
+      }
+    }
+    ~SedReload() {
+      // make sure the parse thread and the file descriptors don't leak
+      if (m_thread.joinable())
+        m_thread.join();
+      delete m_pending.exchange(nullptr);
+      if (m_event_fd >= 0)
+        close(m_event_fd);
+      if (m_inotify_fd >= 0)
+        close(m_inotify_fd);
+    }
+    // Don't need the other default operations
+    SedReload(const SedReload&) = delete;
+    SedReload& operator=(const SedReload&) = delete;
+    SedReload(SedReload&&) = delete;
+    SedReload& operator=(SedReload&&) = delete;
+
+    bool isGood() const {
+      return m_event_fd >= 0 && m_inotify_fd >= 0;
+    }
+
+    // Readable when a parse is done (then call take())
+    int readyFd() const {
+      return m_event_fd;
+    }
+
+    // Readable when something changed in the SED file's directory (then call fileChanged())
+    int watchFd() const {
+      return m_inotify_fd;
+    }
+
+    // Reads the pending inotify events: true if one of them is about the SED file
+    bool fileChanged() {
+      alignas(inotify_event) char buf[4096];
+      bool changed{false};
+      ssize_t n{};
+      while ((n = read(m_inotify_fd, buf, sizeof(buf))) > 0)
+      {
+        for (char *p = buf; p < buf + n; p += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(p)->len)
+        {
+          const inotify_event *event = reinterpret_cast<inotify_event*>(p);
+          if (event->len && m_basename == event->name)
+            changed = true;
+        }
+      }
+      return changed;
+    }
+
+    // Starts parsing the SED file in the background (or once more after the parse in progress)
+    void request() {
+      if (m_running)
+      {
+        m_again = true;
+        return;
+      }
+      if (m_thread.joinable())
+        m_thread.join();
+      m_running = true;
+      m_thread = std::thread([this]() { parse(); });
+    }
+
+    /* Takes the table of the parse that is done: nullptr if it failed (ref: error())
+     * Called on the event loop thread when readyFd() is readable.
+     */
+    std::unique_ptr<SubscriptionTable> take() {
+      uint64_t count{};
+      if (read(m_event_fd, &count, sizeof(count)) != sizeof(count))
+        return nullptr;
+      m_thread.join();
+      m_running = false;
+      std::unique_ptr<SubscriptionTable> table{m_pending.exchange(nullptr, std::memory_order_acquire)};
+      if (m_again)
+      {
+        m_again = false;
+        request();
+      }
+      return table;
+    }
+
+    bool running() const {
+      return m_running;
+    }
+
+    const std::string& error() const {
+      return m_error;
+    }
+
+  private:
+    // On the parse thread
+    void parse() {
+      std::unique_ptr<SubscriptionTable> table{};
+      m_error.clear();
+      try
+      {
+        // A file that can't be read or isn't SCL (e.g. replaced by an empty file) throws (ref: SclError)
+        std::vector<TypedDataSet> dataSets{};
+        std::vector<ControlBlock> ctrl_blks = load_sed(m_sed_filename.c_str(), m_ied_name.c_str(), dataSets);
+        table = subscription_table(ctrl_blks, m_ied_name.c_str(), m_local_sv, dataSets);
+      }
+      catch (const std::exception &e)
+      {
+        m_error = e.what();
+      }
+      m_pending.store(table.release(), std::memory_order_release);
+
+      const uint64_t one{1};
+      if (write(m_event_fd, &one, sizeof(one)) != sizeof(one))
+        m_error = "cannot wake up the event loop";
+    }
+
+    std::string                     m_sed_filename{};
+    std::string                     m_ied_name{};
+    bool                            m_local_sv{false};
+    std::string                     m_basename{};
+    int                             m_event_fd{-1};
+    int                             m_inotify_fd{-1};
+
+    std::thread                     m_thread{};
+    std::atomic<SubscriptionTable*> m_pending{nullptr};
+    std::string                     m_error{};      // of the last parse (read after join)
+    bool                            m_running{false};
+    bool                            m_again{false};
+};
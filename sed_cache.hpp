@@ -0,0 +1,425 @@
+/* Compiled configuration: binary image of the Control Blocks resolved from a SED file for one IED
+ *
+ * Parsing the SED XML is by far the longest part of a start. The resolved Control Blocks of an IED's
+ * view (ref: parse_sed(filename, ied_name)) and the typed DataSets of its R-GOOSE publishers (ref:
+ * goose_datasets()) are therefore written to an image next to the SED file,
+ * "<SED filename>.<IED name>.cache", keyed by a content hash (XXH64) of the SED file. A restart loads
+ * the image instead, and the XML is parsed again only when the SED file has changed (or the image is
+ * missing, of another version, or damaged).
+ *
+ * Layout (native byte order, every offset from the start of the image), usable in place once mapped:
+ *     SedCacheHeader
+ *     SedCacheCb[num_cbs]
+ *     SedCacheStr[num_list_strs]     datSetVector (4 per FCDA) and subscribingIEDs entries of all Control Blocks
+ *     SedCacheDataSet[num_datasets]
+ *     SedCacheValue[num_values]      entries of every DataSet and members of every structure, each list in a row
+ *     char[strings_size]             bytes of every string (not NUL-terminated), each name once
+ * Every field is checked against the image size when loading, so a truncated or corrupt image
+ * (e.g. written during a crash) is rejected, never read out of bounds.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#define SED_CACHE_VERSION 3
+#define SED_CACHE_MAX_DEPTH 32    // nesting of the structures of a DataSet entry
+
+// A string of the image: bytes [offset, offset + length) of the string area
+struct SedCacheStr
+{
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct SedCacheHeader
+{
+    char        magic[8];               // "SEDCACHE"
+    uint32_t    version;                // SED_CACHE_VERSION
+    uint32_t    byte_order;             // 0x01020304 as written: rejects images from another byte order
+    uint64_t    sed_hash;               // XXH64 of the SED file content
+    uint64_t    sed_size;
+    SedCacheStr ied_name;               // View of this IED
+    uint32_t    num_cbs;
+    uint32_t    num_list_strs;
+    uint64_t    cbs_offset;
+    uint64_t    list_strs_offset;
+    uint32_t    num_datasets;
+    uint32_t    num_values;
+    uint64_t    datasets_offset;
+    uint64_t    values_offset;
+    uint64_t    strings_offset;
+    uint64_t    strings_size;
+};
+
+struct SedCacheCb
+{
+    SedCacheStr hostIED;
+    uint32_t    cbType;                 // CbType
+    uint32_t    multicastIP;            // in_addr (network byte order)
+    uint32_t    appID;
+    SedCacheStr vlanID;
+    SedCacheStr cbName;
+    SedCacheStr datSetName;
+    uint32_t    minTime;
+    uint32_t    maxTime;
+    uint32_t    datSet_first;           // datSetVector: list strings [first, first + 4 * count)
+    uint32_t    datSet_count;           // FCDAs
+    uint32_t    subscribers_first;      // subscribingIEDs: list strings [first, first + count)
+    uint32_t    subscribers_count;
+};
+
+struct SedCacheDataSet
+{
+    SedCacheStr iedName;
+    uint32_t    cbType;                 // CbType
+    SedCacheStr cbName;
+    SedCacheStr datSetName;
+    SedCacheStr error;
+    uint32_t    entries_first;          // entries: values [first, first + count)
+    uint32_t    entries_count;
+};
+
+struct SedCacheValue
+{
+    SedCacheStr name;
+    uint32_t    type;                   // BasicType
+    uint32_t    members_first;          // members of a Struct: values [first, first + count), after this value
+    uint32_t    members_count;
+};
+
+// XXH64 (seed 0) of a byte string: the content hash of a SED file
+uint64_t xxh64(std::string_view data)
+{
+    constexpr uint64_t P1 = 11400714785074694791ULL, P2 = 14029467366897019727ULL, P3 = 1609587929392839161ULL,
+                       P4 = 9650029242287828579ULL, P5 = 2870177450012600261ULL;
+    auto rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+    auto round = [&](uint64_t acc, uint64_t input) { return rotl(acc + input * P2, 31) * P1; };
+    auto read64 = [](const char *p) { uint64_t v; std::memcpy(&v, p, sizeof(v)); return v; };
+    auto read32 = [](const char *p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; };
+
+    const char *p = data.data();
+    const char *const end = p + data.size();
+    uint64_t h{};
+    if (data.size() >= 32)
+    {
+        uint64_t v1 = P1 + P2, v2 = P2, v3 = 0, v4 = 0 - P1;
+        for (; p + 32 <= end; p += 32)
+        {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        for (uint64_t v : {v1, v2, v3, v4})
+            h = (h ^ round(0, v)) * P1 + P4;
+    }
+    else
+    {
+        h = P5;
+    }
+
+    h += data.size();
+    for (; p + 8 <= end; p += 8)
+        h = rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+    if (p + 4 <= end)
+    {
+        h = rotl(h ^ (read32(p) * P1), 23) * P2 + P3;
+        p += 4;
+    }
+    for (; p < end; p++)
+        h = rotl(h ^ (static_cast<unsigned char>(*p) * P5), 11) * P1;
+
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+std::string sed_cache_filename(const char *sed_filename, const char *ied_name)
+{
+    return std::string(sed_filename) + '.' + ied_name + ".cache";
+}
+
+/* Writes the image of an IED's view of a SED file (hash and size of the SED content).
+ * The image is written to a temporary file, then renamed: a reader never sees half an image.
+ */
+bool write_sed_cache(const std::string &cache_filename, uint64_t sed_hash, uint64_t sed_size, const char *ied_name,
+                     const std::vector<ControlBlock> &ctrl_blks, const std::vector<TypedDataSet> &dataSets)
+{
+    std::string strings{};
+    std::unordered_map<SymbolTable::Id, SedCacheStr> added{};
+    auto add = [&](Symbol name)
+    {
+        auto [ref, is_new] = added.try_emplace(name.id, SedCacheStr{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(name.size())});
+        if (is_new)
+            strings.append(name.view());
+        return ref->second;
+    };
+
+    SedCacheHeader header{};
+    std::memcpy(header.magic, "SEDCACHE", sizeof(header.magic));
+    header.version = SED_CACHE_VERSION;
+    header.byte_order = 0x01020304;
+    header.sed_hash = sed_hash;
+    header.sed_size = sed_size;
+    header.ied_name = add(Symbol(ied_name));
+
+    std::vector<SedCacheCb> cbs{};
+    std::vector<SedCacheStr> list_strs{};
+    for (const ControlBlock &cb : ctrl_blks)
+    {
+        SedCacheCb entry{};
+        entry.hostIED = add(cb.hostIED);
+        entry.cbType = static_cast<uint32_t>(cb.cbType);
+        entry.multicastIP = cb.multicastIP.s_addr;
+        entry.appID = cb.appID;
+        entry.vlanID = add(cb.vlanID);
+        entry.cbName = add(cb.cbName);
+        entry.datSetName = add(cb.datSetName);
+        entry.minTime = cb.minTime;
+        entry.maxTime = cb.maxTime;
+        entry.datSet_first = static_cast<uint32_t>(list_strs.size());
+        entry.datSet_count = static_cast<uint32_t>(cb.datSetVector.size());
+        for (const Fcda &item : cb.datSetVector)
+        {
+            for (Symbol part : {item.ied, item.lnClass, item.doName, item.daName})
+                list_strs.push_back(add(part));
+        }
+        entry.subscribers_first = static_cast<uint32_t>(list_strs.size());
+        entry.subscribers_count = static_cast<uint32_t>(cb.subscribingIEDs.size());
+        for (Symbol item : cb.subscribingIEDs)
+            list_strs.push_back(add(item));
+        cbs.push_back(entry);
+    }
+
+    // Each list of values is written in a row, the members of its structures after it
+    std::vector<SedCacheDataSet> sets{};
+    std::vector<SedCacheValue> values{};
+    auto add_values = [&](const std::vector<TypedValue> &list, auto &add_values) -> uint32_t
+    {
+        const size_t first = values.size();
+        for (const TypedValue &value : list)
+            values.push_back(SedCacheValue{add(Symbol(value.name)), static_cast<uint32_t>(value.type), 0, static_cast<uint32_t>(value.members.size())});
+        for (size_t i = 0; i < list.size(); i++)
+        {
+            const uint32_t members_first = add_values(list[i].members, add_values);
+            values[first + i].members_first = members_first;
+        }
+        return static_cast<uint32_t>(first);
+    };
+    for (const TypedDataSet &dataSet : dataSets)
+    {
+        SedCacheDataSet entry{};
+        entry.iedName = add(Symbol(dataSet.iedName));
+        entry.cbType = static_cast<uint32_t>(dataSet.cbType);
+        entry.cbName = add(Symbol(dataSet.cbName));
+        entry.datSetName = add(Symbol(dataSet.datSetName));
+        entry.error = add(Symbol(dataSet.error));
+        entry.entries_first = add_values(dataSet.entries, add_values);
+        entry.entries_count = static_cast<uint32_t>(dataSet.entries.size());
+        sets.push_back(entry);
+    }
+    if (strings.size() > UINT32_MAX || values.size() > UINT32_MAX)
+        return false;
+
+    header.num_cbs = static_cast<uint32_t>(cbs.size());
+    header.num_list_strs = static_cast<uint32_t>(list_strs.size());
+    header.cbs_offset = sizeof(SedCacheHeader);
+    header.list_strs_offset = header.cbs_offset + cbs.size() * sizeof(SedCacheCb);
+    header.num_datasets = static_cast<uint32_t>(sets.size());
+    header.num_values = static_cast<uint32_t>(values.size());
+    header.datasets_offset = header.list_strs_offset + list_strs.size() * sizeof(SedCacheStr);
+    header.values_offset = header.datasets_offset + sets.size() * sizeof(SedCacheDataSet);
+    header.strings_offset = header.values_offset + values.size() * sizeof(SedCacheValue);
+    header.strings_size = strings.size();
+
+    const std::string tmp_filename = cache_filename + ".tmp";
+    {
+        std::ofstream image(tmp_filename, std::ios::binary | std::ios::trunc);
+        image.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        image.write(reinterpret_cast<const char*>(cbs.data()), cbs.size() * sizeof(SedCacheCb));
+        image.write(reinterpret_cast<const char*>(list_strs.data()), list_strs.size() * sizeof(SedCacheStr));
+        image.write(reinterpret_cast<const char*>(sets.data()), sets.size() * sizeof(SedCacheDataSet));
+        image.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(SedCacheValue));
+        image.write(strings.data(), strings.size());
+        if (!image.flush())
+        {
+            std::remove(tmp_filename.c_str());
+            return false;
+        }
+    }
+    return std::rename(tmp_filename.c_str(), cache_filename.c_str()) == 0;
+}
+
+/* Reads the Control Blocks and typed DataSets from an image, if it is valid and was compiled from a SED
+ * file of the given hash and size for ied_name. Returns false otherwise (the SED file must be parsed again).
+ */
+bool read_sed_cache(std::string_view image, uint64_t sed_hash, uint64_t sed_size, const char *ied_name,
+                    std::vector<ControlBlock> &ctrl_blks, std::vector<TypedDataSet> &dataSets)
+{
+    SedCacheHeader header{};
+    if (image.size() < sizeof(header))
+        return false;
+    std::memcpy(&header, image.data(), sizeof(header));
+    if (std::memcmp(header.magic, "SEDCACHE", sizeof(header.magic)) != 0 || header.version != SED_CACHE_VERSION
+        || header.byte_order != 0x01020304 || header.sed_hash != sed_hash || header.sed_size != sed_size)
+        return false;
+
+    // Every table must lie within the image (64-bit arithmetic: no overflow from 32-bit counts)
+    if (header.cbs_offset + uint64_t{header.num_cbs} * sizeof(SedCacheCb) > image.size()
+        || header.list_strs_offset + uint64_t{header.num_list_strs} * sizeof(SedCacheStr) > image.size()
+        || header.datasets_offset + uint64_t{header.num_datasets} * sizeof(SedCacheDataSet) > image.size()
+        || header.values_offset + uint64_t{header.num_values} * sizeof(SedCacheValue) > image.size()
+        || header.strings_offset > image.size() || header.strings_size > image.size() - header.strings_offset)
+        return false;
+
+    // Names are interned once each (the image holds every name once)
+    const char *strings = image.data() + header.strings_offset;
+    std::unordered_map<uint64_t, Symbol> interned{};
+    bool valid = true;
+    auto str = [&](const SedCacheStr &ref)
+    {
+        if (uint64_t{ref.offset} + ref.length > header.strings_size)
+        {
+            valid = false;
+            return Symbol{};
+        }
+        auto [name, is_new] = interned.try_emplace((uint64_t{ref.offset} << 32) | ref.length);
+        if (is_new)
+            name->second = Symbol(std::string_view(strings + ref.offset, ref.length));
+        return name->second;
+    };
+    auto list = [&](uint64_t first, uint64_t count)
+    {
+        std::vector<Symbol> items{};
+        if (first + count > header.num_list_strs)
+        {
+            valid = false;
+            return items;
+        }
+        items.reserve(count);
+        for (uint64_t i = first; i < first + count; i++)
+        {
+            SedCacheStr ref{};
+            std::memcpy(&ref, image.data() + header.list_strs_offset + i * sizeof(SedCacheStr), sizeof(ref));
+            items.push_back(str(ref));
+        }
+        return items;
+    };
+
+    if (str(header.ied_name) != ied_name || !valid)
+        return false;
+
+    std::vector<ControlBlock> loaded(header.num_cbs);
+    for (uint32_t i = 0; i < header.num_cbs && valid; i++)
+    {
+        SedCacheCb entry{};
+        std::memcpy(&entry, image.data() + header.cbs_offset + i * sizeof(SedCacheCb), sizeof(entry));
+        ControlBlock &cb = loaded[i];
+        cb.hostIED = str(entry.hostIED);
+        cb.cbType = static_cast<CbType>(entry.cbType);
+        cb.multicastIP.s_addr = entry.multicastIP;
+        cb.appID = static_cast<uint16_t>(entry.appID);
+        cb.vlanID = str(entry.vlanID);
+        cb.cbName = str(entry.cbName);
+        cb.datSetName = str(entry.datSetName);
+        cb.minTime = entry.minTime;
+        cb.maxTime = entry.maxTime;
+        const std::vector<Symbol> parts = list(entry.datSet_first, uint64_t{entry.datSet_count} * 4);
+        for (size_t p = 0; p + 4 <= parts.size(); p += 4)
+            cb.datSetVector.push_back(Fcda{parts[p], parts[p + 1], parts[p + 2], parts[p + 3]});
+        cb.subscribingIEDs = list(entry.subscribers_first, entry.subscribers_count);
+        if (entry.cbType > static_cast<uint32_t>(CbType::SMV) || entry.appID > UINT16_MAX)
+            valid = false;
+    }
+
+    // Members lie after their structure, so that a corrupt image can't make a value contain itself
+    auto values = [&](uint64_t first, uint64_t count, int64_t after, unsigned int depth, auto &values)
+    {
+        std::vector<TypedValue> items{};
+        if (first + count > header.num_values || (count && static_cast<int64_t>(first) <= after) || depth > SED_CACHE_MAX_DEPTH)
+        {
+            valid = false;
+            return items;
+        }
+        items.reserve(count);
+        for (uint64_t i = first; i < first + count && valid; i++)
+        {
+            SedCacheValue entry{};
+            std::memcpy(&entry, image.data() + header.values_offset + i * sizeof(SedCacheValue), sizeof(entry));
+            if (entry.type > static_cast<uint32_t>(BasicType::Struct))
+                valid = false;
+            TypedValue &value = items.emplace_back();
+            value.name = str(entry.name).str();
+            value.type = static_cast<BasicType>(entry.type);
+            value.members = values(entry.members_first, entry.members_count, static_cast<int64_t>(i), depth + 1, values);
+        }
+        return items;
+    };
+
+    std::vector<TypedDataSet> loaded_sets(header.num_datasets);
+    for (uint32_t i = 0; i < header.num_datasets && valid; i++)
+    {
+        SedCacheDataSet entry{};
+        std::memcpy(&entry, image.data() + header.datasets_offset + i * sizeof(SedCacheDataSet), sizeof(entry));
+        TypedDataSet &dataSet = loaded_sets[i];
+        dataSet.iedName = str(entry.iedName).str();
+        dataSet.cbType = static_cast<CbType>(entry.cbType);
+        dataSet.cbName = str(entry.cbName).str();
+        dataSet.datSetName = str(entry.datSetName).str();
+        dataSet.error = str(entry.error).str();
+        dataSet.entries = values(entry.entries_first, entry.entries_count, -1, 0, values);
+        if (entry.cbType > static_cast<uint32_t>(CbType::SMV))
+            valid = false;
+    }
+    if (!valid)
+        return false;
+    ctrl_blks = std::move(loaded);
+    dataSets = std::move(loaded_sets);
+    return true;
+}
+
+/* Control Blocks of an IED's view of a SED file and the typed DataSets of its R-GOOSE publishers: from the
+ * compiled image if it matches the SED content, otherwise parsed from the XML (ref: parse_sed(filename,
+ * ied_name), goose_datasets()) and compiled for the next start.
+ * Throws SclError if the file can't be read or its Control Blocks can't be (rapidxml::parse_error if it isn't XML).
+ */
+std::vector<ControlBlock> load_sed(const char *filename, const char *ied_name, std::vector<TypedDataSet> &dataSets)
+{
+    MappedFile sed(filename);
+    if (!sed.isGood())
+    {
+        throw SclError("Couldn't read SED file: " + std::string(filename));
+    }
+    const uint64_t sed_hash = xxh64(sed());
+    const uint64_t sed_size = sed().size();
+
+    const std::string cache_filename = sed_cache_filename(filename, ied_name);
+    MappedFile cache(cache_filename.c_str());
+    std::vector<ControlBlock> vector_of_ctrl_blks{};
+    if (cache.isGood() && read_sed_cache(cache(), sed_hash, sed_size, ied_name, vector_of_ctrl_blks, dataSets))
+    {
+        std::cout << "[*] Loaded " << vector_of_ctrl_blks.size() << " Control Block(s) and " << dataSets.size()
+                  << " typed DataSet(s) for IED " << ied_name << " from compiled configuration " << cache_filename << "\n\n";
+        return vector_of_ctrl_blks;
+    }
+
+    std::cout << "[*] No up-to-date compiled configuration " << cache_filename << ": parsing " << filename << '\n';
+    vector_of_ctrl_blks = parse_sed(filename, ied_name);
+    dataSets = goose_datasets(filename, vector_of_ctrl_blks);
+    if (write_sed_cache(cache_filename, sed_hash, sed_size, ied_name, vector_of_ctrl_blks, dataSets))
+        std::cout << "[*] Compiled configuration written to " << cache_filename << "\n\n";
+    else
+        std::cout << "[!] Couldn't write compiled configuration " << cache_filename << " (next start parses the XML again)\n\n";
+    return vector_of_ctrl_blks;
+}
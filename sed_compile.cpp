@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// For parsing SED file (in XML format)
+#include "parse_sed.hpp"
+
+// For the types of the R-GOOSE DataSets, compiled with the Control Blocks
+#include "scl_types.hpp"
+// For the compiled configuration images read by ied_send and ied_recv at start-up
+#include "sed_cache.hpp"
+
+#define DATASET_BATCH 256      // R-GOOSE publishers whose <IED> sections are parsed at once for their DataSet types
+
+/* Compiles a SED file ahead of time: writes the image of the view of each given IED, or of every IED
+ * that publishes or subscribes to a Control Block if none is given (ref: sed_cache.hpp).
+ * The whole file is read once as a stream (ref: parse_sed_stream()), so that memory stays bounded
+ * on SCD files of any size; each view is the Control Blocks the IED publishes or subscribes to, with
+ * the typed DataSets of their R-GOOSE publishers (ref: goose_datasets()), typed DATASET_BATCH
+ * publishers at a time.
+ */
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << (argv[0] ? argv[0] : "sed_compile") << " <SED Filename> [IED Name...]" << '\n';
+        return 1;
+    }
+    const char *sed_filename = argv[1];
+    auto start = std::chrono::steady_clock::now();
+
+    MappedFile sed(sed_filename);
+    if (!sed.isGood())
+    {
+        std::cout << "[!] Couldn't read SED file: " << sed_filename << '\n';
+        return 1;
+    }
+    const uint64_t sed_hash = xxh64(sed());
+    const uint64_t sed_size = sed().size();
+
+    std::streambuf *cout_buf = std::cout.rdbuf(nullptr);    // Progress of every Control Block parsed
+    std::vector<ControlBlock> vector_of_ctrl_blks{};
+    try
+    {
+        vector_of_ctrl_blks = parse_sed_stream(sed_filename);
+    }
+    catch (const std::exception &e)
+    {
+        std::cout.rdbuf(cout_buf);
+        std::cout << "[!] " << e.what() << '\n';
+        return 1;
+    }
+    std::cout.rdbuf(cout_buf);
+
+    std::set<std::string> ied_names{argv + 2, argv + argc};
+    if (ied_names.empty())
+    {
+        for (const ControlBlock &cb : vector_of_ctrl_blks)
+        {
+            ied_names.insert(cb.hostIED.str());
+            for (Symbol subscriber : cb.subscribingIEDs)
+                ied_names.insert(subscriber.str());
+        }
+    }
+
+    // Typed DataSets of every R-GOOSE publisher of the views, by IED
+    std::set<std::string> publishers{};
+    for (const ControlBlock &cb : vector_of_ctrl_blks)
+    {
+        if (cb.cbType == CbType::GSE && (ied_names.count(cb.hostIED.str())
+                                         || std::any_of(cb.subscribingIEDs.begin(), cb.subscribingIEDs.end(),
+                                                        [&](Symbol subscriber) { return ied_names.count(subscriber.str()) > 0; })))
+            publishers.insert(cb.hostIED.str());
+    }
+    std::map<std::string, std::vector<TypedDataSet>> publisher_datasets{};
+    try
+    {
+        for (std::set<std::string>::const_iterator it = publishers.cbegin(); it != publishers.cend(); )
+        {
+            std::vector<std::string> batch{};
+            for (; it != publishers.cend() && batch.size() < DATASET_BATCH; ++it)
+                batch.push_back(*it);
+            for (TypedDataSet &dataSet : typed_datasets(sed_filename, batch))
+                publisher_datasets[dataSet.iedName].push_back(std::move(dataSet));
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << "[!] " << e.what() << '\n';
+        return 1;
+    }
+
+    int failures{0};
+    for (const std::string &ied_name : ied_names)
+    {
+        std::vector<ControlBlock> view{};
+        std::set<std::string> view_publishers{};
+        std::vector<TypedDataSet> dataSets{};
+        for (const ControlBlock &cb : vector_of_ctrl_blks)
+        {
+            if (cb.hostIED == ied_name || std::count(cb.subscribingIEDs.begin(), cb.subscribingIEDs.end(), ied_name))
+            {
+                view.push_back(cb);
+                if (cb.cbType == CbType::GSE && view_publishers.insert(cb.hostIED.str()).second)
+                {
+                    const std::vector<TypedDataSet> &typed = publisher_datasets[cb.hostIED.str()];
+                    dataSets.insert(dataSets.end(), typed.begin(), typed.end());
+                }
+            }
+        }
+
+        const std::string cache_filename = sed_cache_filename(sed_filename, ied_name.c_str());
+        if (write_sed_cache(cache_filename, sed_hash, sed_size, ied_name.c_str(), view, dataSets))
+        {
+            std::cout << "[*] " << cache_filename << ": " << view.size() << " Control Block(s), " << dataSets.size() << " typed DataSet(s)\n";
+        }
+        else
+        {
+            std::cout << "[!] Couldn't write " << cache_filename << '\n';
+            failures++;
+        }
+    }
+
+    std::cout << "[*] Compiled " << ied_names.size() - failures << " IED view(s) of " << sed_filename << " in "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms\n";
+    return failures ? 1 : 0;
+}
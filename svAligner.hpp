@@ -0,0 +1,236 @@
+/* Alignment (jitter) buffer of R-SV streams by smpCnt, for line differential protection
+ *
+ * Samples of the same smpCnt from every subscribed SV stream (local and remote ends of a line)
+ * must be compared together, but they arrive at different times: each remote channel adds its
+ * own network delay. Samples are kept in a ring of SLOTS slots indexed by smpCnt modulo SLOTS
+ * (SLOTS divides the smpCnt wrap, so the index does not jump when smpCnt wraps). A slot is
+ * released, in smpCnt order, as one aligned sample set:
+ *  - as soon as every stream has delivered its sample for that smpCnt, or
+ *  - once the maximum wait has expired since its first sample arrived (set incomplete), or
+ *  - when a sample too far ahead needs the slot (ring overrun, set incomplete).
+ * Samples older than the latest released smpCnt are late and dropped.
+ *
+ * The lag of each stream behind the first arrival of every set is recorded: the spread between
+ * streams is the channel latency asymmetry that the protection has to tolerate.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+class SvAligner {
+  public:
+    static constexpr size_t MAX_STREAMS  = 64;      // one bit per stream in a set
+    static constexpr size_t MAX_CHANNELS = 16;      // values per sample (IEC 61850-9-2 LE: 8)
+
+    // Released sample set: values of stream s are values[s * MAX_CHANNELS ...], if (present >> s) & 1
+    struct AlignedSet
+    {
+        unsigned int    smpCnt{};
+        uint64_t        present{};
+        bool            complete{};
+        const float    *values{nullptr};
+        const uint64_t *arrival_ns{nullptr};        // receive time of each present stream's sample
+    };
+
+    /* streams: number of SV streams to align (<= MAX_STREAMS)
+     * max_wait_ns: how long a set waits for missing streams after its first sample arrived
+     * smpCnt_wrap: smpCnt rolls over to 0 at this value (4000: 50 Hz, 80 samples per cycle)
+     * slots: depth of the ring in samples (a divisor of smpCnt_wrap, < smpCnt_wrap / 2)
+     */
+    SvAligner(size_t streams, uint64_t max_wait_ns, unsigned int smpCnt_wrap = 4000, unsigned int slots = 80)
+      : m_streams{streams}, m_max_wait_ns{max_wait_ns}, m_wrap{smpCnt_wrap}, m_slots{slots},
+        m_all{streams >= 64 ? ~uint64_t{0} : (uint64_t{1} << streams) - 1},
+        m_slot(slots), m_values(static_cast<size_t>(slots) * streams * MAX_CHANNELS),
+        m_arrival(static_cast<size_t>(slots) * streams), m_lag(streams), m_missing(streams), m_late(streams) {}
+    // Histograms are updated in place: keep the aligner in place
+    SvAligner(const SvAligner&) = delete;
+    SvAligner& operator=(const SvAligner&) = delete;
+
+    bool isGood() const {
+      return m_streams > 0 && m_streams <= MAX_STREAMS && m_slots > 0
+          && m_wrap % m_slots == 0 && m_slots < m_wrap / 2;
+    }
+
+    /* Stores the sample of `stream` for smpCnt (count values, at most MAX_CHANNELS are kept),
+     * received at arrival_ns, then calls handler(const AlignedSet&) for every set released.
+     * Returns false if the sample is late or duplicated (dropped).
+     */
+    template <typename Handler>
+    bool push(size_t stream, unsigned int smpCnt, const float *values, size_t count, uint64_t arrival_ns,
+              Handler &&handler) {
+      smpCnt %= m_wrap;
+      if (!m_started)
+      {
+        m_started = true;
+        m_head = smpCnt;
+      }
+
+      unsigned int ahead = distance(m_head, smpCnt);
+      if (ahead >= m_wrap / 2)
+      {
+        // Behind the head: its set has already been released
+        m_late[stream]++;
+        return false;
+      }
+      if (ahead >= m_slots)
+      {
+        if (m_pending == 0)
+        {
+          m_head = (smpCnt + m_wrap - (m_slots - 1)) % m_wrap;
+        }
+        else
+        {
+          // Make room: release (incomplete) or skip the oldest slots
+          for (; ahead >= m_slots; ahead--)
+          {
+            Slot &head = m_slot[m_head % m_slots];
+            if (head.present)
+            {
+              m_overrun++;
+              release(m_head % m_slots, handler);
+            }
+            m_head = (m_head + 1) % m_wrap;
+          }
+        }
+      }
+
+      const unsigned int s = smpCnt % m_slots;
+      Slot &slot = m_slot[s];
+      const uint64_t bit = uint64_t{1} << stream;
+      if (slot.present & bit)
+      {
+        m_duplicated++;
+        return false;
+      }
+      if (!slot.present)
+      {
+        slot.smpCnt = smpCnt;
+        slot.first_ns = arrival_ns;
+        m_pending++;
+      }
+      slot.first_ns = std::min(slot.first_ns, arrival_ns);
+      slot.present |= bit;
+
+      float *dst = &m_values[(static_cast<size_t>(s) * m_streams + stream) * MAX_CHANNELS];
+      count = std::min(count, MAX_CHANNELS);
+      std::memcpy(dst, values, count * sizeof(float));
+      std::fill(dst + count, dst + MAX_CHANNELS, 0.0f);
+      m_arrival[static_cast<size_t>(s) * m_streams + stream] = arrival_ns;
+
+      poll(arrival_ns, handler);
+      return true;
+    }
+
+    /* Releases the sets that are due at now_ns (same clock as the arrival times), in smpCnt order.
+     * Call it when nextDeadline() is reached. Returns the number of sets released.
+     */
+    template <typename Handler>
+    size_t poll(uint64_t now_ns, Handler &&handler) {
+      size_t released = 0;
+      while (m_pending > 0)
+      {
+        // Oldest slot holding samples; empty slots before it are smpCnts nobody delivered (yet)
+        unsigned int skip = 0;
+        while (!m_slot[(m_head + skip) % m_slots].present)
+          skip++;
+        const unsigned int s = (m_head + skip) % m_slots;
+        const Slot &slot = m_slot[s];
+
+        const bool expired = now_ns >= slot.first_ns + m_max_wait_ns;
+        // A complete set still waits for the missing sets before it, up to its own deadline
+        if (!expired && !(skip == 0 && slot.present == m_all))
+          break;
+
+        m_head = (slot.smpCnt + 1) % m_wrap;
+        release(s, handler);
+        released++;
+      }
+      return released;
+    }
+
+    // Receive time at which the oldest pending set expires (false if nothing is pending)
+    bool nextDeadline(uint64_t &deadline_ns) const {
+      if (m_pending == 0)
+        return false;
+      unsigned int skip = 0;
+      while (!m_slot[(m_head + skip) % m_slots].present)
+        skip++;
+      deadline_ns = m_slot[(m_head + skip) % m_slots].first_ns + m_max_wait_ns;
+      return true;
+    }
+
+    size_t   streams() const                       { return m_streams; }
+    uint64_t maxWaitNs() const                     { return m_max_wait_ns; }
+    unsigned int slots() const                     { return m_slots; }
+    uint64_t completeSets() const                  { return m_complete; }
+    uint64_t incompleteSets() const                { return m_incomplete; }
+    uint64_t overrunSets() const                   { return m_overrun; }
+    uint64_t duplicated() const                    { return m_duplicated; }
+    // Lag of a stream's samples behind the first arrival of their set, in ns
+    const LatencyHistogram& lag(size_t stream) const { return m_lag[stream]; }
+    uint64_t missing(size_t stream) const          { return m_missing[stream]; }
+    uint64_t late(size_t stream) const             { return m_late[stream]; }
+
+  private:
+    struct Slot
+    {
+      unsigned int smpCnt{0};
+      uint64_t     present{0};
+      uint64_t     first_ns{0};
+    };
+
+    // Distance from a to b going forward, modulo the smpCnt wrap
+    unsigned int distance(unsigned int a, unsigned int b) const {
+      return (b + m_wrap - a) % m_wrap;
+    }
+
+    template <typename Handler>
+    void release(unsigned int s, Handler &&handler) {
+      Slot &slot = m_slot[s];
+      const uint64_t *arrival = &m_arrival[static_cast<size_t>(s) * m_streams];
+
+      AlignedSet set{};
+      set.smpCnt = slot.smpCnt;
+      set.present = slot.present;
+      set.complete = (slot.present == m_all);
+      set.values = &m_values[static_cast<size_t>(s) * m_streams * MAX_CHANNELS];
+      set.arrival_ns = arrival;
+
+      (set.complete ? m_complete : m_incomplete)++;
+      for (size_t i = 0; i < m_streams; i++)
+      {
+        if (slot.present & (uint64_t{1} << i))
+          m_lag[i].record(static_cast<int64_t>(arrival[i] - slot.first_ns));
+        else
+          m_missing[i]++;
+      }
+
+      handler(set);
+
+      slot.present = 0;
+      m_pending--;
+    }
+
+    size_t                        m_streams;
+    uint64_t                      m_max_wait_ns;
+    unsigned int                  m_wrap;
+    unsigned int                  m_slots;
+    uint64_t                      m_all;            // present mask of a complete set
+
+    std::vector<Slot>             m_slot{};
+    std::vector<float>            m_values{};       // [slot][stream][channel]
+    std::vector<uint64_t>         m_arrival{};      // [slot][stream]
+
+    bool                          m_started{false};
+    unsigned int                  m_head{0};        // oldest smpCnt not released yet
+    size_t                        m_pending{0};     // slots holding samples
+
+    uint64_t                      m_complete{0};
+    uint64_t                      m_incomplete{0};
+    uint64_t                      m_overrun{0};
+    uint64_t                      m_duplicated{0};
+    std::vector<LatencyHistogram> m_lag{};
+    std::vector<uint64_t>         m_missing{};
+    std::vector<uint64_t>         m_late{};
+};
@@ -0,0 +1,295 @@
+/* Interned names of the SCL configuration, and values resolved once when it is read
+ *
+ * Names of IEDs, Control Blocks, DataSets and FCDA parts repeat across every Control Block of a
+ * substation (an IED name in each of its FCDAs and as a subscriber of every Control Block it listens
+ * to, the same lnClass/doName/daName in every DataSet). Each distinct name is stored once in a
+ * process-wide table and referred to by a 32-bit ID (Symbol): two names are equal if their IDs are.
+ * APPID and multicast IPv4 address are kept as numbers, and the Control Block type as an enum, so
+ * that nothing is converted or compared as a string once the SED file has been read.
+ *
+ * Interning takes a lock (one of SHARDS, by hash of the name): it is done while parsing only, and
+ * can be done from several threads (ref: parse_sed()). Reading a name never takes a lock, and its
+ * bytes never move: a view of a Symbol stays valid for the life of the process.
+ */
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+class SymbolTable {
+  public:
+    using Id = uint32_t;
+
+    static constexpr unsigned int SHARDS        = 16;
+    static constexpr size_t       FIRST_SEGMENT = 1024;         // IDs of segment k: 1024 * 2^k of them
+    static constexpr unsigned int SEGMENTS      = 22;           // up to ~4 billion IDs
+    static constexpr size_t       BLOCK_SIZE    = 1u << 12;     // bytes of the names, allocated by blocks
+
+    SymbolTable() {
+      intern(std::string_view{});       // ID 0: the empty name
+    }
+    ~SymbolTable() {
+      for (std::atomic<std::string_view*> &segment : m_segments)
+        delete[] segment.load(std::memory_order_relaxed);
+    }
+    // Don't need the other default operations
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+    SymbolTable(SymbolTable&&) = delete;
+    SymbolTable& operator=(SymbolTable&&) = delete;
+
+    // ID of a name, added to the table if it is not there yet
+    Id intern(std::string_view name) {
+      const size_t hash = std::hash<std::string_view>{}(name);
+      Shard &shard = m_shards[(hash >> 7) % SHARDS];
+      std::lock_guard<std::mutex> lock(shard.mutex);
+
+      std::unordered_map<std::string_view, Id>::const_iterator found = shard.ids.find(name);
+      if (found != shard.ids.end())
+        return found->second;
+
+      const std::string_view stored = shard.store(name);
+      const Id id = m_next.fetch_add(1, std::memory_order_relaxed);
+      slot(id) = stored;
+      shard.ids.emplace(stored, id);
+      return id;
+    }
+
+    /* Name of an ID returned by intern() (on this thread, or handed over with a happens-before,
+     * as any other data). No lock.
+     */
+    std::string_view name(Id id) const {
+      const unsigned int segment = segmentOf(id);
+      return m_segments[segment].load(std::memory_order_acquire)[id - segmentStart(segment)];
+    }
+
+    // Number of distinct names
+    size_t size() const {
+      return m_next.load(std::memory_order_relaxed);
+    }
+
+    // Memory held by the table: names, hash maps and ID segments (approximate)
+    size_t bytes() const {
+      size_t total{0};
+      for (const Shard &shard : m_shards)
+      {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.blocks_bytes
+                 + shard.ids.bucket_count() * sizeof(void*)
+                 + shard.ids.size() * (sizeof(std::pair<std::string_view, Id>) + 2 * sizeof(void*));
+      }
+      for (unsigned int segment = 0; segment < SEGMENTS; segment++)
+      {
+        if (m_segments[segment].load(std::memory_order_relaxed))
+          total += (FIRST_SEGMENT << segment) * sizeof(std::string_view);
+      }
+      return total;
+    }
+
+  private:
+    struct Shard
+    {
+      mutable std::mutex                        mutex{};
+      std::unordered_map<std::string_view, Id>  ids{};
+      std::vector<std::unique_ptr<char[]>>      blocks{};
+      char                                     *current{nullptr};  // block of the small names
+      size_t                                    used{BLOCK_SIZE};   // in the current block
+      size_t                                    blocks_bytes{0};
+
+      // Copy of a name that never moves (a name larger than a quarter of a block gets a block of its own)
+      std::string_view store(std::string_view name) {
+        if (name.empty())
+          return std::string_view{};
+        char *copy{nullptr};
+        if (name.size() > BLOCK_SIZE / 4)
+        {
+          blocks.push_back(std::make_unique<char[]>(name.size()));
+          blocks_bytes += name.size();
+          copy = blocks.back().get();
+        }
+        else
+        {
+          if (BLOCK_SIZE - used < name.size())
+          {
+            blocks.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+            blocks_bytes += BLOCK_SIZE;
+            current = blocks.back().get();
+            used = 0;
+          }
+          copy = current + used;
+          used += name.size();
+        }
+        std::memcpy(copy, name.data(), name.size());
+        return std::string_view(copy, name.size());
+      }
+    };
+
+    static unsigned int segmentOf(Id id) {
+      return 31 - __builtin_clz(static_cast<uint32_t>(id / FIRST_SEGMENT + 1));
+    }
+
+    static size_t segmentStart(unsigned int segment) {
+      return FIRST_SEGMENT * ((size_t{1} << segment) - 1);
+    }
+
+    // Entry of an ID being interned (its segment is allocated by the first ID in it)
+    std::string_view& slot(Id id) {
+      const unsigned int segment = segmentOf(id);
+      std::string_view *entries = m_segments[segment].load(std::memory_order_acquire);
+      if (!entries)
+      {
+        std::lock_guard<std::mutex> lock(m_grow);
+        entries = m_segments[segment].load(std::memory_order_relaxed);
+        if (!entries)
+        {
+          entries = new std::string_view[FIRST_SEGMENT << segment];
+          m_segments[segment].store(entries, std::memory_order_release);
+        }
+      }
+      return entries[id - segmentStart(segment)];
+    }
+
+    std::array<Shard, SHARDS>                             m_shards{};
+    std::array<std::atomic<std::string_view*>, SEGMENTS>  m_segments{};
+    std::atomic<Id>                                       m_next{0};
+    std::mutex                                            m_grow{};
+};
+
+// Table of every name of the SCL configuration in the process
+SymbolTable& scl_symbols()
+{
+    static SymbolTable table{};
+    return table;
+}
+
+// An interned name: 4 bytes, compared by ID
+struct Symbol
+{
+    SymbolTable::Id id{0};
+
+    Symbol() = default;
+    explicit Symbol(std::string_view name) : id{scl_symbols().intern(name)} {}
+
+    std::string_view view() const { return scl_symbols().name(id); }
+    std::string str() const { return std::string(view()); }
+    size_t size() const { return view().size(); }
+    bool empty() const { return id == 0; }
+
+    friend bool operator==(Symbol a, Symbol b) { return a.id == b.id; }
+    friend bool operator!=(Symbol a, Symbol b) { return a.id != b.id; }
+    friend bool operator==(Symbol a, std::string_view b) { return a.view() == b; }
+    friend bool operator!=(Symbol a, std::string_view b) { return a.view() != b; }
+    friend bool operator==(std::string_view a, Symbol b) { return a == b.view(); }
+    friend bool operator!=(std::string_view a, Symbol b) { return a != b.view(); }
+    friend std::ostream& operator<<(std::ostream &out, Symbol symbol) { return out << symbol.view(); }
+};
+
+namespace std
+{
+    template <>
+    struct hash<Symbol>
+    {
+        size_t operator()(Symbol symbol) const { return hash<SymbolTable::Id>{}(symbol.id); }
+    };
+}
+
+// A member of a DataSet (<FCDA>), printed as "IED.lnClass.doName.daName"
+struct Fcda
+{
+    Symbol ied{};
+    Symbol lnClass{};
+    Symbol doName{};
+    Symbol daName{};
+
+    std::string str() const {
+      std::string text{ied.view()};
+      text.append(1, '.').append(lnClass.view()).append(1, '.').append(doName.view()).append(1, '.').append(daName.view());
+      return text;
+    }
+
+    friend bool operator==(const Fcda &a, const Fcda &b) {
+      return a.ied == b.ied && a.lnClass == b.lnClass && a.doName == b.doName && a.daName == b.daName;
+    }
+    friend bool operator!=(const Fcda &a, const Fcda &b) { return !(a == b); }
+    friend std::ostream& operator<<(std::ostream &out, const Fcda &fcda) {
+      return out << fcda.ied << '.' << fcda.lnClass << '.' << fcda.doName << '.' << fcda.daName;
+    }
+};
+
+// Type of a Control Block: element name of its addresses under <ConnectedAP>
+enum class CbType : uint8_t
+{
+    Unknown,
+    GSE,            // R-GOOSE
+    SMV,            // R-SV
+};
+
+CbType cb_type(std::string_view name)
+{
+    return (name == "GSE") ? CbType::GSE : (name == "SMV") ? CbType::SMV : CbType::Unknown;
+}
+
+const char* cb_type_name(CbType type)
+{
+    return (type == CbType::GSE) ? "GSE" : (type == CbType::SMV) ? "SMV" : "";
+}
+
+std::ostream& operator<<(std::ostream &out, CbType type)
+{
+    return out << cb_type_name(type);
+}
+
+// APPID of an <Address> (hexadecimal, as read by strtoul(value, nullptr, 16): 0 if none)
+uint16_t scl_appid(std::string_view value)
+{
+    size_t pos = value.find_first_not_of(" \t\n\r");
+    if (pos == std::string_view::npos)
+        return 0;
+    if (value.size() - pos > 2 && value[pos] == '0' && (value[pos + 1] == 'x' || value[pos + 1] == 'X'))
+        pos += 2;
+    unsigned long appid{0};
+    for (; pos < value.size(); pos++)
+    {
+        const char c = value[pos];
+        const int digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                        : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+        if (digit < 0)
+            break;
+        appid = (appid << 4) | static_cast<unsigned long>(digit);
+    }
+    return static_cast<uint16_t>(appid);
+}
+
+std::string appid_string(uint16_t appid)
+{
+    char text[8];
+    std::snprintf(text, sizeof(text), "%04X", appid);
+    return text;
+}
+
+// Multicast IPv4 address of an <Address> (0.0.0.0 if none or malformed)
+in_addr scl_ipv4(std::string_view value)
+{
+    in_addr address{};
+    if (value.size() < INET_ADDRSTRLEN && inet_pton(AF_INET, std::string(value).c_str(), &address) != 1)
+        address.s_addr = 0;
+    return address;
+}
+
+std::string ipv4_string(in_addr address)
+{
+    char text[INET_ADDRSTRLEN];
+    return inet_ntop(AF_INET, &address, text, sizeof(text)) ? text : "";
+}
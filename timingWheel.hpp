@@ -0,0 +1,232 @@
+/* Hierarchical timing wheel for large numbers of supervision timers
+ *
+ * Time is counted in integer ticks (1 ms for GOOSE timeAllowedToLive supervision).
+ * Level 0 holds 64 slots of 1 tick, level 1 holds 64 slots of 64 ticks, and so on,
+ * so 4 levels cover 64^4 ticks (~4.6 hours at 1 ms). A timer is kept in a doubly
+ * linked list of one slot, hence arming, re-arming and cancelling are O(1)
+ * regardless of the number of timers. Timers in higher levels are cascaded down
+ * when the wheel reaches their slot, and fire from level 0 at their exact tick.
+ *
+ * The wheel does not own a clock: the caller advances it (e.g. from a timerfd armed
+ * at nextExpiry()), so an idle wheel costs no wake-ups at all.
+ */
+#include <array>
+#include <cstdint>
+#include <functional>
+
+// A timer that can be placed in a TimingWheel (storage is owned by the caller)
+struct WheelTimer
+{
+    std::function<void()> on_expiry{};
+    uint64_t              expiry{0};        // tick at which the timer fires
+    bool                  armed{false};
+
+    WheelTimer() = default;
+    explicit WheelTimer(std::function<void()> callback) : on_expiry{std::move(callback)} {}
+
+    // Links belong to the wheel: a copy is never armed
+    WheelTimer(const WheelTimer &other) : on_expiry{other.on_expiry} {}
+    WheelTimer& operator=(const WheelTimer&) = delete;
+
+    WheelTimer  *prev{nullptr};
+    WheelTimer  *next{nullptr};
+    unsigned int level{0};                  // location of the timer in the wheel
+    unsigned int slot{0};
+};
+
+class TimingWheel {
+  public:
+    static constexpr unsigned int SLOT_BITS = 6;
+    static constexpr unsigned int SLOTS     = 1u << SLOT_BITS;
+    static constexpr unsigned int LEVELS    = 4;
+    static constexpr uint64_t     MAX_SPAN  = (uint64_t{1} << (SLOT_BITS * LEVELS)) - 1;
+
+    explicit TimingWheel(uint64_t start_tick = 0) : m_current{start_tick} {}
+
+    // Timers reference the wheel's slots: keep it in place
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    /* Arms (or re-arms) a timer to fire at expiry_tick. O(1). */
+    void arm(WheelTimer &t, uint64_t expiry_tick) {
+      if (t.armed)
+        unlink(t);
+
+      // Expiries in the past fire on the next processed tick; far expiries are clamped
+      if (expiry_tick < m_current)
+        expiry_tick = m_current;
+      if (expiry_tick - m_current > MAX_SPAN)
+        expiry_tick = m_current + MAX_SPAN;
+
+      t.expiry = expiry_tick;
+      t.armed = true;
+      link(t);
+      m_size++;
+    }
+
+    /* Disarms a timer. O(1). */
+    void cancel(WheelTimer &t) {
+      if (!t.armed)
+        return;
+      unlink(t);
+      t.armed = false;
+      m_size--;
+    }
+
+    /* Earliest tick at which advance() has work to do (a timer expiry or a cascade).
+     * Returns false if no timer is armed.
+     */
+    bool nextExpiry(uint64_t &tick_out) const {
+      if (m_size == 0)
+        return false;
+
+      bool found = false;
+      for (unsigned int level = 0; level < LEVELS; level++)
+      {
+        const unsigned int shift = SLOT_BITS * level;
+        const uint64_t block = uint64_t{1} << (shift + SLOT_BITS);
+        const uint64_t base = m_current & ~(block - 1);
+
+        for (uint64_t bits = m_occupied[level]; bits; bits &= bits - 1)
+        {
+          uint64_t tick = base + (static_cast<uint64_t>(__builtin_ctzll(bits)) << shift);
+          if (tick < m_current)
+            tick += block;          // slot belongs to the next turn of this level
+          if (!found || tick < tick_out)
+          {
+            tick_out = tick;
+            found = true;
+          }
+        }
+      }
+      return found;
+    }
+
+    /* Processes every tick up to and including now_tick, firing expired timers.
+     * Empty stretches are skipped, so the cost does not depend on the time elapsed.
+     * Returns the number of timers fired.
+     */
+    size_t advance(uint64_t now_tick) {
+      size_t fired = 0;
+      uint64_t tick{};
+
+      while (m_current <= now_tick)
+      {
+        if (!nextExpiry(tick) || tick > now_tick)
+        {
+          m_current = now_tick + 1;
+          break;
+        }
+        m_current = tick;
+        fired += processTick();
+      }
+      return fired;
+    }
+
+    size_t size() const {
+      return m_size;
+    }
+
+    // Next tick to be processed (all earlier ticks have been processed)
+    uint64_t currentTick() const {
+      return m_current;
+    }
+
+  private:
+    // Level of a timer: the lowest level whose higher-order slot bits match the current tick
+    unsigned int levelOf(uint64_t expiry_tick) const {
+      unsigned int level = 0;
+      while (level < LEVELS - 1
+             && (expiry_tick >> (SLOT_BITS * (level + 1))) != (m_current >> (SLOT_BITS * (level + 1))))
+      {
+        level++;
+      }
+      return level;
+    }
+
+    void link(WheelTimer &t) {
+      if (t.expiry < m_current)
+        t.expiry = m_current;
+
+      t.level = levelOf(t.expiry);
+      t.slot = (t.expiry >> (SLOT_BITS * t.level)) & (SLOTS - 1);
+      WheelTimer *&head = m_slots[t.level][t.slot];
+
+      t.prev = nullptr;
+      t.next = head;
+      if (head)
+        head->prev = &t;
+      head = &t;
+      m_occupied[t.level] |= uint64_t{1} << t.slot;
+    }
+
+    void unlink(WheelTimer &t) {
+      // Timers about to fire in processTick() sit in a separate list (level == LEVELS)
+      WheelTimer *&head = (t.level == LEVELS) ? m_expiring : m_slots[t.level][t.slot];
+
+      if (t.prev)
+        t.prev->next = t.next;
+      else
+        head = t.next;
+      if (t.next)
+        t.next->prev = t.prev;
+      t.prev = t.next = nullptr;
+
+      if (t.level != LEVELS && !head)
+        m_occupied[t.level] &= ~(uint64_t{1} << t.slot);
+    }
+
+    // Detaches the whole list of a slot
+    WheelTimer* takeSlot(unsigned int level, unsigned int slot) {
+      WheelTimer *head = m_slots[level][slot];
+      m_slots[level][slot] = nullptr;
+      m_occupied[level] &= ~(uint64_t{1} << slot);
+      return head;
+    }
+
+    size_t processTick() {
+      const uint64_t tick = m_current;
+
+      // Cascade from the highest level whose slot boundary is reached, down to level 1
+      for (unsigned int level = LEVELS - 1; level >= 1; level--)
+      {
+        if ((tick & ((uint64_t{1} << (SLOT_BITS * level)) - 1)) != 0)
+          continue;
+
+        WheelTimer *t = takeSlot(level, (tick >> (SLOT_BITS * level)) & (SLOTS - 1));
+        while (t)
+        {
+          WheelTimer *next = t->next;
+          link(*t);         // lands in a lower level now that the higher-order bits match
+          t = next;
+        }
+      }
+
+      /* Fire everything due at this tick. Callbacks may re-arm or cancel any timer,
+       * including ones still waiting in m_expiring, so each timer is unlinked right before it fires.
+       */
+      size_t fired = 0;
+      m_expiring = takeSlot(0, tick & (SLOTS - 1));
+      for (WheelTimer *t = m_expiring; t; t = t->next)
+        t->level = LEVELS;
+      m_current = tick + 1;
+
+      while (m_expiring)
+      {
+        WheelTimer *t = m_expiring;
+        unlink(*t);
+        t->armed = false;
+        m_size--;
+        fired++;
+        if (t->on_expiry)
+          t->on_expiry();
+      }
+      return fired;
+    }
+
+    std::array<std::array<WheelTimer*, SLOTS>, LEVELS> m_slots{};
+    std::array<uint64_t, LEVELS>                       m_occupied{};    // bitmap of non-empty slots per level
+    WheelTimer                                        *m_expiring{nullptr};
+    uint64_t                                           m_current{0};
+    size_t                                             m_size{0};
+};
@@ -0,0 +1,79 @@
+/* USDT tracepoints (statically defined tracing) of the encode/send/receive/validate path, provider "ied"
+ *
+ * A tracepoint is a nop in the code plus a note in the ELF section .note.stapsdt that names it and
+ * tells where its arguments are. Nothing is executed beyond the nop (and getting the arguments into
+ * registers) until a tracer attaches, e.g.:
+ *     bpftrace -e 'usdt:./build/ied_recv:ied:deliver { @[arg0] = hist(arg2); }'
+ *     perf buildid-cache --add ./build/ied_recv && perf record -e sdt_ied:encode_end ...
+ *     readelf -n ./build/ied_recv        (list of the tracepoints)
+ * <sys/sdt.h> (systemtap-sdt-dev) is used where installed. Otherwise the same notes are emitted
+ * here on x86-64 and AArch64, with every argument as a 64-bit integer. On other targets the
+ * tracepoints compile to nothing.
+ *
+ * Tracepoints (stream: APPID; spdu: SPDU Number; bytes: UDP payload):
+ *     encode_start(stream, spdu)                   form_udp_data() entered
+ *     encode_end(stream, spdu, bytes)              UDP payload formed
+ *     send(stream, spdu, bytes)                    UDP payload sent (sendto() returned)
+ *     receive(bytes, rx_time_ns)                   datagram handed to the receive path
+ *     dispatch(stream, spdu, bytes)                datagram matched to the subscription of its APPID
+ *     validation_failure(reason, stream, bytes)    datagram rejected (reason: DecodeCheck; stream: 0 if not subscribed)
+ *     deliver(stream, spdu, latency_ns)            message accepted and acted upon
+ */
+#include <cstdint>
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define IED_TRACE_SDT_H
+#endif
+#endif
+
+#if defined(IED_TRACE_SDT_H)
+
+#define IED_TRACE2(name, a1, a2)        STAP_PROBE2(ied, name, static_cast<uint64_t>(a1), static_cast<uint64_t>(a2))
+#define IED_TRACE3(name, a1, a2, a3)    STAP_PROBE3(ied, name, static_cast<uint64_t>(a1), static_cast<uint64_t>(a2), static_cast<uint64_t>(a3))
+
+#elif defined(__x86_64__) || defined(__aarch64__)
+
+/* Note of one tracepoint (format 3 of <sys/sdt.h>): address of the nop, address of the
+ * _.stapsdt.base section (to relocate it), no semaphore, provider, name and arguments
+ */
+#define IED_TRACE_ASM(name, args, ...)                                                          \
+    __asm__ __volatile__("990: nop\n"                                                           \
+                         ".pushsection .note.stapsdt,\"?\",\"note\"\n"                          \
+                         ".balign 4\n"                                                          \
+                         ".4byte 992f-991f, 994f-993f, 3\n"                                     \
+                         "991: .asciz \"stapsdt\"\n"                                            \
+                         "992: .balign 4\n"                                                     \
+                         "993: .8byte 990b\n"                                                   \
+                         ".8byte _.stapsdt.base\n"                                              \
+                         ".8byte 0\n"                                                           \
+                         ".asciz \"ied\"\n"                                                     \
+                         ".asciz \"" #name "\"\n"                                               \
+                         ".asciz \"" args "\"\n"                                                \
+                         "994: .balign 4\n"                                                     \
+                         ".popsection\n"                                                        \
+                         ".ifndef _.stapsdt.base\n"                                             \
+                         ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+                         ".weak _.stapsdt.base\n"                                               \
+                         ".hidden _.stapsdt.base\n"                                             \
+                         "_.stapsdt.base: .space 1\n"                                           \
+                         ".size _.stapsdt.base, 1\n"                                            \
+                         ".popsection\n"                                                        \
+                         ".endif\n"                                                             \
+                         : : __VA_ARGS__)
+
+#define IED_TRACE2(name, a1, a2)        IED_TRACE_ASM(name, "8@%[arg1] 8@%[arg2]",              \
+                                                      [arg1] "nor"(static_cast<uint64_t>(a1)),  \
+                                                      [arg2] "nor"(static_cast<uint64_t>(a2)))
+#define IED_TRACE3(name, a1, a2, a3)    IED_TRACE_ASM(name, "8@%[arg1] 8@%[arg2] 8@%[arg3]",    \
+                                                      [arg1] "nor"(static_cast<uint64_t>(a1)),  \
+                                                      [arg2] "nor"(static_cast<uint64_t>(a2)),  \
+                                                      [arg3] "nor"(static_cast<uint64_t>(a3)))
+
+#else
+
+#define IED_TRACE2(name, a1, a2)        do {} while (0)
+#define IED_TRACE3(name, a1, a2, a3)    do {} while (0)
+
+#endif
@@ -1,3 +1,5 @@
+#include <cstdint>
+#include <linux/sock_diag.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
@@ -24,6 +26,15 @@ class UdpSock {
     bool isGood() const {
       return m_sd >= 0;
     }
+
+    // Datagrams dropped by the kernel because the receive queue was full (receiver overload)
+    uint64_t drops() const {
+      uint32_t meminfo[SK_MEMINFO_VARS]{};
+      socklen_t len = sizeof(meminfo);
+      if (getsockopt(m_sd, SOL_SOCKET, SO_MEMINFO, meminfo, &len) < 0)
+        return 0;
+      return meminfo[SK_MEMINFO_DROPS];
+    }
   private:
     int m_sd = -1;
 };
@@ -0,0 +1,267 @@
+/* Receive from a UDP socket with io_uring: multishot recvmsg and a ring of provided buffers
+ *
+ * A single IORING_OP_RECVMSG request armed with IORING_RECV_MULTISHOT stays active for
+ * every datagram: the kernel picks a buffer from a registered buffer ring (no buffer is
+ * tied to a pending request) and posts one completion per datagram. Under load, user
+ * space only reads completions and gives buffers back through shared memory, so no
+ * system call is made per datagram. The request is re-armed only when the kernel ends it
+ * (e.g. all buffers were in use), and the ring fd can be polled for completions.
+ *
+ * liburing is not required: the rings are set up with the raw system calls.
+ * The socket (not owned) must be bound.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+class UringRecv {
+  public:
+    static constexpr unsigned int SQ_ENTRIES = 4;       // only the multishot request itself is ever submitted
+    static constexpr unsigned int CQ_ENTRIES = 4096;
+    static constexpr unsigned int BUF_COUNT  = 1024;    // provided buffers (power of 2)
+    static constexpr unsigned int BUF_SIZE   = 2048;
+    static constexpr uint16_t     BUF_GROUP  = 0;
+    static constexpr uint64_t     RECV_TAG   = 1;       // user_data of the multishot request
+
+    explicit UringRecv(int sd) : m_sd{sd} {
+      if (!setup())
+        release();
+    }
+    ~UringRecv() {
+      // make sure the rings, buffers and ring fd don't leak
+      release();
+    }
+    // Don't need the other default operations
+    UringRecv(const UringRecv&) = delete;
+    UringRecv& operator=(const UringRecv&) = delete;
+    UringRecv(UringRecv&&) = delete;
+    UringRecv& operator=(UringRecv&&) = delete;
+
+    // The ring fd: readable (EPOLLIN) when completions are waiting
+    int operator()() const {
+      return m_ring_fd;
+    }
+
+    bool isGood() const {
+      return m_ring_fd >= 0;
+    }
+
+    // Number of times the multishot request had to be submitted (1 when never interrupted)
+    uint64_t submissions() const {
+      return m_submissions;
+    }
+
+    /* Calls handler(const unsigned char *udp_payload, int length, in_addr source, uint64_t rx_time_ns)
+     * for each completed datagram, gives the buffers back to the kernel and re-arms the request if it has ended.
+     * rx_time_ns is the kernel's receive timestamp if enabled on the socket (ref: rxTimestamp.hpp).
+     * Returns the number of datagrams handed to the handler.
+     */
+    template <typename Handler>
+    size_t drain(Handler &&handler) {
+      size_t count = 0;
+      bool rearm = false;
+
+      unsigned int head = *m_cq_head;
+      const unsigned int tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+      for (; head != tail; head++)
+      {
+        const io_uring_cqe &cqe = m_cqes[head & m_cq_mask];
+        if (cqe.user_data != RECV_TAG)
+          continue;
+
+        if (cqe.res >= 0 && (cqe.flags & IORING_CQE_F_BUFFER))
+        {
+          const uint16_t bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+          const unsigned char *buf = m_bufs + static_cast<size_t>(bid) * BUF_SIZE;
+
+          // Buffer layout: io_uring_recvmsg_out, source address, control data (timestamp), payload
+          const auto *out = reinterpret_cast<const io_uring_recvmsg_out*>(buf);
+          const size_t hdr_len = sizeof(io_uring_recvmsg_out) + m_msg.msg_namelen + m_msg.msg_controllen;
+          if (static_cast<size_t>(cqe.res) >= hdr_len && !(out->flags & MSG_TRUNC)
+              && out->payloadlen <= cqe.res - hdr_len && out->namelen >= sizeof(sockaddr_in))
+          {
+            sockaddr_in source{};
+            std::memcpy(&source, buf + sizeof(io_uring_recvmsg_out), sizeof(source));
+
+            msghdr control{};
+            control.msg_control    = const_cast<unsigned char*>(buf) + sizeof(io_uring_recvmsg_out) + m_msg.msg_namelen;
+            control.msg_controllen = out->controllen;
+            handler(buf + hdr_len, static_cast<int>(out->payloadlen), source.sin_addr, rx_timestamp_ns(control));
+            count++;
+          }
+          recycleBuffer(bid);
+        }
+
+        if (!(cqe.flags & IORING_CQE_F_MORE))
+          rearm = true;     // request ended (-ENOBUFS when every buffer was in use)
+      }
+      __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+      __atomic_store_n(&m_buf_ring->tail, m_buf_tail, __ATOMIC_RELEASE);
+
+      if (rearm)
+        armRecv();
+      return count;
+    }
+
+  private:
+    static int io_uring_setup(unsigned int entries, io_uring_params *p) {
+      return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+    }
+    static int io_uring_enter(int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags) {
+      return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+    static int io_uring_register(int fd, unsigned int opcode, void *arg, unsigned int nr_args) {
+      return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+    }
+
+    bool setup() {
+      if (m_sd < 0)
+        return false;
+
+      /* Completions are only ever reaped by this thread: no need to interrupt it to run
+       * the kernel's task work (falls back to default flags on kernels without them)
+       */
+      io_uring_params params{};
+      params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+      params.cq_entries = CQ_ENTRIES;
+      m_ring_fd = io_uring_setup(SQ_ENTRIES, &params);
+      if (m_ring_fd < 0 && errno == EINVAL) {
+        params = io_uring_params{};
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = CQ_ENTRIES;
+        m_ring_fd = io_uring_setup(SQ_ENTRIES, &params);
+      }
+      if (m_ring_fd < 0)
+        return false;
+      if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+        return false;       // kernels older than 5.4
+
+      // Submission and completion rings share one mapping, the SQE array has its own
+      m_rings_len = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned int),
+                             params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+      m_rings = mmap(nullptr, m_rings_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     m_ring_fd, IORING_OFF_SQ_RING);
+      if (m_rings == MAP_FAILED)
+        return false;
+      m_sqes_len = params.sq_entries * sizeof(io_uring_sqe);
+      m_sqes = mmap(nullptr, m_sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    m_ring_fd, IORING_OFF_SQES);
+      if (m_sqes == MAP_FAILED)
+        return false;
+
+      auto *rings = static_cast<unsigned char*>(m_rings);
+      m_sq_tail  = reinterpret_cast<unsigned int*>(rings + params.sq_off.tail);
+      m_sq_mask  = *reinterpret_cast<unsigned int*>(rings + params.sq_off.ring_mask);
+      m_sq_array = reinterpret_cast<unsigned int*>(rings + params.sq_off.array);
+      m_cq_head  = reinterpret_cast<unsigned int*>(rings + params.cq_off.head);
+      m_cq_tail  = reinterpret_cast<unsigned int*>(rings + params.cq_off.tail);
+      m_cq_mask  = *reinterpret_cast<unsigned int*>(rings + params.cq_off.ring_mask);
+      m_cqes     = reinterpret_cast<io_uring_cqe*>(rings + params.cq_off.cqes);
+
+      // Buffer ring (page aligned) followed by the buffers themselves
+      m_bufs_len = BUF_COUNT * sizeof(io_uring_buf) + static_cast<size_t>(BUF_COUNT) * BUF_SIZE;
+      void *area = mmap(nullptr, m_bufs_len, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+      if (area == MAP_FAILED)
+        return false;
+      m_buf_ring = static_cast<io_uring_buf_ring*>(area);
+      m_bufs = static_cast<unsigned char*>(area) + BUF_COUNT * sizeof(io_uring_buf);
+
+      io_uring_buf_reg reg{};
+      reg.ring_addr    = reinterpret_cast<uint64_t>(m_buf_ring);
+      reg.ring_entries = BUF_COUNT;
+      reg.bgid         = BUF_GROUP;
+      if (io_uring_register(m_ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+        return false;
+
+      for (unsigned int bid = 0; bid < BUF_COUNT; bid++)
+        recycleBuffer(static_cast<uint16_t>(bid));
+      __atomic_store_n(&m_buf_ring->tail, m_buf_tail, __ATOMIC_RELEASE);
+
+      // Source address and receive timestamp are placed in each buffer, before the payload
+      m_msg = msghdr{};
+      m_msg.msg_namelen    = sizeof(sockaddr_in);
+      m_msg.msg_controllen = RX_TIMESTAMP_CONTROL_LEN;
+      return armRecv();
+    }
+
+    // Hands a buffer (back) to the kernel; published by the tail store in drain()/setup()
+    void recycleBuffer(uint16_t bid) {
+      /* Entries are addressed from the start of the ring: in C++, the uapi header's flexible
+       * array (__DECLARE_FLEX_ARRAY) places io_uring_buf_ring::bufs at offset 8 instead of 0
+       */
+      io_uring_buf &slot = reinterpret_cast<io_uring_buf*>(m_buf_ring)[m_buf_tail & (BUF_COUNT - 1)];
+      slot.addr = reinterpret_cast<uint64_t>(m_bufs + static_cast<size_t>(bid) * BUF_SIZE);
+      slot.len  = BUF_SIZE;
+      slot.bid  = bid;
+      m_buf_tail++;
+    }
+
+    // Submits the multishot recvmsg request
+    bool armRecv() {
+      const unsigned int tail = *m_sq_tail;
+      const unsigned int idx = tail & m_sq_mask;
+
+      io_uring_sqe &sqe = static_cast<io_uring_sqe*>(m_sqes)[idx];
+      std::memset(&sqe, 0, sizeof(sqe));
+      sqe.opcode    = IORING_OP_RECVMSG;
+      sqe.fd        = m_sd;
+      sqe.addr      = reinterpret_cast<uint64_t>(&m_msg);
+      sqe.len       = 1;
+      sqe.msg_flags = MSG_TRUNC;        // report the real length of datagrams that don't fit
+      sqe.ioprio    = IORING_RECV_MULTISHOT;
+      sqe.flags     = IOSQE_BUFFER_SELECT;
+      sqe.buf_group = BUF_GROUP;
+      sqe.user_data = RECV_TAG;
+
+      m_sq_array[idx] = idx;
+      __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+      m_submissions++;
+      return io_uring_enter(m_ring_fd, 1, 0, 0) == 1;
+    }
+
+    void release() {
+      if (m_ring_fd >= 0)
+        close(m_ring_fd);       // cancels the pending request
+      m_ring_fd = -1;
+      if (m_buf_ring)
+        munmap(m_buf_ring, m_bufs_len);
+      if (m_sqes != MAP_FAILED)
+        munmap(m_sqes, m_sqes_len);
+      if (m_rings != MAP_FAILED)
+        munmap(m_rings, m_rings_len);
+      m_buf_ring = nullptr;
+      m_sqes = m_rings = MAP_FAILED;
+    }
+
+    int           m_sd = -1;
+    int           m_ring_fd = -1;
+
+    void         *m_rings = MAP_FAILED;
+    size_t        m_rings_len = 0;
+    void         *m_sqes = MAP_FAILED;
+    size_t        m_sqes_len = 0;
+    unsigned int *m_sq_tail = nullptr;
+    unsigned int  m_sq_mask = 0;
+    unsigned int *m_sq_array = nullptr;
+    unsigned int *m_cq_head = nullptr;
+    unsigned int *m_cq_tail = nullptr;
+    unsigned int  m_cq_mask = 0;
+    io_uring_cqe *m_cqes = nullptr;
+
+    io_uring_buf_ring *m_buf_ring = nullptr;
+    unsigned char     *m_bufs = nullptr;
+    size_t             m_bufs_len = 0;
+    uint16_t           m_buf_tail = 0;
+
+    msghdr        m_msg{};
+    uint64_t      m_submissions = 0;
+};
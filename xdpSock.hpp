@@ -0,0 +1,332 @@
+/* AF_XDP (XSK) receive socket for R-GOOSE/R-SV
+ *
+ * A small XDP program attached to the interface redirects IPv4 UDP datagrams for
+ * IEDUDPPORT into an XSKMAP; every other frame continues up the normal stack
+ * (XDP_PASS). Redirected frames land in a UMEM area shared with user space and are
+ * announced on the RX ring, so the decoder reads them in place.
+ *
+ * Native (driver) mode is tried first, with zero-copy and then copy mode. Where the
+ * driver lacks native XDP support, the program is attached in generic (skb) mode
+ * and the socket uses copy mode.
+ *
+ * No libbpf/libxdp is needed: the program is assembled here and loaded with bpf(2).
+ * Only one RX queue is served (queue 0 by default).
+ */
+#include <cstdint>
+#include <cstring>
+
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+class XdpSock {
+  public:
+    // UMEM geometry: 4096 frames of 2 KiB (aligned chunk mode); rings hold up to 2048 descriptors
+    static constexpr unsigned int NUM_FRAMES = 4096;
+    static constexpr unsigned int FRAME_SIZE = 2048;
+    static constexpr unsigned int RING_SIZE  = 2048;
+
+    XdpSock(const char *ifname, uint16_t udp_port, uint32_t queue_id = 0) : m_queue_id{queue_id} {
+      if (!setup(ifname, udp_port))
+        teardown();
+    }
+    ~XdpSock() {
+      // make sure the socket, rings, UMEM and XDP program don't leak (closing the link detaches the program)
+      teardown();
+    }
+    // Don't need the other default operations
+    XdpSock(const XdpSock&) = delete;
+    XdpSock& operator=(const XdpSock&) = delete;
+    XdpSock(XdpSock&&) = delete;
+    XdpSock& operator=(XdpSock&&) = delete;
+
+    int operator()() const {
+      return m_xsk;
+    }
+
+    bool isGood() const {
+      return m_xsk >= 0;
+    }
+
+    // "native zero-copy", "native copy" or "generic (skb) copy"
+    const char* mode() const {
+      return m_mode;
+    }
+
+    /* Calls handler(const unsigned char *udp_payload, int length, in_addr source, uint64_t rx_time_ns)
+     * for each frame on the RX ring, then gives the frames back to the kernel through the fill ring.
+     * AF_XDP frames carry no kernel timestamp: rx_time_ns is the time the ring is drained.
+     * Returns the number of datagrams handed to the handler.
+     */
+    template <typename Handler>
+    size_t drain(Handler &&handler) {
+      const uint32_t rx_prod = __atomic_load_n(m_rx.producer, __ATOMIC_ACQUIRE);
+      uint32_t rx_cons = *m_rx.consumer;
+      uint32_t fill_prod = *m_fill.producer;
+      size_t count = 0;
+      const uint64_t rx_time_ns = (rx_cons != rx_prod) ? realtime_ns() : 0;
+
+      for (; rx_cons != rx_prod; rx_cons++)
+      {
+        const xdp_desc &desc = static_cast<xdp_desc*>(m_rx.ring)[rx_cons & m_rx.mask];
+        const unsigned char *frame = m_umem + desc.addr;
+
+        // Ethernet header is 14 bytes (the XDP program only redirects untagged IPv4)
+        const unsigned char *payload{};
+        int payload_len{};
+        in_addr source{};
+        if (desc.len > ETH_HLEN && locate_udp_payload(frame + ETH_HLEN, desc.len - ETH_HLEN, payload, payload_len, source))
+        {
+          handler(payload, payload_len, source, rx_time_ns);
+          count++;
+        }
+
+        // Frame is free again (fill ring has room for every UMEM frame, so it cannot overflow)
+        static_cast<uint64_t*>(m_fill.ring)[fill_prod++ & m_fill.mask] = desc.addr & ~static_cast<uint64_t>(FRAME_SIZE - 1);
+      }
+
+      __atomic_store_n(m_rx.consumer, rx_cons, __ATOMIC_RELEASE);
+      __atomic_store_n(m_fill.producer, fill_prod, __ATOMIC_RELEASE);
+      return count;
+    }
+
+    // Frames dropped by the kernel because the RX ring was full or no UMEM frame was free (receiver overload)
+    uint64_t drops() const {
+      xdp_statistics stats{};
+      socklen_t len = sizeof(stats);
+      if (getsockopt(m_xsk, SOL_XDP, XDP_STATISTICS, &stats, &len) < 0)
+        return 0;
+      return stats.rx_dropped + stats.rx_ring_full + stats.rx_fill_ring_empty_descs;
+    }
+
+  private:
+    // Producer/consumer ring shared with the kernel
+    struct Ring {
+      void     *map{MAP_FAILED};
+      size_t    map_len{0};
+      uint32_t *producer{nullptr};
+      uint32_t *consumer{nullptr};
+      void     *ring{nullptr};
+      uint32_t  mask{0};
+    };
+
+    static long sys_bpf(int cmd, bpf_attr &attr) {
+      return syscall(__NR_bpf, cmd, &attr, sizeof(attr));
+    }
+
+    static bpf_insn insn(uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm) {
+      bpf_insn i{};
+      i.code    = code;
+      i.dst_reg = dst;
+      i.src_reg = src;
+      i.off     = off;
+      i.imm     = imm;
+      return i;
+    }
+
+    /* XDP program: redirect IPv4 (no options, not fragmented) UDP datagrams for udp_port
+     * to the XSK of the receiving queue, pass everything else.
+     * Immediates are compared against values loaded in network byte order, hence htons().
+     */
+    int loadProgram(uint16_t udp_port) {
+      const int16_t PASS = 23;      // index of the "pass" instructions below
+      auto to_pass = [&](int pc) { return static_cast<int16_t>(PASS - (pc + 1)); };
+
+      bpf_insn prog[] = {
+        /*  0 */ insn(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0),            // r6 = ctx
+        /*  1 */ insn(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_2, BPF_REG_1, offsetof(xdp_md, data), 0),
+        /*  2 */ insn(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_3, BPF_REG_1, offsetof(xdp_md, data_end), 0),
+        /*  3 */ insn(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0),
+        /*  4 */ insn(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, 14 + 20 + 8),        // Ethernet + IPv4 + UDP headers
+        /*  5 */ insn(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, to_pass(5), 0),
+        /*  6 */ insn(BPF_LDX | BPF_H | BPF_MEM, BPF_REG_5, BPF_REG_2, 12, 0),             // EtherType
+        /*  7 */ insn(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, to_pass(7), htons(ETH_P_IP)),
+        /*  8 */ insn(BPF_LDX | BPF_B | BPF_MEM, BPF_REG_5, BPF_REG_2, 14, 0),             // IPv4 version & IHL
+        /*  9 */ insn(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, to_pass(9), 0x45),
+        /* 10 */ insn(BPF_LDX | BPF_B | BPF_MEM, BPF_REG_5, BPF_REG_2, 23, 0),             // IPv4 protocol
+        /* 11 */ insn(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, to_pass(11), IPPROTO_UDP),
+        /* 12 */ insn(BPF_LDX | BPF_H | BPF_MEM, BPF_REG_5, BPF_REG_2, 20, 0),             // IPv4 flags & fragment offset
+        /* 13 */ insn(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_5, 0, 0, htons(0x3fff)),
+        /* 14 */ insn(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, to_pass(14), 0),
+        /* 15 */ insn(BPF_LDX | BPF_H | BPF_MEM, BPF_REG_5, BPF_REG_2, 36, 0),             // UDP destination port
+        /* 16 */ insn(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, to_pass(16), htons(udp_port)),
+        /* 17 */ insn(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_2, BPF_REG_6, offsetof(xdp_md, rx_queue_index), 0),
+        /* 18 */ insn(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, m_xskmap),
+        /* 19 */ insn(0, 0, 0, 0, 0),
+        /* 20 */ insn(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS),             // if no XSK on this queue
+        /* 21 */ insn(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map),
+        /* 22 */ insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+        /* 23 */ insn(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS),             // pass:
+        /* 24 */ insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+      };
+      static const char license[] = "Dual MIT/GPL";
+
+      bpf_attr attr{};
+      attr.prog_type = BPF_PROG_TYPE_XDP;
+      attr.insns     = reinterpret_cast<uint64_t>(prog);
+      attr.insn_cnt  = sizeof(prog) / sizeof(prog[0]);
+      attr.license   = reinterpret_cast<uint64_t>(license);
+      return static_cast<int>(sys_bpf(BPF_PROG_LOAD, attr));
+    }
+
+    // Attaches the program to the interface through a BPF link (detached when the link fd is closed)
+    int attachProgram(uint32_t xdp_flags) {
+      bpf_attr attr{};
+      attr.link_create.prog_fd        = m_prog;
+      attr.link_create.target_ifindex = m_ifindex;
+      attr.link_create.attach_type    = BPF_XDP;
+      attr.link_create.flags          = xdp_flags;
+      return static_cast<int>(sys_bpf(BPF_LINK_CREATE, attr));
+    }
+
+    bool mapRing(Ring &r, const xdp_ring_offset &off, size_t desc_size, uint64_t pgoff) {
+      r.map_len = off.desc + RING_SIZE * desc_size;
+      r.map = mmap(nullptr, r.map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_xsk, pgoff);
+      if (r.map == MAP_FAILED)
+        return false;
+
+      unsigned char *base = static_cast<unsigned char*>(r.map);
+      r.producer = reinterpret_cast<uint32_t*>(base + off.producer);
+      r.consumer = reinterpret_cast<uint32_t*>(base + off.consumer);
+      r.ring     = base + off.desc;
+      r.mask     = RING_SIZE - 1;
+      return true;
+    }
+
+    bool bindSocket(uint16_t bind_flags) {
+      sockaddr_xdp sxdp{};
+      sxdp.sxdp_family   = AF_XDP;
+      sxdp.sxdp_ifindex  = m_ifindex;
+      sxdp.sxdp_queue_id = m_queue_id;
+      sxdp.sxdp_flags    = bind_flags;
+      return bind(m_xsk, (sockaddr*)&sxdp, sizeof(sxdp)) == 0;
+    }
+
+    bool setup(const char *ifname, uint16_t udp_port) {
+      m_ifindex = if_nametoindex(ifname);
+      if (m_ifindex == 0)
+        return false;
+
+      // UMEM: page-aligned area holding every frame
+      m_umem_len = static_cast<size_t>(NUM_FRAMES) * FRAME_SIZE;
+      void *umem = mmap(nullptr, m_umem_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+      if (umem == MAP_FAILED)
+        return false;
+      m_umem = static_cast<unsigned char*>(umem);
+
+      m_xsk = socket(AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0);
+      if (m_xsk < 0)
+        return false;
+
+      xdp_umem_reg reg{};
+      reg.addr       = reinterpret_cast<uint64_t>(m_umem);
+      reg.len        = m_umem_len;
+      reg.chunk_size = FRAME_SIZE;
+      reg.headroom   = 0;
+      if (setsockopt(m_xsk, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) < 0)
+        return false;
+
+      int ring_size = RING_SIZE;
+      if (   setsockopt(m_xsk, SOL_XDP, XDP_UMEM_FILL_RING, &ring_size, sizeof(ring_size)) < 0
+          || setsockopt(m_xsk, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ring_size, sizeof(ring_size)) < 0
+          || setsockopt(m_xsk, SOL_XDP, XDP_RX_RING, &ring_size, sizeof(ring_size)) < 0)
+        return false;
+
+      xdp_mmap_offsets off{};
+      socklen_t off_len = sizeof(off);
+      if (getsockopt(m_xsk, SOL_XDP, XDP_MMAP_OFFSETS, &off, &off_len) < 0)
+        return false;
+      if (   !mapRing(m_rx, off.rx, sizeof(xdp_desc), XDP_PGOFF_RX_RING)
+          || !mapRing(m_fill, off.fr, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING)
+          || !mapRing(m_comp, off.cr, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING))
+        return false;
+
+      // Hand the first RING_SIZE frames to the kernel (the rest are never needed with this ring size)
+      for (uint32_t i = 0; i < RING_SIZE; i++)
+        static_cast<uint64_t*>(m_fill.ring)[i] = static_cast<uint64_t>(i) * FRAME_SIZE;
+      __atomic_store_n(m_fill.producer, RING_SIZE, __ATOMIC_RELEASE);
+
+      // XSKMAP: queue index -> XSK
+      bpf_attr map_attr{};
+      map_attr.map_type    = BPF_MAP_TYPE_XSKMAP;
+      map_attr.key_size    = sizeof(uint32_t);
+      map_attr.value_size  = sizeof(uint32_t);
+      map_attr.max_entries = 64;
+      m_xskmap = static_cast<int>(sys_bpf(BPF_MAP_CREATE, map_attr));
+      if (m_xskmap < 0)
+        return false;
+
+      m_prog = loadProgram(udp_port);
+      if (m_prog < 0)
+        return false;
+
+      // Native mode first (zero-copy, then copy), generic (skb) mode with copying as the fallback
+      m_link = attachProgram(XDP_FLAGS_DRV_MODE);
+      if (m_link >= 0 && bindSocket(XDP_ZEROCOPY))
+        m_mode = "native zero-copy";
+      else if (m_link >= 0 && bindSocket(XDP_COPY))
+        m_mode = "native copy";
+      else
+      {
+        if (m_link >= 0)
+          close(m_link);
+        m_link = attachProgram(XDP_FLAGS_SKB_MODE);
+        if (m_link < 0 || !bindSocket(XDP_COPY))
+          return false;
+        m_mode = "generic (skb) copy";
+      }
+
+      uint32_t key = m_queue_id;
+      uint32_t value = m_xsk;
+      bpf_attr upd{};
+      upd.map_fd = m_xskmap;
+      upd.key    = reinterpret_cast<uint64_t>(&key);
+      upd.value  = reinterpret_cast<uint64_t>(&value);
+      upd.flags  = BPF_ANY;
+      return sys_bpf(BPF_MAP_UPDATE_ELEM, upd) == 0;
+    }
+
+    void teardown() {
+      for (int *fd : {&m_link, &m_prog, &m_xskmap, &m_xsk})
+      {
+        if (*fd >= 0)
+          close(*fd);
+        *fd = -1;
+      }
+      for (Ring *r : {&m_rx, &m_fill, &m_comp})
+      {
+        if (r->map != MAP_FAILED)
+          munmap(r->map, r->map_len);
+        r->map = MAP_FAILED;
+      }
+      if (m_umem)
+        munmap(m_umem, m_umem_len);
+      m_umem = nullptr;
+    }
+
+    int            m_xsk = -1;
+    int            m_xskmap = -1;
+    int            m_prog = -1;
+    int            m_link = -1;
+    int            m_ifindex = 0;
+    uint32_t       m_queue_id = 0;
+    const char    *m_mode = "none";
+    unsigned char *m_umem = nullptr;
+    size_t         m_umem_len = 0;
+    Ring           m_rx{};
+    Ring           m_fill{};
+    Ring           m_comp{};
+};